@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include "chess/bitboard.hpp"
 
 namespace chess {
@@ -20,4 +21,17 @@ inline Bitboard attacks_queen(Square s, Bitboard occ_all){
     return attacks_bishop(s, occ_all) | attacks_rook(s, occ_all);
 }
 
+// ---- batched: whole-position attack summaries for many positions at once ----
+struct AttackInfo {
+    Bitboard attacks[2];  // squares attacked by each colour (pawns, pieces, king)
+    Bitboard checkers[2]; // pieces of the other colour attacking colour c's king
+    uint16_t mobility[2]; // knight/bishop/rook/queen moves onto squares not held by own pieces
+};
+
+// Kogge-Stone fills over 4 positions per AVX2 register when the library is built with
+// AVX2, one position at a time otherwise (and for the tail). Needs no init_attacks().
+void batch_attacks(const Bitboards* pos, AttackInfo* out, size_t n);
+void batch_attacks_scalar(const Bitboards* pos, AttackInfo* out, size_t n); // reference path
+bool batch_attacks_simd(); // true if batch_attacks uses AVX2
+
 } // namespace chess
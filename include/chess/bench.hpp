@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include "chess/search_bb.hpp"
+
+namespace chess {
+
+// Fixed-depth search over a fixed position set. Node counts depend only on
+// search behaviour, so `signature` flags functional changes while `nps`
+// tracks speed.
+constexpr int BENCH_DEPTH = 4;
+
+struct BenchResult {
+    int positions = 0;
+    uint64_t nodes = 0;
+    double ms = 0.0;
+    uint64_t nps = 0;
+    uint64_t signature = 0; // order-sensitive hash of per-position nodes + best moves
+    SearchStats stats;      // merged over all positions (CHESS_SEARCH_STATS builds)
+};
+
+// log (optional) receives one line per position
+BenchResult run_bench(int depth = BENCH_DEPTH, std::ostream* log = nullptr);
+
+} // namespace chess
@@ -0,0 +1,14 @@
+#pragma once
+#include "chess/board_bb.hpp"
+
+namespace chess::bitbase {
+
+// Exact win/draw tables for KPK, KRK and KQK, built by retrograde analysis on the
+// first probe (or by init()); one bit per position, both sides to move.
+void init(); // idempotent, thread-safe; needs init_attacks()
+
+// Covered: king + one pawn/rook/queen against a lone king, no castling rights.
+// Sets strong to the side with the extra piece and wins to whether it can force a win.
+bool probe(const BoardBB& pos, Color& strong, bool& wins);
+
+} // namespace chess::bitbase
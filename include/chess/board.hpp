@@ -1,5 +1,4 @@
 #pragma once
-#include <memory>
 #include <utility>
 #include <vector>
 #include "chess/types.hpp"
@@ -7,13 +6,17 @@
 
 namespace chess {
 
+// (dr,dc) steps shared by move generation and attack detection
+inline constexpr int KNIGHT_STEPS[8][2] = {{1,2},{2,1},{2,-1},{1,-2},{-1,-2},{-2,-1},{-2,1},{-1,2}};
+inline constexpr int KING_STEPS[8][2]   = {{1,0},{1,1},{0,1},{-1,1},{-1,0},{-1,-1},{0,-1},{1,-1}};
+inline constexpr int DIAG_STEPS[4][2]   = {{1,1},{1,-1},{-1,1},{-1,-1}};
+inline constexpr int ORTH_STEPS[4][2]   = {{1,0},{-1,0},{0,1},{0,-1}};
+
 class Board {
 public:
-    std::unique_ptr<Piece> board[ROWS][COLS];
+    Piece board[ROWS][COLS]{};   // byte-per-square mailbox; plain value copy
+    int8_t king_sq[2]{-1, -1};   // r*8+c per color, -1 if absent; kept in sync by Game
 
-    Board() = default;
-    Board(const Board& other);
-    Board& operator=(const Board& other);
 
     void create_board();
     void set_major_pieces(Color color, int row);
@@ -26,6 +29,8 @@ public:
 
     bool path_clear(int r0,int c0,int r1,int c1) const;
     std::pair<int,int> king_pos(Color col) const;
+    void set_king(Color col, int r, int c) { king_sq[col==Color::Black] = int8_t(r*8 + c); }
+    void locate_kings(); // rebuild king_sq after editing board[][] directly
     bool attacks_square(Color attacker, int r, int c) const;
 
     void clear();
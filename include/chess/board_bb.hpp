@@ -1,6 +1,9 @@
 #pragma once
+#include <cassert>
+#include <cstddef>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "chess/bitboard.hpp"
 #include "chess/move.hpp"
 
@@ -9,37 +12,111 @@ namespace chess {
 // Castling rights bitfield: 0..3 = KQkq
 enum Castle : uint8_t { CR_WK=1<<0, CR_WQ=1<<1, CR_BK=1<<2, CR_BQ=1<<3 };
 
-// map Color to array index
+// map Color to array index (White=0, Black=1). None is never a valid index; the hint
+// lets the compiler drop that path instead of warning about it after inlining.
 inline constexpr int ci(Color c) {
-    return (c == Color::White) ? 0 : (c == Color::Black ? 1 : -1);
+    assert(c != Color::None);
+#if defined(__GNUC__)
+    if (static_cast<unsigned>(c) > 1) __builtin_unreachable();
+#endif
+    return static_cast<int>(c);
 }
 
+// What generate_moves produces. Captures include every promotion; Quiets are the rest
+// (castles included). Evasions is meant for positions in check: king moves plus, in
+// single check, moves that capture the checker or block it.
+enum class GenType : uint8_t { All, Captures, Quiets, Evasions };
+
+// Undo record: what do_move cannot recompute (16 bytes, trivially copyable)
 struct State {
-    uint8_t castling{};
-    int8_t  ep_sq{-1};       // -1 if none, else 0..63
-    uint8_t halfmove{};
-    uint8_t captured{NO_PIECE};
-    // For undo
-    uint8_t moved_piece{NO_PIECE};
-    uint8_t moved_from{}, moved_to{};
-    uint8_t promo_to{NO_PIECE};
+    uint64_t key;            // Zobrist key of the position before the move (repetition history)
+    uint16_t halfmove;
+    Move     move;
+    uint8_t  castling;
+    int8_t   ep_sq;          // -1 if none, else 0..63
+    uint8_t  moved;          // PieceType that moved (PAWN for promotions)
+    uint8_t  captured;       // PieceType or NO_PIECE
 };
+static_assert(sizeof(State) == 16);
+
+// Fixed ring of undo records, newest last: do_move never allocates. Pushing past
+// CAPACITY forgets the oldest record, which only shortens the history that undo and
+// repetition checks can see; the 50-move window (<= 100 plies in practice) plus
+// MAX_PLY search plies fits. Copies take only the live records.
+class StateStack {
+public:
+    static constexpr int CAPACITY = 256;
+
+    StateStack() = default;
+    StateStack(const StateStack& o) { *this = o; }
+    StateStack& operator=(const StateStack& o) { assign_tail(o, o.size()); return *this; }
+
+    void clear() { n_ = base_ = 0; }
+    void push_back(const State& s) {
+        buf_[n_++ & MASK] = s;
+        if (n_ - base_ > uint32_t(CAPACITY)) ++base_;
+    }
+    void pop_back() { --n_; }
+    const State& back() const { return buf_[(n_ - 1) & MASK]; }
+    size_t size() const { return n_ - base_; }
+    bool empty() const { return n_ == base_; }
+    const State& operator[](size_t i) const { return buf_[(base_ + i) & MASK]; } // 0 = oldest kept
+    // keep only the newest n records of o (n <= o.size())
+    void assign_tail(const StateStack& o, size_t n) {
+        n_ = o.n_; base_ = o.n_ - uint32_t(n);
+        for (uint32_t i = base_; i != n_; ++i) buf_[i & MASK] = o.buf_[i & MASK];
+    }
+
+private:
+    static constexpr uint32_t MASK = CAPACITY - 1;
+    static_assert((CAPACITY & MASK) == 0);
+    State buf_[CAPACITY];
+    uint32_t n_ = 0, base_ = 0;
+};
+
+// Result of BoardBB::parse_fen
+enum class FenError : uint8_t {
+    Ok, MissingField, TrailingData, BadPiece, BadRankLength, BadRankCount,
+    BadSide, BadCastling, BadEnPassant, BadClock, KingCount, TooManyPieces, PawnOnBackRank
+};
+const char* to_cstr(FenError e);
+
+// Longest FEN write_fen can produce (71 placement chars + 22 for the other fields) plus NUL
+constexpr size_t FEN_BUF_SIZE = 96;
+
+// 32-byte binary position for bulk storage (FEN stays the interchange format).
+// Layout, multi-byte fields little-endian:
+//   [0..7]   occupancy bitboard
+//   [8..23]  4-bit codes (color<<3 | PieceType) for occupied squares in A1..H8 order, low nibble first
+//   [24]     side (bit 0) | castling KQkq (bits 1-4)
+//   [25]     ep square, 0xFF if none
+//   [26..27] halfmove clock   [28..29] fullmove number   [30..31] zero
+struct PackedPos {
+    uint8_t data[32]{};
+    bool operator==(const PackedPos& o) const;
+};
+static_assert(sizeof(PackedPos) == 32);
 
 class BoardBB {
 public:
     Bitboards bb;
     Color side{WHITE};
     uint8_t castling{CR_WK|CR_WQ|CR_BK|CR_BQ};
-    int8_t ep_sq{-1};                  // en-passant target square (move-to square)
+    int8_t ep_sq{-1};                  // en-passant target square, only if a pawn can capture on it
     uint16_t halfmove{0}, fullmove{1}; // 50-move + ply count
-    std::vector<State> stack;          // simple state stack
+    uint64_t key{0};                   // Zobrist key, kept incrementally by do_move
+    StateStack stack;                  // undo records; State::key is the position history
 
     // --- construction / IO ---
     BoardBB();
     void clear();
     void set_startpos();
-    bool set_fen(const std::string& fen);
+    FenError parse_fen(std::string_view fen);      // no allocation; validates kings, counts, EP
+    bool set_fen(const std::string& fen);           // parse_fen(fen)==FenError::Ok
+    size_t write_fen(char* out, size_t cap) const;  // NUL-terminated; returns length, 0 if cap < FEN_BUF_SIZE
     std::string to_fen() const;
+    bool encode(PackedPos& out) const; // false if more than 32 pieces
+    bool decode(const PackedPos& in);  // false on malformed input; history is cleared
 
     // --- queries ---
     inline Bitboard occ_side(Color c) const { return bb.occ[ci(c)]; }
@@ -52,15 +129,39 @@ public:
     // --- move plumbing ---
     void do_move(Move m);
     void undo_move();
+    // Copy-make: become parent + m. Only the history that repetition checks can still
+    // reach (the last parent.halfmove records) is copied, so this cannot be undone.
+    void copy_make(const BoardBB& parent, Move m);
 
     // --- generation ---
-    void generate_moves(std::vector<Move>& out) const; // pseudo-legal
-    void generate_legal_moves(std::vector<Move>& out); // filtered
+    void generate_moves(std::vector<Move>& out, GenType type = GenType::All) const; // pseudo-legal
+    void generate_moves(MoveList& out, GenType type = GenType::All) const;          // same, no heap
+    void generate_legal_moves(std::vector<Move>& out); // filtered (evasions when in check)
+    // Pseudo-legal m does not leave our king attacked; decided on the bitboards, without
+    // do_move, so it works on a const board
+    bool is_legal(Move m) const;
+    int count_legal_moves() const; // generate_legal_moves(...).size() without the copy
 
     // --- attack helpers ---
     bool square_attacked(Square s, Color by) const;
+    Bitboard attackers_to(Square s, Color by) const;
+
+    // --- draw detection (ply = distance from the search root) ---
+    uint64_t compute_key() const; // from scratch; equals key
+    // The position occurred before: once since the root, or twice in the game before it.
+    // Only the last `halfmove` plies can hold a repeat.
+    bool is_repetition(int ply) const;
+    // Some reversible move of the side to move returns to a position seen since the
+    // root (cuckoo tables of single piece moves); the draw score is then within reach.
+    bool has_upcoming_repetition(int ply) const;
 
 private:
+    // side-specific bodies: colour branches and pawn directions resolve at compile time
+    template<Color Us, GenType Type, class List> void generate(List& out) const;
+    template<class List> void generate_any(List& out, GenType type) const;
+    template<Color By> bool attacked_by(Square s) const;
+    template<Color Us> void do_move_as(Move m);
+
     void put_piece(Color c, PieceType p, Square s);
     void remove_piece(Color c, PieceType p, Square s);
     void move_piece(Color c, PieceType p, Square from, Square to);
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "chess/board_bb.hpp"
+
+namespace chess {
+
+// Outside the bitbase endings eval_bb is linear: the sum of weight * feature over the
+// terms below, each feature counted for White minus Black (White's view).
+enum EvalTerm : int {
+    TERM_PIECE = 0,                 // + PAWN..QUEEN: material
+    TERM_MOBILITY = TERM_PIECE + 5, // legal moves of the side to move (negative for Black)
+    TERM_BISHOP_PAIR,
+    TERM_PST,                       // + 64*piece type + square, Black's squares mirrored
+    EVAL_TERM_COUNT = TERM_PST + 6 * 64
+};
+
+struct EvalWeights {
+    int16_t w[EVAL_TERM_COUNT];
+};
+
+// One non-zero feature of a position
+struct EvalFeature {
+    uint16_t term;
+    int16_t count;
+};
+
+// The weights eval_bb uses (DEFAULT_EVAL_WEIGHTS of chess/eval_weights.hpp until set).
+// Set them before searching; running searches are not synchronised with the change.
+// SearchLimits::weights overrides them for one search, on the searching thread only.
+const EvalWeights& eval_weights();
+void set_eval_weights(const EvalWeights& w);
+
+// Weights in the layout of chess/eval_weights.hpp (as chess_tune writes them): the
+// EVAL_TERM_COUNT numbers between the first "{{" and the closing brace, // comments
+// allowed. False, out untouched, on any other count or a value outside int16_t.
+bool parse_eval_weights(std::string_view text, EvalWeights& out);
+
+// Features of pos in term order, so that eval_bb(pos) == sum of w[term] * count.
+// False (out cleared) for positions eval_bb scores from the bitbases.
+bool eval_features(const BoardBB& pos, std::vector<EvalFeature>& out);
+
+} // namespace chess
@@ -4,6 +4,7 @@
 #include <optional>
 #include "chess/types.hpp"
 #include "chess/board.hpp"
+#include "chess/move.hpp"
 
 namespace chess {
 
@@ -24,15 +25,21 @@ class Game {
 
     bool can_castle_king_side(Color) const;
     bool can_castle_queen_side(Color) const;
-    void do_castle_king_side(Color);
-    void do_castle_queen_side(Color);
-    void maybe_promote(int r1,int c1);
+    void maybe_promote(int r1,int c1, PieceType promo);
     bool has_any_legal_move(Color);
+    bool gen_moves(Color col, MoveList* out);
 
 public:
+    // Everything make_move changes, so unmake_move can restore it exactly
+    struct Undo {
+        Piece moved, captured, rook;       // pieces as they stood before the move
+        int8_t r0{}, c0{}, r1{}, c1{};
+        int8_t cap_r{}, cap_c{};           // captured square (behind the target for EP)
+        int8_t rook_c0{-1}, rook_c1{-1};   // castling rook columns, -1 if not castling
+        EP ep;                             // en-passant state before the move
+    };
+
     Game();
-    Game(const Game&);
-    Game& operator=(const Game&);
 
     void print() const;
     const Board& get_board() const { return b; }
@@ -41,9 +48,18 @@ public:
     bool parse_move(const std::string&, int& r0,int& c0,int& r1,int& c1, char& pieceLetter);
     bool move(const std::string& input, std::string& errmsg);
 
+    // Reversible, unchecked move for search: m must come from legal_moves(MoveList&).
+    // Squares are r*8+c; promotions take the piece from the MF_PROMO_* flag.
+    void make_move(Move m, Undo& u);
+    void unmake_move(const Undo& u);
+    void apply(Move m) { Undo u; make_move(m, u); }
+
     bool is_checkmate(Color);
     bool is_stalemate(Color);
+    void legal_moves(MoveList& out);
+    // "rc rc" strings for display/CLI; promotions appear once (as the queen move)
     std::vector<std::string> legal_moves();
+    static std::string format_move(Move m);
 
     bool load_fen(const std::string& fen, std::string& errmsg);
     bool load_startpos();
@@ -56,6 +72,9 @@ public:
     void loop_with_strategies(Strategy* white, Strategy* black);
 
     void loop();
+
+private:
+    void make_move(int r0,int c0,int r1,int c1, PieceType promo, Undo& u);
 };
 
 } // namespace chess
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace chess {
+
+// Read-only view of a whole input file. Regular files are memory-mapped; pipes,
+// "-" (stdin) and platforms without mmap are read into memory in large chunks.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, bool sequential = true) { open(path, sequential); }
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false if the file cannot be read; sequential=false for lookups (no read-ahead)
+    bool open(const std::string& path, bool sequential = true);
+    void close();
+
+    bool is_open() const { return open_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+    bool mapped_ = false;
+    std::string buf_; // fallback storage
+};
+
+// Iterates the lines of a buffer without copying; strips a trailing '\r'.
+class LineCursor {
+public:
+    explicit LineCursor(std::string_view text) : text_(text) {}
+    bool next(std::string_view& line);
+    size_t line_no() const { return line_no_; } // 1-based number of the last line returned
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0, line_no_ = 0;
+};
+
+} // namespace chess
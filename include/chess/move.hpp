@@ -8,18 +8,41 @@ enum MoveFlag : uint8_t {
     MF_PROMO_N=4, MF_PROMO_B=5, MF_PROMO_R=6, MF_PROMO_Q=7
 };
 
-// 32-bit packed move: [ .. | promo(3) | flag(3) | to(6) | from(6) ]
+// 16-bit packed move: [ flag(3) | to(6) | from(6) ]; promotions are flags PROMO_N..Q
 struct Move {
-    uint32_t v{0};
+    uint16_t v{0};
     Move() = default;
-    Move(uint8_t from, uint8_t to, uint8_t flag, uint8_t promo=0)
-      : v( (from) | (uint32_t(to)<<6) | (uint32_t(flag)<<12) | (uint32_t(promo)<<15) ) {}
+    Move(uint8_t from, uint8_t to, uint8_t flag)
+      : v( uint16_t(from | (to<<6) | (flag<<12)) ) {}
 
     uint8_t from()  const { return  v        & 63; }
     uint8_t to()    const { return (v >> 6)  & 63; }
     uint8_t flag()  const { return (v >> 12) &  7; }
-    uint8_t promo() const { return (v >> 15) &  7; }
     bool is_capture() const { return flag()==MF_CAPTURE || flag()==MF_EP; }
+    bool is_promo()   const { return flag()>=MF_PROMO_N; }
+    bool operator==(Move o) const { return v==o.v; }
+    bool operator!=(Move o) const { return v!=o.v; }
+};
+static_assert(sizeof(Move) == 2);
+
+// Fixed-capacity move buffer (no heap); no legal position has more than 218 moves
+constexpr int MAX_MOVES = 256;
+
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int count = 0;
+
+    void clear() { count = 0; }
+    void push(Move m) { moves[count++] = m; }
+    void emplace_back(uint8_t from, uint8_t to, uint8_t flag) { push(Move(from, to, flag)); } // as std::vector
+    int  size()  const { return count; }
+    bool empty() const { return count==0; }
+    Move operator[](int i) const { return moves[i]; }
+
+    Move*       begin()       { return moves; }
+    Move*       end()         { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end()   const { return moves + count; }
 };
 
 } // namespace chess
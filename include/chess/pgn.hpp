@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "chess/board_bb.hpp"
+
+namespace chess {
+
+enum class GameResult : uint8_t { Unknown, WhiteWin, BlackWin, Draw };
+const char* to_cstr(GameResult r); // "1-0", "0-1", "1/2-1/2", "*"
+
+// Receives games from PgnReader; override what you need.
+struct PgnVisitor {
+    virtual ~PgnVisitor() = default;
+    virtual void begin_game() {}
+    // value is the raw text between the quotes (escapes left in place)
+    virtual void header(std::string_view /*name*/, std::string_view /*value*/) {}
+    // pos is the position before move; result is the game's Result tag (Unknown if absent)
+    virtual void ply(const BoardBB& /*pos*/, Move /*move*/, GameResult /*result*/) {}
+    // ok=false: replay stopped at a bad FEN tag or an unreadable/illegal move
+    virtual void end_game(GameResult /*result*/, bool /*ok*/) {}
+};
+
+struct PgnStats {
+    uint64_t games = 0, plies = 0, errors = 0; // errors = games cut short
+    void merge(const PgnStats& o) { games += o.games; plies += o.plies; errors += o.errors; }
+};
+
+// Streaming PGN reader over an in-memory buffer (e.g. MappedFile::view()); tokens are
+// views into the buffer. Tag pairs (FEN/SetUp honoured), comments, NAGs, variations and
+// move numbers are skipped, and SAN is resolved against the replayed BoardBB.
+class PgnReader {
+public:
+    explicit PgnReader(std::string_view text) : text_(text) {}
+    bool next_game(PgnVisitor& v); // false at end of input
+    const PgnStats& stats() const { return stats_; }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    BoardBB board_;
+    PgnStats stats_;
+};
+
+// Cut text into at most `parts` pieces, each starting at a game's tag section
+std::vector<std::string_view> split_pgn(std::string_view text, int parts);
+
+// Read the pieces of split_pgn on one thread per visitor
+PgnStats read_pgn_parallel(std::string_view text, const std::vector<PgnVisitor*>& visitors);
+
+} // namespace chess
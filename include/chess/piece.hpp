@@ -1,28 +1,30 @@
 #pragma once
-#include <memory>
-#include <string>
+#include <cstdint>
 #include "chess/types.hpp"
+#include "chess/bitboard.hpp"  // PieceType
 
 namespace chess {
 
 class Board; // fwd
 
-class Piece {
-public:
-    Color color = Color::None;
-    bool hasMoved = false;
-    explicit Piece(Color col = Color::None) : color(col) {}
-    virtual ~Piece() = default;
-    virtual std::string display() const { return "?"; }
-    virtual bool can_move(const Board&, int r0, int c0, int r1, int c1) const = 0;
-    virtual std::unique_ptr<Piece> clone() const = 0;
+// One byte per square: 0 = empty, else bits 0-2 = PieceType+1, bit 3 = black, bit 4 = has moved.
+struct Piece {
+    uint8_t code = 0;
+
+    constexpr Piece() = default;
+    constexpr Piece(PieceType t, Color c, bool moved = false)
+      : code(uint8_t((t + 1) | (c == Color::Black ? 8 : 0) | (moved ? 16 : 0))) {}
+
+    constexpr bool empty() const { return (code & 7) == 0; }
+    constexpr PieceType type() const { return empty() ? NO_PIECE : PieceType((code & 7) - 1); }
+    constexpr Color color() const { return empty() ? Color::None : ((code & 8) ? Color::Black : Color::White); }
+    constexpr bool has_moved() const { return code & 16; }
+    constexpr void set_moved(bool m = true) { code = m ? uint8_t(code | 16) : uint8_t(code & ~16); }
+
+    char display() const; // "PNBRQK" for White, lower case for Black, '-' if empty
 };
 
-class Pawn   : public Piece { public: explicit Pawn(Color);   std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
-class Knight : public Piece { public: explicit Knight(Color); std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
-class Bishop : public Piece { public: explicit Bishop(Color); std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
-class Rook   : public Piece { public: explicit Rook(Color);   std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
-class Queen  : public Piece { public: explicit Queen(Color);  std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
-class King   : public Piece { public: explicit King(Color);   std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
-class Empty_Square : public Piece { public: explicit Empty_Square();  std::string display() const override; bool can_move(const Board&,int,int,int,int) const override; std::unique_ptr<Piece> clone() const override; };
+// Pseudo-legal test for the piece on (r0,c0); castling and en passant are handled in Game.
+bool can_move(const Board& b, int r0, int c0, int r1, int c1);
+
 } // namespace chess
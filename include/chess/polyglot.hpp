@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chess/board_bb.hpp"
+#include "chess/mapped_file.hpp"
+
+namespace chess {
+
+// Polyglot opening books (.bin): 16-byte big-endian entries
+//   key (8) | move (2) | weight (2) | learn (4)
+// sorted by key. Moves pack to-file, to-row, from-file, from-row (3 bits each, from
+// bit 0) and the promotion piece (bits 12-14, 1=N..4=Q); castling is king-takes-rook.
+struct BookEntry {
+    uint64_t key = 0;
+    uint16_t move = 0;
+    uint16_t weight = 0;
+    uint32_t learn = 0;
+};
+constexpr size_t BOOK_ENTRY_SIZE = 16;
+
+void write_entry(unsigned char* out, const BookEntry& e); // BOOK_ENTRY_SIZE bytes
+BookEntry read_entry(const unsigned char* in);
+
+uint64_t polyglot_key(const BoardBB& pos);
+// true if polyglot_key reproduces the documented keys (startpos 0x463b96181691fc9c and
+// the spec's en-passant and castling positions), i.e. third-party books will match
+bool polyglot_keys_standard();
+// The reference Random64 table is compiled in when the build is configured with
+// CHESS_POLYGLOT_RANDOM64=<pg_key.c> (checked against the documented keys at compile
+// time); the tree does not ship it, and without it keys only match books written with
+// the same fallback. This overrides the active table at run time from text listing the
+// 781 values as 0x... hex literals in order, such as pg_key.c or the book format
+// description. False, leaving the active table in place, if fewer than 781 values are
+// found or they do not reproduce the documented keys. Not thread-safe: call it before
+// probing.
+bool load_polyglot_random64(std::string_view text);
+
+uint16_t to_polyglot_move(Move m);                       // m must be a move of a BoardBB position
+Move from_polyglot_move(const BoardBB& pos, uint16_t pm); // Move() unless legal in pos
+
+enum class BookPick : uint8_t { Best, Weighted };
+
+// Read-only book over a mapped file: opening costs the same for any size,
+// each probe is a binary search touching O(log n) pages.
+class PolyglotBook {
+public:
+    bool open(const std::string& path); // false if unreadable or not a whole number of entries
+    void close();
+    bool is_open() const { return file_.is_open(); }
+    size_t size() const { return n_; } // entries
+
+    // all entries for key, in file order; returns their count
+    size_t find(uint64_t key, std::vector<BookEntry>& out) const;
+    // Highest-weight move, or one drawn with probability proportional to weight from
+    // rnd (any uniform 64-bit value). Move() if pos is not in the book.
+    Move pick(const BoardBB& pos, BookPick how, uint64_t rnd = 0) const;
+
+private:
+    MappedFile file_;
+    const unsigned char* data_ = nullptr;
+    size_t n_ = 0;
+};
+
+} // namespace chess
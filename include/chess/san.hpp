@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "chess/board_bb.hpp"
+
+namespace chess {
+
+// Standard Algebraic Notation for a legal move m in pos (position before the move):
+// minimal disambiguation, "x" for captures, "=Q" promotions, "O-O"/"O-O-O", "+"/"#".
+std::string to_san(const BoardBB& pos, Move m);
+
+// SAN (or "0-0", "e8Q", trailing +#!? tolerated) -> the legal move it names,
+// Move() if there is no such move or it is ambiguous. Only origin squares that
+// can reach the target are examined; no move list is generated or formatted.
+Move parse_san(const BoardBB& pos, std::string_view san);
+
+} // namespace chess
@@ -1,5 +1,8 @@
 #pragma once
 #include "chess/board_bb.hpp"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
 #include <vector>
 #include <limits>
 
@@ -8,17 +11,79 @@ namespace chess {
 // Simple material+mobility evaluator (centipawns; + = good for White)
 int eval_bb(const BoardBB& pos);
 
-// Search best move for current side with depth ply (negamax + alpha-beta)
+// Search instrumentation. Built with -DCHESS_SEARCH_STATS=1 (CMake option of the
+// same name); otherwise the counters below stay zero and cost nothing.
+#ifndef CHESS_SEARCH_STATS
+#define CHESS_SEARCH_STATS 0
+#endif
+constexpr bool SEARCH_STATS_ENABLED = CHESS_SEARCH_STATS != 0;
+
+constexpr int STATS_MAX_PLY   = 64;
+constexpr int STATS_CUT_SLOTS = 8;  // beta cutoffs at move index 0..6, last slot = 7+
+
+struct SearchStats {
+    uint64_t nodes = 0;                      // interior + leaf
+    uint64_t leaf_nodes = 0;                 // static evaluations at the horizon
+    uint64_t beta_cutoffs = 0;
+    uint64_t cutoff_at[STATS_CUT_SLOTS]{};   // by index in the ordered move list
+    uint64_t nodes_at_ply[STATS_MAX_PLY]{};  // root = ply 0
+    uint64_t movegen_ns = 0, eval_ns = 0, total_ns = 0;
+
+    void merge(const SearchStats& o);        // aggregate per-thread / per-search stats
+    double first_move_cutoff_rate() const;   // share of cutoffs produced by the first move
+    double branching_factor(int ply) const;  // nodes_at_ply[ply+1] / nodes_at_ply[ply]
+    uint64_t search_ns() const { return total_ns - movegen_ns - eval_ns; }
+};
+
+// Human-readable dump, one line per group, each starting with `prefix` (e.g. "info string ")
+void write_stats(std::ostream& os, const SearchStats& s, const char* prefix = "");
+
+constexpr int MAX_PLY = 64; // deepest search / longest PV
+
+// Move plumbing of the search. Built with -DCHESS_COPY_MAKE=1 (CMake option of the same
+// name) each ply's position is written into its own slot by BoardBB::copy_make and
+// "undo" just steps back a slot; otherwise one board is updated with do_move/undo_move.
+#ifndef CHESS_COPY_MAKE
+#define CHESS_COPY_MAKE 0
+#endif
+constexpr bool COPY_MAKE_ENABLED = CHESS_COPY_MAKE != 0;
+
+struct EvalWeights; // chess/eval_terms.hpp
+
+// depth only: one fixed-depth search. With a node or time budget the search deepens
+// 1..depth and returns the last iteration that finished inside the budget.
+struct SearchLimits {
+    int depth = 5;
+    uint64_t nodes = 0;     // 0 = unlimited
+    uint64_t movetime_ms = 0; // 0 = unlimited; checked every 1024 nodes
+    const EvalWeights* weights = nullptr; // eval_bb weights for this search; nullptr = eval_weights()
+    int tb_probe_depth = 1;   // probe tablebases (tb::init) in nodes with this much depth left
+};
+
+// Outcome of a root search
+struct SearchResult {
+    Move best;             // Move() if the side to move has no legal move
+    int score = 0;         // centipawns from the side to move's perspective
+    int depth = 0;         // deepest completed iteration
+    uint64_t nodes = 0;    // positions visited (interior + leaves), including an aborted iteration
+    std::vector<Move> pv;  // principal variation, starting with best
+    uint64_t tbhits = 0;   // successful tablebase probes (root filter counts once)
+    SearchStats stats;     // populated only when SEARCH_STATS_ENABLED
+};
+
+// Search best move for current side (negamax + alpha-beta)
+SearchResult search_position(BoardBB& pos, const SearchLimits& limits);
+SearchResult search_position(BoardBB& pos, int depth);
 Move search_best_move(BoardBB& pos, int depth);
 
-// Optional: convert a move to UCI (e2e4)
+// Long algebraic for UCI: e2e4, e7e8q
 inline std::string to_uci(const Move& m){
     int f = m.from(), t = m.to();
     auto file = [](int s){ return char('a' + (s % 8)); };
     auto rank = [](int s){ return char('1' + (s / 8)); };
     std::string s;
     s += file(f); s += rank(f); s += file(t); s += rank(t);
-    // (We always choose a fully-specified promotion in movegen, so no suffix needed here)
+    if (m.flag()>=MF_PROMO_N) s += "nbrq"[m.flag()-MF_PROMO_N];
     return s;
 }
 
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chess/board_bb.hpp"
+#include "chess/pgn.hpp"
+#include "chess/search_bb.hpp"
+
+namespace chess {
+
+// When play_game may stop before mate. Scores are the mover's search score turned to
+// White's view; both engines have to agree, since consecutive plies alternate sides.
+struct Adjudication {
+    int max_plies = 400;    // draw after this many plies
+    int draw_from_ply = 80; // from here on, draw after draw_plies plies with |score| <= draw_cp
+    int draw_plies = 16;
+    int draw_cp = 10;
+    int resign_plies = 8;   // win after resign_plies plies with score beyond resign_cp for one side (0 = off)
+    int resign_cp = 1000;
+    bool bitbases = true;   // settle KPK/KRK/KQK from chess::bitbase
+};
+
+enum class GameEnd : uint8_t {
+    Mate, Stalemate, Repetition, FiftyMoves, Material, Bitbase, DrawAdjudicated, Resign, MaxPlies
+};
+const char* to_cstr(GameEnd e);
+constexpr int GAME_END_COUNT = 9;
+
+struct PlayedGame {
+    GameResult result = GameResult::Draw;
+    GameEnd end = GameEnd::MaxPlies;
+    int plies = 0;
+};
+
+// Called before each move is played: the position and the search that chose the move
+using PlyHook = std::function<void(const BoardBB& pos, const SearchResult& r)>;
+
+// Plays pos out (pos ends on the final position). limits[ci(c)] searches for colour c.
+PlayedGame play_game(BoardBB& pos, const SearchLimits limits[2], const Adjudication& adj,
+                     const PlyHook& hook = {});
+
+// FEN part of each non-comment EPD line that parses and leaves the side to move a legal
+// move; mated and stalemated positions cannot start a game
+std::vector<std::string> load_openings(std::string_view epd);
+
+// pos = fen followed by plies uniformly random legal moves drawn from rng. A line that
+// runs into mate or stalemate is redrawn, up to 64 times; false if none got through.
+bool random_opening(BoardBB& pos, std::string_view fen, int plies, std::mt19937_64& rng);
+
+} // namespace chess
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+namespace chess {
+
+// Win/draw/loss tally of one engine against another, with the usual logistic-Elo
+// statistics. Error bars use the normal approximation of the trinomial. The two games
+// of a colour-swapped pair share their opening and are not independent, so the LLR
+// takes the pair as its sample (pentanomial model) and uses only completed pairs.
+struct MatchScore {
+    uint64_t wins = 0, draws = 0, losses = 0;
+    uint64_t pairs[5]{}; // completed pairs by engine1's points: 0, 1/2, 1, 3/2, 2
+
+    uint64_t games() const { return wins + draws + losses; }
+    uint64_t pair_count() const { return pairs[0] + pairs[1] + pairs[2] + pairs[3] + pairs[4]; }
+    double score() const;                        // (W + D/2) / games, 0.5 if none
+    double elo() const;                          // +-inf at a 0% / 100% score
+    double elo_error95() const;                  // half-width of the 95% interval (inf while all games are won or lost)
+    // GSPRT log-likelihood ratio of H1: elo1 vs H0: elo0 over the pairs; 0 while
+    // every pair has the same score (no variance to measure yet)
+    double llr(double elo0, double elo1) const;
+};
+
+// Stop when the LLR leaves [lower, upper]: below accepts H0, above accepts H1
+struct SprtBounds {
+    double lower, upper;
+};
+SprtBounds sprt_bounds(double alpha, double beta);
+
+} // namespace chess
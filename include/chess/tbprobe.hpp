@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "chess/board_bb.hpp"
+
+namespace chess {
+
+// Win/draw/loss for the side to move; cursed/blessed = decided only past the 50-move rule
+enum class Wdl : int8_t { Loss = -2, BlessedLoss = -1, Draw = 0, CursedWin = 1, Win = 2 };
+
+// Syzygy endgame tablebases (.rtbw win/draw/loss, .rtbz distance to zeroing) read
+// from local files. init() only scans directory names; a table is memory-mapped and
+// its header parsed on the first probe of its material. Probes fail (return false)
+// for positions with castling rights, more pieces than the largest table, or when a
+// table needed for the position or one of its captures is missing or invalid.
+// Probing needs init_attacks(); the board is restored before a probe returns.
+namespace tb {
+
+// ':'-separated directories (';' on Windows); "" or "<empty>" unloads everything.
+// Not thread-safe against running probes. Returns the number of files found.
+int init(const std::string& paths);
+int max_pieces();       // largest table found, 0 if none
+size_t mapped_tables(); // files mapped so far (valid headers only)
+
+bool probe_wdl(BoardBB& pos, Wdl& out);
+// Plies to the next capture or pawn move (or mate) with best play, signed like Wdl:
+// > 0 the side to move wins, < 0 it loses, 0 draw; +-100 is added past the 50-move rule
+bool probe_dtz(BoardBB& pos, int& out);
+
+// Keep the root moves with the best outcome under the 50-move rule (.rtbz: quickest
+// zeroing when winning, slowest when losing; .rtbw only: best WDL). Returns false and
+// leaves moves alone if the tables cannot rank every move.
+bool filter_root_moves(BoardBB& pos, std::vector<Move>& moves);
+
+} // namespace tb
+} // namespace chess
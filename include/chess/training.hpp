@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "chess/board_bb.hpp"
+#include "chess/pgn.hpp"
+#include "chess/search_bb.hpp"
+
+namespace chess {
+
+// One labelled position of a training set as written by chess_datagen. Files are plain
+// arrays of these (36 bytes each, host byte order, no header).
+struct TrainingRecord {
+    PackedPos pos;
+    int16_t score = 0;    // search score in centipawns, White's view
+    uint8_t result = 1;   // game result, White's view: 0 loss, 1 draw, 2 win
+    uint8_t reserved = 0;
+};
+static_assert(sizeof(TrainingRecord) == 36);
+
+uint8_t result_code(GameResult r); // WhiteWin 2, BlackWin 0, anything else 1
+
+// Is the searched position a usable label: side to move not in check, a quiet best move
+// (no capture or promotion) and |score| <= max_score (no mate or bitbase scores)
+bool trainable(const BoardBB& pos, const SearchResult& r, int max_score);
+
+// The records held in a buffer (e.g. MappedFile::view()); a trailing partial record is ignored
+std::span<const TrainingRecord> training_records(std::string_view data);
+
+} // namespace chess
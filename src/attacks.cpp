@@ -15,21 +15,9 @@ void init_attacks() {
     for (int s = 0; s < 64; ++s) {
         Bitboard b = bb(Square(s));
         // Knight
-        Bitboard n1 = (b & ~FILE_H) << 1;
-        Bitboard n2 = (b & ~(FILE_H|FILE_G)) << 2;
-        Bitboard s1 = (b & ~FILE_A) >> 1;
-        Bitboard s2 = (b & ~(FILE_A|file_mask(1))) >> 2;
-
-        Bitboard up    = b << 8;
-        Bitboard up2   = b << 16;
-        Bitboard down  = b >> 8;
-        Bitboard down2 = b >> 16;
-
         Bitboard k = 0;
-        k |= (up2   & ~0) ? ((b & ~FILE_A) << 15) : 0; // actually derive by combining simpler shifts
         // Build knight via all deltas:
         // (±1,±2), (±2,±1)
-        k = 0;
         k |= (b & ~FILE_H) << 17; // +2r +1c
         k |= (b & ~FILE_A) << 15; // +2r -1c
         k |= (b & ~FILE_H) >> 15; // -2r +1c
@@ -0,0 +1,147 @@
+#include "chess/attacks.hpp"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace chess {
+namespace {
+
+// Lane types: the kernel below is written once over O::V, with & | ~ as plain operators
+// (GCC/Clang vector extensions for __m256i) and shifts/popcounts through O.
+struct Scalar {
+    using V = uint64_t;
+    static constexpr size_t N = 1;
+    static V load(const uint64_t* x){ return x[0]; }
+    static void store(V v, uint64_t* x){ x[0] = v; }
+    static V splat(uint64_t x){ return x; }
+    template<int S> static V shl(V a){ return a << S; }
+    template<int S> static V shr(V a){ return a >> S; }
+    static V counts(V a){ return V(popcount(a)); }  // per-lane bit counts, summed with add
+    static V add(V a, V b){ return a + b; }
+    static V total(V c){ return c; }
+};
+
+#if defined(__AVX2__)
+struct Avx2 {
+    using V = __m256i;
+    static constexpr size_t N = 4;
+    static V load(const uint64_t* x){ return _mm256_loadu_si256(reinterpret_cast<const V*>(x)); }
+    static void store(V v, uint64_t* x){ _mm256_storeu_si256(reinterpret_cast<V*>(x), v); }
+    static V splat(uint64_t x){ return _mm256_set1_epi64x(int64_t(x)); }
+    template<int S> static V shl(V a){ return _mm256_slli_epi64(a, S); }
+    template<int S> static V shr(V a){ return _mm256_srli_epi64(a, S); }
+    // nibble-table popcount; byte counts are summed per lane only once, in total()
+    static V counts(V a){
+        const V lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const V low = _mm256_set1_epi8(0x0f);
+        return _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(a, low)),
+                               _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(a, 4), low)));
+    }
+    static V add(V a, V b){ return _mm256_add_epi8(a, b); } // at most 16 * 8 per byte
+    static V total(V c){ return _mm256_sad_epu8(c, _mm256_setzero_si256()); }
+};
+#endif
+
+template<class O, int D> inline typename O::V shift(typename O::V a){
+    if constexpr (D > 0) return O::template shl<D>(a);
+    else                 return O::template shr<-D>(a);
+}
+
+// File a step of D cannot land on
+constexpr Bitboard wrap(int D){
+    const int df = ((D % 8) + 8 + 4) % 8 - 4; // file change: -2..+2
+    return df == 1 ? FILE_A : df == 2 ? FILE_A | FILE_B : df == -1 ? FILE_H : df == -2 ? FILE_G | FILE_H : 0;
+}
+
+// one step of every bit in direction D
+template<class O, int D> inline typename O::V step(typename O::V b){
+    return shift<O, D>(b) & O::splat(~wrap(D));
+}
+
+// Kogge-Stone occluded fill: squares the sliders in gen reach in direction D, up to and
+// including the first blocker. Rays of different sliders in one direction never overlap.
+template<class O, int D> inline typename O::V ray(typename O::V gen, typename O::V empty){
+    const typename O::V keep = O::splat(~wrap(D));
+    typename O::V pro = empty & keep;
+    gen |= pro & shift<O, D>(gen);   pro &= shift<O, D>(pro);
+    gen |= pro & shift<O, 2*D>(gen); pro &= shift<O, 2*D>(pro);
+    gen |= pro & shift<O, 4*D>(gen);
+    return shift<O, D>(gen) & keep;
+}
+
+template<class O> inline typename O::V pawn_attacks(Color c, typename O::V p){
+    return c==WHITE ? step<O, 7>(p) | step<O, 9>(p) : step<O, -7>(p) | step<O, -9>(p);
+}
+template<class O> inline typename O::V king_attacks(typename O::V k){
+    return step<O, 8>(k) | step<O, -8>(k) | step<O, 1>(k) | step<O, -1>(k)
+         | step<O, 9>(k) | step<O, 7>(k) | step<O, -7>(k) | step<O, -9>(k);
+}
+template<class O> inline typename O::V knight_attacks(typename O::V n){
+    return step<O, 17>(n) | step<O, 15>(n) | step<O, 10>(n) | step<O, 6>(n)
+         | step<O, -6>(n) | step<O, -10>(n) | step<O, -15>(n) | step<O, -17>(n);
+}
+template<class O> inline typename O::V diag_rays(typename O::V g, typename O::V empty){
+    return ray<O, 9>(g, empty) | ray<O, 7>(g, empty) | ray<O, -7>(g, empty) | ray<O, -9>(g, empty);
+}
+template<class O> inline typename O::V orth_rays(typename O::V g, typename O::V empty){
+    return ray<O, 8>(g, empty) | ray<O, -8>(g, empty) | ray<O, 1>(g, empty) | ray<O, -1>(g, empty);
+}
+
+// O::N positions from p into out
+template<class O> void kernel(const Bitboards* p, AttackInfo* out){
+    using V = typename O::V;
+    uint64_t lane[O::N];
+    auto plane = [&](auto get){ for (size_t i=0; i<O::N; ++i) lane[i] = get(p[i]); return O::load(lane); };
+    auto emit = [&](V v, auto put){ O::store(v, lane); for (size_t i=0; i<O::N; ++i) put(out[i], lane[i]); };
+
+    const V empty = ~plane([](const Bitboards& b){ return b.occ_all; });
+    for (int c=0; c<2; ++c){
+        const Color us = c==0 ? WHITE : BLACK;
+        const int t = 1 - c;
+        auto pcs = [&](int side, PieceType pt){ return plane([=](const Bitboards& b){ return b.pcs[side][pt]; }); };
+        const V free = ~plane([=](const Bitboards& b){ return b.occ[c]; });
+        const V n = pcs(c, KNIGHT), q = pcs(c, QUEEN), k = pcs(c, KING);
+        const V diag = pcs(c, BISHOP) | q, orth = pcs(c, ROOK) | q;
+
+        // per-direction sets are disjoint per piece, so their counts add up to mobility
+        V att = pawn_attacks<O>(us, pcs(c, PAWN)) | king_attacks<O>(k);
+        V cnt = O::splat(0);
+        auto dir = [&](V a){ att |= a; cnt = O::add(cnt, O::counts(a & free)); };
+        dir(step<O, 17>(n)); dir(step<O, 15>(n)); dir(step<O, 10>(n));  dir(step<O, 6>(n));
+        dir(step<O, -6>(n)); dir(step<O, -10>(n)); dir(step<O, -15>(n)); dir(step<O, -17>(n));
+        dir(ray<O, 9>(diag, empty)); dir(ray<O, 7>(diag, empty)); dir(ray<O, -7>(diag, empty)); dir(ray<O, -9>(diag, empty));
+        dir(ray<O, 8>(orth, empty)); dir(ray<O, -8>(orth, empty)); dir(ray<O, 1>(orth, empty)); dir(ray<O, -1>(orth, empty));
+        emit(att, [c](AttackInfo& a, uint64_t v){ a.attacks[c] = v; });
+        emit(O::total(cnt), [c](AttackInfo& a, uint64_t v){ a.mobility[c] = uint16_t(v); });
+
+        // checkers: look out from our king as each enemy piece type
+        const V tq = pcs(t, QUEEN);
+        const V chk = (pawn_attacks<O>(us, k) & pcs(t, PAWN)) | (knight_attacks<O>(k) & pcs(t, KNIGHT))
+                    | (diag_rays<O>(k, empty) & (pcs(t, BISHOP) | tq)) | (orth_rays<O>(k, empty) & (pcs(t, ROOK) | tq));
+        emit(chk, [c](AttackInfo& a, uint64_t v){ a.checkers[c] = v; });
+    }
+}
+
+} // namespace
+
+void batch_attacks(const Bitboards* pos, AttackInfo* out, size_t n){
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + Avx2::N <= n; i += Avx2::N) kernel<Avx2>(pos + i, out + i);
+#endif
+    for (; i < n; ++i) kernel<Scalar>(pos + i, out + i);
+}
+
+void batch_attacks_scalar(const Bitboards* pos, AttackInfo* out, size_t n){
+    for (size_t i = 0; i < n; ++i) kernel<Scalar>(pos + i, out + i);
+}
+
+bool batch_attacks_simd(){
+#if defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace chess
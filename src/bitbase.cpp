@@ -0,0 +1,142 @@
+#include "chess/bitbase.hpp"
+#include "chess/attacks.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chess::bitbase {
+
+// Positions are normalised so the strong side is White:
+//   index = stm<<18 | wk<<12 | bk<<6 | piece   (stm 0 = strong side to move)
+constexpr uint32_t SIZE = 2u << 18;
+enum Table { KPK, KRK, KQK, TABLES };
+enum Value : uint8_t { UNKNOWN, DRAW, WIN, ILLEGAL };
+
+static std::vector<uint64_t> g_bits[TABLES]; // WIN bit per index
+static std::once_flag g_once;
+
+static inline uint32_t index(int stm, int wk, int bk, int p){ return uint32_t(stm << 18 | wk << 12 | bk << 6 | p); }
+static inline bool won(Table t, uint32_t i){ return g_bits[t][i >> 6] >> (i & 63) & 1; }
+
+static Bitboard piece_attacks(Table t, int p, Bitboard occ){
+    switch (t){
+        case KPK: return attacks_pawn(WHITE, Square(p));
+        case KRK: return attacks_rook(Square(p), occ);
+        default:  return attacks_queen(Square(p), occ);
+    }
+}
+
+static bool illegal(Table t, int stm, int wk, int bk, int p){
+    if (wk == bk || wk == p || bk == p) return true;
+    if (attacks_king(Square(wk)) & bb(Square(bk))) return true;
+    if (t == KPK && (p < 8 || p >= 56)) return true;
+    // the weak king may not stand in check with the strong side to move
+    return stm == 0 && (piece_attacks(t, p, bb(Square(wk)) | bb(Square(bk))) & bb(Square(bk)));
+}
+
+// One retrograde step for position i, reading the previous pass
+static Value classify(Table t, const std::vector<uint8_t>& cur, uint32_t i){
+    const int stm = int(i >> 18), wk = int(i >> 12) & 63, bk = int(i >> 6) & 63, p = int(i) & 63;
+    const Bitboard wkb = bb(Square(wk)), bkb = bb(Square(bk)), pb = bb(Square(p));
+
+    if (stm == 0){ // strong side: a win if any move wins, a draw if every move draws
+        bool all_draw = true;
+        auto see = [&](Value v){ all_draw = all_draw && v == DRAW; return v == WIN; };
+        for (Bitboard to = attacks_king(Square(wk)) & ~attacks_king(Square(bk)) & ~pb; to; to &= to-1)
+            if (see(Value(cur[index(1, lsb(to), bk, p)]))) return WIN;
+        if (t == KPK){
+            const int up = p + 8;
+            if (!((wkb | bkb) & bb(Square(up)))){
+                if (up >= 56){
+                    // promotion: the rook or queen tables (black to move) decide
+                    if (won(KQK, index(1, wk, bk, up)) || won(KRK, index(1, wk, bk, up))) return WIN;
+                } else {
+                    if (see(Value(cur[index(1, wk, bk, up)]))) return WIN;
+                    if (p < 16 && !((wkb | bkb) & bb(Square(up + 8))) && see(Value(cur[index(1, wk, bk, up + 8)])))
+                        return WIN;
+                }
+            }
+        } else {
+            for (Bitboard to = piece_attacks(t, p, wkb | bkb) & ~wkb & ~bkb; to; to &= to-1)
+                if (see(Value(cur[index(1, wk, bk, lsb(to))]))) return WIN;
+        }
+        return all_draw ? DRAW : UNKNOWN; // no move at all is stalemate: all_draw stays true
+    }
+
+    // weak side: a draw if any move draws, a loss (WIN for strong) if every move loses
+    const Bitboard guarded = attacks_king(Square(wk)) | piece_attacks(t, p, wkb | pb);
+    bool all_win = true, any = false;
+    for (Bitboard to = attacks_king(Square(bk)) & ~guarded; to; to &= to-1){
+        const int s = lsb(to);
+        if (s == p) return DRAW; // undefended piece taken: bare kings
+        any = true;
+        const Value v = Value(cur[index(0, wk, s, p)]);
+        if (v == DRAW) return DRAW;
+        all_win = all_win && v == WIN;
+    }
+    if (!any) return (piece_attacks(t, p, wkb | pb) & bkb) ? WIN : DRAW; // mate or stalemate
+    return all_win ? WIN : UNKNOWN;
+}
+
+static void build(Table t, unsigned threads){
+    std::vector<uint8_t> cur(SIZE), next(SIZE);
+    for (uint32_t i = 0; i < SIZE; ++i)
+        cur[i] = illegal(t, int(i >> 18), int(i >> 12) & 63, int(i >> 6) & 63, int(i) & 63) ? ILLEGAL : UNKNOWN;
+
+    // Jacobi passes (read cur, write next) so every thread count gives the same tables
+    for (bool changed = true; changed; ){
+        std::vector<uint8_t> dirty(threads, 0);
+        auto work = [&](unsigned id){
+            const uint32_t b = SIZE / threads * id, e = id + 1 == threads ? SIZE : SIZE / threads * (id + 1);
+            for (uint32_t i = b; i < e; ++i){
+                next[i] = cur[i];
+                if (cur[i] != UNKNOWN) continue;
+                if ((next[i] = classify(t, cur, i)) != UNKNOWN) dirty[id] = 1;
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned id = 1; id < threads; ++id) pool.emplace_back(work, id);
+        work(0);
+        for (auto& th : pool) th.join();
+        cur.swap(next);
+        changed = std::find(dirty.begin(), dirty.end(), 1) != dirty.end();
+    }
+
+    // whatever the strong side cannot force is a draw
+    g_bits[t].assign(SIZE / 64, 0);
+    for (uint32_t i = 0; i < SIZE; ++i)
+        if (cur[i] == WIN) g_bits[t][i >> 6] |= uint64_t(1) << (i & 63);
+}
+
+void init(){
+    std::call_once(g_once, []{
+        const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        build(KQK, threads);
+        build(KRK, threads);
+        build(KPK, threads); // promotions look up KQK/KRK
+    });
+}
+
+bool probe(const BoardBB& pos, Color& strong, bool& wins){
+    if (popcount(pos.occ_all()) != 3 || pos.castling) return false;
+    const int s = popcount(pos.occ_side(WHITE)) == 2 ? 0 : 1;
+    const Color sc = s == 0 ? WHITE : BLACK;
+    Table t;
+    Bitboard piece;
+    if      ((piece = pos.pieces(sc, PAWN)))  t = KPK;
+    else if ((piece = pos.pieces(sc, ROOK)))  t = KRK;
+    else if ((piece = pos.pieces(sc, QUEEN))) t = KQK;
+    else return false;
+
+    init();
+    const int flip = s == 0 ? 0 : 56; // mirror ranks when Black is the strong side
+    const int wk = lsb(pos.pieces(sc, KING)) ^ flip, bk = lsb(pos.pieces(other(sc), KING)) ^ flip;
+    const int p = lsb(piece) ^ flip;
+    strong = sc;
+    wins = won(t, index(pos.side == sc ? 0 : 1, wk, bk, p));
+    return true;
+}
+
+} // namespace chess::bitbase
@@ -5,46 +5,31 @@
 
 namespace chess {
 
-class Empty_Square; // only used for dynamic_cast in is_empty()
-
-Board::Board(const Board& other) {
-    for (int r=0;r<ROWS;++r)
-        for (int c=0;c<COLS;++c)
-            board[r][c] = other.board[r][c] ? other.board[r][c]->clone() : nullptr;
-}
-
-Board& Board::operator=(const Board& other){
-    if (this==&other) return *this;
-    for (int r=0;r<ROWS;++r)
-        for (int c=0;c<COLS;++c)
-            board[r][c] = other.board[r][c] ? other.board[r][c]->clone() : nullptr;
-    return *this;
-}
-
 void Board::set_major_pieces(Color color, int row) {
     // rooks
-    board[row][0] = std::make_unique<Rook>(color);
-    board[row][7] = std::make_unique<Rook>(color);
+    board[row][0] = Piece(ROOK, color);
+    board[row][7] = Piece(ROOK, color);
     // knights
-    board[row][1] = std::make_unique<Knight>(color);
-    board[row][6] = std::make_unique<Knight>(color);
+    board[row][1] = Piece(KNIGHT, color);
+    board[row][6] = Piece(KNIGHT, color);
     // bishops
-    board[row][2] = std::make_unique<Bishop>(color);
-    board[row][5] = std::make_unique<Bishop>(color);
+    board[row][2] = Piece(BISHOP, color);
+    board[row][5] = Piece(BISHOP, color);
     // queen & king
-    board[row][3] = std::make_unique<Queen>(color);
-    board[row][4] = std::make_unique<King>(color);
+    board[row][3] = Piece(QUEEN, color);
+    board[row][4] = Piece(KING, color);
 
     // pawns
     int pawn_row = (row == 0) ? 1 : 6;
     for (int j = 0; j < COLS; j++) {
-        board[pawn_row][j] = std::make_unique<Pawn>(color);
+        board[pawn_row][j] = Piece(PAWN, color);
     }
 }
 
 void Board::create_board() {
     set_major_pieces(Color::White, 0);
     set_major_pieces(Color::Black, 7);
+    locate_kings();
 }
 
 void Board::display_board() const {
@@ -87,7 +72,7 @@ void Board::display_board() const {
     for (int r = 0; r < ROWS; ++r) {
         std::cout << "  " << r << " " << V;
         for (int c = 0; c < COLS; ++c) {
-            char pc = board[r][c] ? board[r][c]->display()[0] : '-';
+            char pc = board[r][c].display();
             std::cout << " " << pc << " " << V;
         }
         std::cout << " " << r << "\n";
@@ -103,17 +88,15 @@ bool Board::in_bounds(int r, int c) const {
 }
 
 bool Board::is_empty(int r, int c) const {
-    if (!board[r][c]) return true;
-    return (board[r][c]->color == Color::None) ||
-           (dynamic_cast<Empty_Square*>(board[r][c].get()) != nullptr);
+    return board[r][c].empty();
 }
 
 bool Board::is_friend(int r, int c, Color col) const {
-    return !is_empty(r, c) && board[r][c]->color == col;
+    return !is_empty(r, c) && board[r][c].color() == col;
 }
 
 bool Board::is_enemy(int r, int c, Color col) const {
-    return !is_empty(r, c) && board[r][c]->color != col;
+    return !is_empty(r, c) && board[r][c].color() != col;
 }
 
 bool Board::path_clear(int r0, int c0, int r1, int c1) const {
@@ -129,65 +112,57 @@ bool Board::path_clear(int r0, int c0, int r1, int c1) const {
 }
 
 std::pair<int,int> Board::king_pos(Color col) const {
+    const int s = king_sq[col==Color::Black];
+    if (s < 0) return {-1,-1};
+    return {s / 8, s % 8};
+}
+
+void Board::locate_kings() {
+    king_sq[0] = king_sq[1] = -1;
     for (int r = 0; r < ROWS; ++r)
         for (int c = 0; c < COLS; ++c)
-            if (board[r][c] && board[r][c]->color == col && dynamic_cast<King*>(board[r][c].get()))
-                return {r,c};
-    return {-1,-1};
+            if (board[r][c].type() == KING)
+                set_king(board[r][c].color(), r, c);
 }
 
+// Looks outward from (r,c) for each attacker kind instead of scanning every piece.
 bool Board::attacks_square(Color attackerColor, int r, int c) const {
-    auto inb = [&](int rr, int cc){ return rr>=0 && rr<ROWS && cc>=0 && cc<COLS; };
-    auto pawn_dir = [&](Color col){ return (col==Color::White) ? +1 : -1; };
-
-    for (int rr=0; rr<ROWS; ++rr) {
-        for (int cc=0; cc<COLS; ++cc) {
-            const Piece* p = board[rr][cc].get();
-            if (!p || p->color != attackerColor) continue;
-
-            // Knight
-            if (dynamic_cast<const Knight*>(p)) {
-                int dr = std::abs(r-rr), dc = std::abs(c-cc);
-                if ((dr==2 && dc==1) || (dr==1 && dc==2)) return true;
-                continue;
-            }
-            // King
-            if (dynamic_cast<const King*>(p)) {
-                int dr = std::abs(r-rr), dc = std::abs(c-cc);
-                if (std::max(dr,dc)==1) return true;
-                continue;
-            }
-            // Pawn (captures only diagonally)
-            if (dynamic_cast<const Pawn*>(p)) {
-                int dir = pawn_dir(p->color);
-                if (r == rr + dir && std::abs(c - cc) == 1) return true;
-                continue;
-            }
-            // Bishop / Rook / Queen sliding
-            auto ray = [&](int drr, int dcc)->bool {
-                int tr = rr + drr, tc = cc + dcc;
-                while (inb(tr,tc)) {
-                    if (tr == r && tc == c) return true;
-                    if (!is_empty(tr,tc)) break;
-                    tr += drr; tc += dcc;
-                }
-                return false;
-            };
-            if (dynamic_cast<const Bishop*>(p) || dynamic_cast<const Queen*>(p)) {
-                if (ray(+1,+1) || ray(+1,-1) || ray(-1,+1) || ray(-1,-1)) return true;
-            }
-            if (dynamic_cast<const Rook*>(p) || dynamic_cast<const Queen*>(p)) {
-                if (ray(+1,0) || ray(-1,0) || ray(0,+1) || ray(0,-1)) return true;
-            }
+    auto holds = [&](int rr, int cc, PieceType t) {
+        if (!in_bounds(rr, cc)) return false;
+        const Piece p = board[rr][cc];
+        return p.type() == t && p.color() == attackerColor;
+    };
+
+    // Pawn (captures only diagonally): attacker stands one row behind (r,c)
+    int pr = r - ((attackerColor==Color::White) ? +1 : -1);
+    if (holds(pr, c-1, PAWN) || holds(pr, c+1, PAWN)) return true;
+
+    for (const auto& d : KNIGHT_STEPS)
+        if (holds(r+d[0], c+d[1], KNIGHT)) return true;
+    for (const auto& d : KING_STEPS)
+        if (holds(r+d[0], c+d[1], KING)) return true;
+
+    // Bishop / Rook / Queen sliding: first occupied square along each ray
+    auto ray_hits = [&](const int (&d)[2], PieceType slider) {
+        int tr = r + d[0], tc = c + d[1];
+        while (in_bounds(tr, tc)) {
+            const Piece p = board[tr][tc];
+            if (!p.empty())
+                return p.color() == attackerColor && (p.type() == slider || p.type() == QUEEN);
+            tr += d[0]; tc += d[1];
         }
-    }
+        return false;
+    };
+    for (const auto& d : DIAG_STEPS) if (ray_hits(d, BISHOP)) return true;
+    for (const auto& d : ORTH_STEPS) if (ray_hits(d, ROOK))   return true;
     return false;
 }
 
 void Board::clear() {
     for (int r=0;r<ROWS;++r)
         for (int c=0;c<COLS;++c)
-            board[r][c].reset();
+            board[r][c] = Piece();
+    king_sq[0] = king_sq[1] = -1;
 }
 
 } // namespace chess
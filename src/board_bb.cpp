@@ -1,8 +1,8 @@
 #include "chess/board_bb.hpp"
 #include "chess/attacks.hpp"
+#include <algorithm>
 #include <cctype>
 #include <cassert>
-#include <sstream>
 #include <cmath>   // for std::abs
 
 namespace chess {
@@ -12,11 +12,95 @@ static inline Bitboard SQ(Square s) { return ::chess::bb(s); }
 // Keep SBB for from/to masks, routed through SQ
 static inline Bitboard SBB(Square s){ return SQ(s); }
 
+// ---- Zobrist keys and cuckoo tables (both built at compile time) ----
+namespace {
+
+struct ZobristKeys {
+    uint64_t psq[2][6][64]{};
+    uint64_t castling[16]{}; // by rights mask; [0] stays 0
+    uint64_t ep[8]{};        // by file
+    uint64_t side{};         // black to move
+};
+
+constexpr ZobristKeys make_zobrist(){
+    ZobristKeys z;
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+    auto next = [&x]{
+        uint64_t r = (x += 0x9E3779B97F4A7C15ULL);
+        r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        r = (r ^ (r >> 27)) * 0x94D049BB133111EBULL;
+        return r ^ (r >> 31);
+    };
+    for (auto& c : z.psq) for (auto& p : c) for (auto& k : p) k = next();
+    for (int i=1; i<16; ++i) z.castling[i] = next();
+    for (auto& k : z.ep) k = next();
+    z.side = next();
+    return z;
+}
+constexpr ZobristKeys ZOB = make_zobrist();
+
+// Every reversible single move of a non-pawn piece, keyed by psq[from]^psq[to]^side,
+// in a two-choice cuckoo hash (3668 moves in 8192 slots).
+struct CuckooTable {
+    uint64_t key[8192]{};
+    uint16_t move[8192]{}; // from<<6 | to, 0 = empty
+};
+constexpr int cuckoo_h1(uint64_t k){ return int(k & 0x1FFF); }
+constexpr int cuckoo_h2(uint64_t k){ return int((k >> 16) & 0x1FFF); }
+
+// Can piece type pt go from a to b on an empty board?
+constexpr bool reaches(int pt, int a, int b){
+    const int df = b%8 - a%8, dr = b/8 - a/8;
+    const int af = df < 0 ? -df : df, ar = dr < 0 ? -dr : dr;
+    switch (pt){
+        case KNIGHT: return (af==1 && ar==2) || (af==2 && ar==1);
+        case BISHOP: return af == ar && af;
+        case ROOK:   return (af==0) != (ar==0);
+        case QUEEN:  return (af == ar && af) || ((af==0) != (ar==0));
+        case KING:   return af <= 1 && ar <= 1 && (af || ar);
+        default:     return false;
+    }
+}
+
+constexpr CuckooTable make_cuckoo(){
+    CuckooTable t;
+    for (int c=0; c<2; ++c)
+        for (int pt=KNIGHT; pt<=KING; ++pt)
+            for (int a=0; a<64; ++a)
+                for (int b=a+1; b<64; ++b){
+                    if (!reaches(pt, a, b)) continue;
+                    uint64_t key = ZOB.psq[c][pt][a] ^ ZOB.psq[c][pt][b] ^ ZOB.side;
+                    uint16_t move = uint16_t(a << 6 | b);
+                    for (int i = cuckoo_h1(key); ; i = (i == cuckoo_h1(key)) ? cuckoo_h2(key) : cuckoo_h1(key)){
+                        uint64_t k = t.key[i]; t.key[i] = key; key = k;
+                        uint16_t m = t.move[i]; t.move[i] = move; move = m;
+                        if (!move) break;
+                    }
+                }
+    return t;
+}
+constexpr CuckooTable CUCKOO = make_cuckoo();
+constexpr int cuckoo_size(){ int n = 0; for (uint16_t m : CUCKOO.move) n += m != 0; return n; }
+static_assert(cuckoo_size() == 3668, "every reversible piece move must fit");
+
+// Squares strictly between a and b on a shared line, 0 if not aligned
+Bitboard between(int a, int b){
+    const int df = b%8 - a%8, dr = b/8 - a/8;
+    if (df && dr && df != dr && df != -dr) return 0;
+    const int step = (dr > 0 ? 8 : dr < 0 ? -8 : 0) + (df > 0 ? 1 : df < 0 ? -1 : 0);
+    Bitboard r = 0;
+    for (int s = a + step; s != b; s += step) r |= ONE << s;
+    return r;
+}
+
+} // namespace
+
 void BoardBB::put_piece(Color c, PieceType p, Square s){
     Bitboard b = SBB(s);
     bb.pcs[ci(c)][p] |= b;
     bb.occ[ci(c)]    |= b;
     bb.occ_all       |= b;
+    key ^= ZOB.psq[ci(c)][p][s];
 }
 
 void BoardBB::remove_piece(Color c, PieceType p, Square s){
@@ -24,6 +108,7 @@ void BoardBB::remove_piece(Color c, PieceType p, Square s){
     bb.pcs[ci(c)][p] &= ~b;
     bb.occ[ci(c)]    &= ~b;
     bb.occ_all       &= ~b;
+    key ^= ZOB.psq[ci(c)][p][s];
 }
 
 void BoardBB::move_piece(Color c, PieceType p, Square from, Square to){
@@ -31,6 +116,36 @@ void BoardBB::move_piece(Color c, PieceType p, Square from, Square to){
     bb.pcs[ci(c)][p] ^= (f | t);
     bb.occ[ci(c)]    ^= (f | t);
     bb.occ_all       ^= (f | t);
+    key ^= ZOB.psq[ci(c)][p][from] ^ ZOB.psq[ci(c)][p][to];
+}
+
+uint64_t BoardBB::compute_key() const{
+    uint64_t k = ZOB.castling[castling];
+    for (int c=0; c<2; ++c)
+        for (int p=0; p<6; ++p)
+            for (Bitboard b = bb.pcs[c][p]; b; b &= b-1) k ^= ZOB.psq[c][p][lsb(b)];
+    if (ep_sq >= 0) k ^= ZOB.ep[ep_sq % 8];
+    if (side == BLACK) k ^= ZOB.side;
+    return k;
+}
+
+bool BoardBB::is_repetition(int ply) const{
+    const int end = std::min<int>(halfmove, int(stack.size()));
+    int before_root = 0;
+    for (int i = 4; i <= end; i += 2)
+        if (stack[stack.size() - i].key == key && (i <= ply || ++before_root == 2)) return true;
+    return false;
+}
+
+bool BoardBB::has_upcoming_repetition(int ply) const{
+    const int end = std::min<int>(halfmove, int(stack.size()));
+    for (int i = 3; i <= end && i < ply; i += 2){
+        const uint64_t move_key = key ^ stack[stack.size() - i].key;
+        int j = cuckoo_h1(move_key);
+        if (CUCKOO.key[j] != move_key && CUCKOO.key[j = cuckoo_h2(move_key)] != move_key) continue;
+        if (!(between(CUCKOO.move[j] >> 6, CUCKOO.move[j] & 63) & bb.occ_all)) return true;
+    }
+    return false;
 }
 
 BoardBB::BoardBB(){ clear(); }
@@ -41,6 +156,7 @@ void BoardBB::clear(){
     castling = 0;
     ep_sq = -1;
     halfmove = 0; fullmove = 1;
+    key = 0;
     stack.clear();
 }
 
@@ -64,219 +180,364 @@ void BoardBB::set_startpos(){
 
     castling = CR_WK|CR_WQ|CR_BK|CR_BQ;
     side = WHITE;
+    key = compute_key();
 }
 
-bool BoardBB::set_fen(const std::string& fen){
+const char* to_cstr(FenError e){
+    switch (e){
+        case FenError::Ok:            return "ok";
+        case FenError::MissingField:  return "missing field";
+        case FenError::TrailingData:  return "trailing data";
+        case FenError::BadPiece:      return "bad piece letter";
+        case FenError::BadRankLength: return "rank does not have 8 files";
+        case FenError::BadRankCount:  return "board does not have 8 ranks";
+        case FenError::BadSide:       return "bad side to move";
+        case FenError::BadCastling:   return "bad castling field";
+        case FenError::BadEnPassant:  return "bad en-passant square";
+        case FenError::BadClock:      return "bad move clock";
+        case FenError::KingCount:     return "each side needs exactly one king";
+        case FenError::TooManyPieces: return "too many pieces";
+        case FenError::PawnOnBackRank:return "pawn on first or last rank";
+    }
+    return "unknown";
+}
+
+static inline bool fen_space(char ch){ return ch==' ' || ch=='\t' || ch=='\r' || ch=='\n'; }
+
+static PieceType piece_from_char(char lower){
+    switch (lower){
+        case 'p': return PAWN;   case 'n': return KNIGHT; case 'b': return BISHOP;
+        case 'r': return ROOK;   case 'q': return QUEEN;  case 'k': return KING;
+        default:  return NO_PIECE;
+    }
+}
+
+// Unsigned decimal up to 65535
+static bool parse_clock(std::string_view f, uint16_t& out){
+    if (f.empty() || f.size() > 5) return false;
+    unsigned v = 0;
+    for (char ch : f){
+        if (ch<'0' || ch>'9') return false;
+        v = v*10 + unsigned(ch-'0');
+    }
+    if (v > 0xFFFF) return false;
+    out = uint16_t(v);
+    return true;
+}
+
+// <pieces> <side> <castling> <ep> [<half> <full>]; the clocks default to 0 1.
+FenError BoardBB::parse_fen(std::string_view fen){
     clear();
-    // <pieces> <side> <castling> <ep> <half> <full>
-    std::string p, stm, cr, ep, h, f;
-    std::istringstream ss(fen);
-    if(!(ss>>p>>stm>>cr>>ep>>h>>f)) return false;
+    size_t i = 0;
+    auto next_field = [&]()->std::string_view{
+        while (i<fen.size() && fen_space(fen[i])) ++i;
+        size_t start = i;
+        while (i<fen.size() && !fen_space(fen[i])) ++i;
+        return fen.substr(start, i-start);
+    };
+    const std::string_view place = next_field(), stm = next_field(), cr = next_field(),
+                           ep = next_field(), half = next_field(), full = next_field();
+    if (ep.empty() || (!half.empty() && full.empty())) return FenError::MissingField;
+    if (!next_field().empty()) return FenError::TrailingData;
 
     int r=7, c=0;
-    for(char ch: p){
-        if (ch=='/'){ --r; c=0; continue; }
-        if (std::isdigit(static_cast<unsigned char>(ch))){ c += ch-'0'; continue; }
-        Color col = std::isupper(static_cast<unsigned char>(ch)) ? WHITE : BLACK;
-        char pc = std::tolower(static_cast<unsigned char>(ch));
-        PieceType pt=NO_PIECE;
-        switch (pc){
-            case 'p': pt=PAWN; break; case 'n': pt=KNIGHT; break;
-            case 'b': pt=BISHOP; break; case 'r': pt=ROOK; break;
-            case 'q': pt=QUEEN; break; case 'k': pt=KING; break;
-            default: return false;
+    int count[2] = {0, 0};
+    for (char ch : place){
+        if (ch=='/'){
+            if (c!=8) return FenError::BadRankLength;
+            if (--r < 0) return FenError::BadRankCount;
+            c = 0;
+            continue;
+        }
+        if (ch>='1' && ch<='8'){
+            c += ch-'0';
+            if (c > 8) return FenError::BadRankLength;
+            continue;
         }
-        put_piece(col, pt, Square(r*8 + c));
+        const bool white = ch>='A' && ch<='Z';
+        const PieceType pt = piece_from_char(white ? char(ch-'A'+'a') : ch);
+        if (pt==NO_PIECE) return FenError::BadPiece;
+        if (c >= 8) return FenError::BadRankLength;
+        if (pt==PAWN && (r==0 || r==7)) return FenError::PawnOnBackRank;
+        put_piece(white ? WHITE : BLACK, pt, Square(r*8 + c));
+        ++count[white ? 0 : 1];
         ++c;
     }
+    if (c!=8) return FenError::BadRankLength;
+    if (r!=0) return FenError::BadRankCount;
+    for (int col=0; col<2; ++col){
+        if (popcount(bb.pcs[col][KING]) != 1) return FenError::KingCount;
+        if (count[col] > 16 || popcount(bb.pcs[col][PAWN]) > 8) return FenError::TooManyPieces;
+    }
 
-    side = (stm=="w")?WHITE:BLACK;
+    if (stm=="w") side = WHITE;
+    else if (stm=="b") side = BLACK;
+    else return FenError::BadSide;
 
     castling = 0;
-    for(char ch: cr){
-        if (ch=='K') castling |= CR_WK;
-        else if (ch=='Q') castling |= CR_WQ;
-        else if (ch=='k') castling |= CR_BK;
-        else if (ch=='q') castling |= CR_BQ;
+    if (cr!="-"){
+        for (char ch : cr){
+            uint8_t bit = ch=='K' ? CR_WK : ch=='Q' ? CR_WQ : ch=='k' ? CR_BK : ch=='q' ? CR_BQ : 0;
+            if (!bit || (castling & bit)) return FenError::BadCastling;
+            castling |= bit;
+        }
     }
 
+    // EP target must sit behind a pawn that just double-stepped, with both squares it crossed empty
     ep_sq = -1;
     if (ep!="-"){
-        int file = ep[0]-'a';
-        int rank = ep[1]-'1';
-        if (file>=0 && file<8 && rank>=0 && rank<8) ep_sq = rank*8 + file;
+        if (ep.size()!=2 || ep[0]<'a' || ep[0]>'h') return FenError::BadEnPassant;
+        const int file = ep[0]-'a', rank = ep[1]-'1';
+        if (rank != (side==WHITE ? 5 : 2)) return FenError::BadEnPassant;
+        const int s = rank*8 + file, dir = (side==WHITE) ? -8 : 8;   // toward the pushed pawn
+        if ((occ_all() & SQ(Square(s))) || (occ_all() & SQ(Square(s-dir)))
+            || !(pieces(side==WHITE ? BLACK : WHITE, PAWN) & SQ(Square(s+dir))))
+            return FenError::BadEnPassant;
+        // kept only if a pawn beside the pushed one can capture, as in do_move
+        const Bitboard pushed = SQ(Square(s+dir));
+        if ((east(pushed) | west(pushed)) & pieces(side, PAWN)) ep_sq = int8_t(s);
     }
 
-    halfmove = h.empty()?0:std::stoi(h);
-    fullmove = f.empty()?1:std::stoi(f);
-    return true;
+    halfmove = 0; fullmove = 1;
+    if (!half.empty() && (!parse_clock(half, halfmove) || !parse_clock(full, fullmove)))
+        return FenError::BadClock;
+    key = compute_key();
+    return FenError::Ok;
 }
 
-std::string BoardBB::to_fen() const{
-    auto piece_at = [&](int r, int c)->char{
-        Square s = Square(r*8+c);
-        for(int col=0; col<2; ++col){
-            for(int pt=0; pt<6; ++pt){
-                if (bb.pcs[col][pt] & SBB(s)){
-                    const char map[6] = {'p','n','b','r','q','k'};
-                    char ch = map[pt];
-                    return (col==0) ? std::toupper(ch) : ch; // 0=White, 1=Black
-                }
-            }
-        }
-        return '1';
-    };
-    std::string out;
-    for(int r=7;r>=0;--r){
-        int empties=0;
-        for(int c=0;c<8;++c){
-            char ch = piece_at(r,c);
-            if (ch=='1'){ ++empties; }
-            else{
-                if (empties){ out.push_back(char('0'+empties)); empties=0; }
-                out.push_back(ch);
-            }
+bool BoardBB::set_fen(const std::string& fen){
+    return parse_fen(fen) == FenError::Ok;
+}
+
+static char* write_uint(char* p, unsigned v){
+    char tmp[5]; int n = 0;
+    do { tmp[n++] = char('0' + v%10); v /= 10; } while (v);
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+size_t BoardBB::write_fen(char* out, size_t cap) const{
+    if (cap < FEN_BUF_SIZE) return 0;
+    static const char PC[2][6] = {{'P','N','B','R','Q','K'}, {'p','n','b','r','q','k'}};
+    char mailbox[64] = {};
+    for (int col=0; col<2; ++col)
+        for (int pt=0; pt<6; ++pt)
+            for (Bitboard b = bb.pcs[col][pt]; b; b &= b-1) mailbox[lsb(b)] = PC[col][pt];
+
+    char* p = out;
+    for (int r=7; r>=0; --r){
+        int empties = 0;
+        for (int c=0; c<8; ++c){
+            char ch = mailbox[r*8+c];
+            if (!ch){ ++empties; continue; }
+            if (empties){ *p++ = char('0'+empties); empties = 0; }
+            *p++ = ch;
         }
-        if (empties) out.push_back(char('0'+empties));
-        if (r) out.push_back('/');
-    }
-    out += side==WHITE ? " w " : " b ";
-    if (!castling) out += "-";
-    else{
-        if (castling & CR_WK) out+='K';
-        if (castling & CR_WQ) out+='Q';
-        if (castling & CR_BK) out+='k';
-        if (castling & CR_BQ) out+='q';
+        if (empties) *p++ = char('0'+empties);
+        if (r) *p++ = '/';
     }
-    out += ' ';
-    if (ep_sq<0) out += "-";
-    else{
-        int f = ep_sq % 8, r = ep_sq / 8;
-        out.push_back(char('a'+f));
-        out.push_back(char('1'+r));
+    *p++ = ' ';
+    *p++ = side==WHITE ? 'w' : 'b';
+    *p++ = ' ';
+    if (!castling) *p++ = '-';
+    if (castling & CR_WK) *p++ = 'K';
+    if (castling & CR_WQ) *p++ = 'Q';
+    if (castling & CR_BK) *p++ = 'k';
+    if (castling & CR_BQ) *p++ = 'q';
+    *p++ = ' ';
+    if (ep_sq<0) *p++ = '-';
+    else { *p++ = char('a' + ep_sq%8); *p++ = char('1' + ep_sq/8); }
+    *p++ = ' ';
+    p = write_uint(p, halfmove);
+    *p++ = ' ';
+    p = write_uint(p, fullmove);
+    *p = '\0';
+    return size_t(p - out);
+}
+
+std::string BoardBB::to_fen() const{
+    char buf[FEN_BUF_SIZE];
+    return std::string(buf, write_fen(buf, sizeof buf));
+}
+
+bool PackedPos::operator==(const PackedPos& o) const {
+    for (int i=0;i<32;++i) if (data[i]!=o.data[i]) return false;
+    return true;
+}
+
+bool BoardBB::encode(PackedPos& out) const{
+    Bitboard occ = bb.occ_all;
+    if (popcount(occ) > 32) return false;
+    out = PackedPos{};
+    for (int i=0;i<8;++i) out.data[i] = uint8_t(occ >> (8*i));
+
+    // a piece's slot is the number of occupied squares below it
+    for (int col=0; col<2; ++col)
+        for (int pt=0; pt<6; ++pt)
+            for (Bitboard b = bb.pcs[col][pt]; b; b &= b-1){
+                int n = popcount(occ & (SBB(Square(lsb(b))) - 1));
+                out.data[8 + n/2] |= uint8_t((col<<3 | pt) << (4*(n&1)));
+            }
+
+    out.data[24] = uint8_t((side==BLACK ? 1 : 0) | (castling << 1));
+    out.data[25] = ep_sq<0 ? 0xFF : uint8_t(ep_sq);
+    out.data[26] = uint8_t(halfmove);  out.data[27] = uint8_t(halfmove >> 8);
+    out.data[28] = uint8_t(fullmove);  out.data[29] = uint8_t(fullmove >> 8);
+    return true;
+}
+
+bool BoardBB::decode(const PackedPos& in){
+    clear();
+    Bitboard occ = 0;
+    for (int i=0;i<8;++i) occ |= Bitboard(in.data[i]) << (8*i);
+    if (popcount(occ) > 32) return false;
+
+    int n = 0;
+    for (Bitboard b = occ; b; ++n){
+        Square s = Square(lsb(b)); b &= b-1;
+        uint8_t code = (in.data[8 + n/2] >> (4*(n&1))) & 15;
+        if ((code & 7) > KING) return false;
+        put_piece((code & 8) ? BLACK : WHITE, PieceType(code & 7), s);
     }
-    out += ' ';
-    out += std::to_string(halfmove);
-    out += ' ';
-    out += std::to_string(fullmove);
-    return out;
+
+    uint8_t flags = in.data[24];
+    if ((flags >> 5) || in.data[30] || in.data[31]) return false;
+    side = (flags & 1) ? BLACK : WHITE;
+    castling = uint8_t(flags >> 1);
+    // the EP square sits behind a pawn the opponent just pushed: rank 6 with
+    // White to move, rank 3 with Black to move
+    uint8_t ep = in.data[25];
+    if (ep != 0xFF && (ep > 63 || ep >> 3 != (side==WHITE ? 5 : 2))) return false;
+    ep_sq = ep==0xFF ? -1 : int8_t(ep);
+    halfmove = uint16_t(in.data[26] | in.data[27] << 8);
+    fullmove = uint16_t(in.data[28] | in.data[29] << 8);
+    key = compute_key();
+    return true;
+}
+
+// compile-time pawn geometry for one side
+template<Color C> struct PawnDirs {
+    static constexpr int UP = C==WHITE ? 8 : -8;
+    static constexpr int UP_LEFT = UP - 1, UP_RIGHT = UP + 1; // toward the a-file / h-file
+    static constexpr Bitboard RANK3 = C==WHITE ? RANK_3 : RANK_6; // after a single push
+    static constexpr Bitboard RANK8 = C==WHITE ? RANK_8 : RANK_1; // promotion rank
+};
+template<int D> static inline Bitboard shift(Bitboard b){ return D > 0 ? b << D : b >> -D; }
+
+// castling right lost when a rook of side C leaves or is taken on s
+template<Color C> static inline uint8_t rook_right(Square s){
+    if constexpr (C==WHITE) return s==H1 ? CR_WK : s==A1 ? CR_WQ : 0;
+    else                    return s==H8 ? CR_BK : s==A8 ? CR_BQ : 0;
 }
 
 // --- attack detector (used for legality checks)
-bool BoardBB::square_attacked(Square s, Color by) const {
-    // Pawns
-    if (attacks_pawn(other(by), s) & bb.pcs[ci(by)][PAWN]) return true; // square attacked by 'by'
-    // Knights
-    if (attacks_knight(s) & bb.pcs[ci(by)][KNIGHT]) return true;
-    // Kings
-    if (attacks_king(s) & bb.pcs[ci(by)][KING]) return true;
-    // Sliders
-    Bitboard occ = bb.occ_all;
-    if (attacks_bishop(s, occ) & (bb.pcs[ci(by)][BISHOP] | bb.pcs[ci(by)][QUEEN])) return true;
-    if (attacks_rook  (s, occ) & (bb.pcs[ci(by)][ROOK]   | bb.pcs[ci(by)][QUEEN])) return true;
+template<Color By>
+bool BoardBB::attacked_by(Square s) const {
+    constexpr int BY = ci(By);
+    if (attacks_pawn(other(By), s) & bb.pcs[BY][PAWN]) return true; // square attacked by 'By'
+    if (attacks_knight(s) & bb.pcs[BY][KNIGHT]) return true;
+    if (attacks_king(s) & bb.pcs[BY][KING]) return true;
+    const Bitboard occ = bb.occ_all;
+    if (attacks_bishop(s, occ) & (bb.pcs[BY][BISHOP] | bb.pcs[BY][QUEEN])) return true;
+    if (attacks_rook  (s, occ) & (bb.pcs[BY][ROOK]   | bb.pcs[BY][QUEEN])) return true;
     return false;
 }
 
+bool BoardBB::square_attacked(Square s, Color by) const {
+    return by==WHITE ? attacked_by<WHITE>(s) : attacked_by<BLACK>(s);
+}
+
+Bitboard BoardBB::attackers_to(Square s, Color by) const {
+    const auto& p = bb.pcs[ci(by)];
+    const Bitboard occ = bb.occ_all;
+    return (attacks_pawn(other(by), s) & p[PAWN]) | (attacks_knight(s) & p[KNIGHT]) | (attacks_king(s) & p[KING])
+         | (attacks_bishop(s, occ) & (p[BISHOP] | p[QUEEN])) | (attacks_rook(s, occ) & (p[ROOK] | p[QUEEN]));
+}
+
 // --- move do/undo (simple, stateful)
-void BoardBB::do_move(Move m){
+template<Color Us>
+void BoardBB::do_move_as(Move m){
+    constexpr Color Them = other(Us);
+    constexpr int US = ci(Us), THEM = ci(Them);
+    using D = PawnDirs<Us>;
+
     State st{};
+    st.key      = key;
     st.castling = castling;
     st.ep_sq    = ep_sq;
-    st.halfmove = (uint8_t)halfmove;
+    st.halfmove = halfmove;
+    st.move     = m;
+    st.captured = NO_PIECE;
+    key ^= ZOB.castling[castling];
+    if (ep_sq >= 0) key ^= ZOB.ep[ep_sq % 8];
 
-    Square from = Square(m.from()), to = Square(m.to());
-    Color us = side, them = other(us);
+    const Square from = Square(m.from()), to = Square(m.to());
+    const uint8_t flag = m.flag();
 
     // identify moving piece
     PieceType pt = NO_PIECE;
-    for(int p=0;p<6;++p) if (bb.pcs[ci(us)][p] & SBB(from)){ pt = (PieceType)p; break; }
-    st.moved_piece = pt; st.moved_from = m.from(); st.moved_to = m.to();
+    for(int p=0;p<6;++p) if (bb.pcs[US][p] & SBB(from)){ pt = (PieceType)p; break; }
+    st.moved = uint8_t(pt);
 
-    // captures (including EP)
-    if (m.flag()==MF_EP){
-        // capture pawn behind the to-square
-        int to_r = row_of(to), to_c = col_of(to);
-        int cap_r = (us==WHITE) ? to_r - 1 : to_r + 1;
-        Square cap = Square(cap_r*8 + to_c);
-        remove_piece(them, PAWN, cap);
+    // captures (including EP: the pawn behind the to-square)
+    if (flag==MF_EP){
+        remove_piece(Them, PAWN, Square(to - D::UP));
         st.captured = PAWN;
-        // move pawn
-        move_piece(us, PAWN, from, to);
-        halfmove = 0;
-    } else {
-        // normal capture?
-        if (bb.occ[ci(them)] & SBB(to)){
-            // find captured type
-            for(int p=0;p<6;++p){
-                if (bb.pcs[ci(them)][p] & SBB(to)){ remove_piece(them, (PieceType)p, to); st.captured = p; break; }
-            }
-            halfmove = 0;
-        } else {
-            halfmove += 1;
+    } else if (bb.occ[THEM] & SBB(to)){
+        for(int p=0;p<6;++p){
+            if (bb.pcs[THEM][p] & SBB(to)){ remove_piece(Them, (PieceType)p, to); st.captured = p; break; }
         }
-        // move piece
-        move_piece(us, pt, from, to);
-    }
-
-    // promotions
-    if (m.flag()>=MF_PROMO_N && m.flag()<=MF_PROMO_Q){
-        PieceType promo = (PieceType)(m.flag()-MF_PROMO_N+KNIGHT);
-        remove_piece(us, PAWN, to);
-        put_piece(us, promo, to);
-        st.promo_to = promo;
-        halfmove = 0;
     }
-
-    // castling move
-    if (m.flag()==MF_CASTLE){
-        // determine side by squares
-        if (us==WHITE){
-            if (to==G1){ // e1g1 rook h1f1
-                move_piece(WHITE, ROOK, H1, F1);
-            } else {     // e1c1 rook a1d1
-                move_piece(WHITE, ROOK, A1, D1);
-            }
-        } else {
-            if (to==G8){
-                move_piece(BLACK, ROOK, H8, F8);
-            } else {
-                move_piece(BLACK, ROOK, A8, D8);
-            }
-        }
-        halfmove += 1;
+    move_piece(Us, pt, from, to);
+
+    if (flag>=MF_PROMO_N){
+        remove_piece(Us, PAWN, to);
+        put_piece(Us, (PieceType)(flag-MF_PROMO_N+KNIGHT), to);
+    } else if (flag==MF_CASTLE){
+        constexpr int R = Us==WHITE ? 0 : 56; // back rank offset
+        if (to==R+G1) move_piece(Us, ROOK, Square(R+H1), Square(R+F1));
+        else          move_piece(Us, ROOK, Square(R+A1), Square(R+D1));
     }
+    // pawn moves and captures reset the 50-move count
+    halfmove = (pt==PAWN || st.captured!=NO_PIECE) ? 0 : halfmove + 1;
 
     // update castling rights (if king or rook moved/captured)
-    auto clear_rook_right = [&](Color c, Square s){
-        if (c==WHITE){
-            if (s==H1) castling &= ~CR_WK;
-            if (s==A1) castling &= ~CR_WQ;
-        } else {
-            if (s==H8) castling &= ~CR_BK;
-            if (s==A8) castling &= ~CR_BQ;
-        }
-    };
-    if (pt==KING){
-        if (us==WHITE) castling &= ~(CR_WK|CR_WQ);
-        else           castling &= ~(CR_BK|CR_BQ);
-    }
-    if (pt==ROOK) clear_rook_right(us, from);
-    if (st.captured==ROOK) clear_rook_right(them, to);
+    if (pt==KING) castling &= ~(Us==WHITE ? CR_WK|CR_WQ : CR_BK|CR_BQ);
+    if (pt==ROOK) castling &= ~rook_right<Us>(from);
+    if (st.captured==ROOK) castling &= ~rook_right<Them>(to);
 
-    // EP target
-    if (pt==PAWN && (row_of(to) - row_of(from) == 2 || row_of(from) - row_of(to) == 2)){
-        // set target square behind the pawn
-        ep_sq = (row_of(from) + row_of(to))/2 * 8 + col_of(from);
-        halfmove = 0;
-    } else ep_sq = -1;
+    // EP target: the square the pawn skipped, and only if an enemy pawn can take on it,
+    // so that the same position reached without a double push gets the same key
+    ep_sq = -1;
+    if (pt==PAWN && to - from == 2*D::UP && ((east(SBB(to)) | west(SBB(to))) & bb.pcs[THEM][PAWN])){
+        ep_sq = int8_t(from + D::UP);
+        key ^= ZOB.ep[ep_sq % 8];
+    }
+    key ^= ZOB.castling[castling] ^ ZOB.side;
 
     // side/fullmove
-    if (us==BLACK) fullmove += 1;
-    side = other(side);
+    if constexpr (Us==BLACK) fullmove += 1;
+    side = Them;
 
     stack.push_back(st);
 }
 
+void BoardBB::do_move(Move m){
+    if (side==WHITE) do_move_as<WHITE>(m);
+    else             do_move_as<BLACK>(m);
+}
+
+void BoardBB::copy_make(const BoardBB& parent, Move m){
+    bb = parent.bb;
+    side = parent.side;
+    castling = parent.castling;
+    ep_sq = parent.ep_sq;
+    halfmove = parent.halfmove; fullmove = parent.fullmove;
+    key = parent.key;
+    stack.assign_tail(parent.stack, std::min<size_t>(parent.halfmove, parent.stack.size()));
+    do_move(m);
+}
+
 void BoardBB::undo_move(){
     assert(!stack.empty());
     State st = stack.back(); stack.pop_back();
@@ -286,18 +547,19 @@ void BoardBB::undo_move(){
     ep_sq    = st.ep_sq;
     halfmove = st.halfmove;
 
-    Square from = Square(st.moved_from), to = Square(st.moved_to);
+    const Move m = st.move;
+    Square from = Square(m.from()), to = Square(m.to());
     Color us = side, them = other(side);
-    PieceType pt = (PieceType)st.moved_piece;
+    PieceType pt = (PieceType)st.moved;
 
     // undo promotions
-    if (st.promo_to != NO_PIECE){
-        remove_piece(us, (PieceType)st.promo_to, to);
+    if (m.is_promo()){
+        remove_piece(us, (PieceType)(m.flag()-MF_PROMO_N+KNIGHT), to);
         put_piece(us, PAWN, to);
     }
 
     // if castling, move rook back
-    if ( (pt==KING) && (std::abs(col_of(to)-col_of(from))==2) ){
+    if (m.flag()==MF_CASTLE){
         if (us==WHITE){
             if (to==G1){ move_piece(WHITE, ROOK, F1, H1); }
             else        { move_piece(WHITE, ROOK, D1, A1); }
@@ -311,215 +573,170 @@ void BoardBB::undo_move(){
     move_piece(us, pt, to, from);
 
     // restore captured
-    if (st.captured != NO_PIECE){
-        if (st.promo_to==NO_PIECE && st.moved_piece==PAWN && ep_sq!=-1 && st.ep_sq!=-1 && st.moved_to==st.ep_sq && st.captured==PAWN){
-            // EP undo (rare path); simpler: track an EP flag in State if preferred
-            int to_r = row_of(Square(st.moved_to)), to_c = col_of(Square(st.moved_to));
-            int cap_r = (us==WHITE) ? to_r - 1 : to_r + 1;
-            Square cap = Square(cap_r*8 + to_c);
-            put_piece(them, PAWN, cap);
-        } else {
-            put_piece(them, (PieceType)st.captured, to);
-        }
+    if (m.flag()==MF_EP){
+        int to_r = row_of(to), to_c = col_of(to);
+        int cap_r = (us==WHITE) ? to_r - 1 : to_r + 1;
+        put_piece(them, PAWN, Square(cap_r*8 + to_c));
+    } else if (st.captured != NO_PIECE){
+        put_piece(them, (PieceType)st.captured, to);
     }
 
     if (us==BLACK) fullmove -= 1;
+    key = st.key;
 }
 
 // --- move generation (pseudo-legal) ---
-void BoardBB::generate_moves(std::vector<Move>& out) const {
-    out.clear();
-    Color us = side, them = other(us);
-    Bitboard occUs = bb.occ[ci(us)], occThem = bb.occ[ci(them)], occAll = bb.occ_all;
+template<class List>
+static inline void add_promotions(List& out, int from, int to){
+    out.emplace_back(from, to, MF_PROMO_Q);
+    out.emplace_back(from, to, MF_PROMO_R);
+    out.emplace_back(from, to, MF_PROMO_B);
+    out.emplace_back(from, to, MF_PROMO_N);
+}
 
-    // Pawns
-    Bitboard P = bb.pcs[ci(us)][PAWN];
-    if (us==WHITE){
-                // White
-        Bitboard single = north(P) & ~occAll;
-        Bitboard dbl    = north(single & RANK_3) & ~occAll;  // was RANK_2
-
-        // pushes
-        for (Bitboard b=single; b;){ int to = lsb(b); pop_lsb(b);
-            int r = row_of(Square(to));
-            if (r==7) { // promotions
-                out.emplace_back(to-8, to, MF_PROMO_Q);
-                out.emplace_back(to-8, to, MF_PROMO_R);
-                out.emplace_back(to-8, to, MF_PROMO_B);
-                out.emplace_back(to-8, to, MF_PROMO_N);
-            } else {
-                out.emplace_back(to-8, to, MF_QUIET);
-            }
-        }
-        for (Bitboard b=dbl; b;){ int to = lsb(b); pop_lsb(b);
-            out.emplace_back(to-16, to, MF_QUIET);
-        }
-        // captures
-        Bitboard left  = (P & ~FILE_A) << 7;
-        Bitboard right = (P & ~FILE_H) << 9;
-        Bitboard capsL = left  & occThem;
-        Bitboard capsR = right & occThem;
-        for (Bitboard b=capsL; b;){ int to = lsb(b); pop_lsb(b);
-            int from = to - 7;
-            int r = row_of(Square(to));
-            if (r==7){
-                out.emplace_back(from, to, MF_PROMO_Q);
-                out.emplace_back(from, to, MF_PROMO_R);
-                out.emplace_back(from, to, MF_PROMO_B);
-                out.emplace_back(from, to, MF_PROMO_N);
-            } else out.emplace_back(from, to, MF_CAPTURE);
-        }
-        for (Bitboard b=capsR; b;){ int to = lsb(b); pop_lsb(b);
-            int from = to - 9; int r=row_of(Square(to));
-            if (r==7){
-                out.emplace_back(from, to, MF_PROMO_Q);
-                out.emplace_back(from, to, MF_PROMO_R);
-                out.emplace_back(from, to, MF_PROMO_B);
-                out.emplace_back(from, to, MF_PROMO_N);
-            } else out.emplace_back(from, to, MF_CAPTURE);
-        }
-        // en-passant
-        if (ep_sq>=0){
-            Bitboard ep = SQ(Square(ep_sq));
-            Bitboard can = ((P & ~FILE_A) << 7) | ((P & ~FILE_H) << 9);
-            if (can & ep){
-                int to = ep_sq;
-                int fromL = to - 7, fromR = to - 9;
-                if ((P & SQ(Square(fromL))) && col_of(Square(to))==col_of(Square(fromL))+1)
-                    out.emplace_back(fromL, to, MF_EP);
-                if ((P & SQ(Square(fromR))) && col_of(Square(to))==col_of(Square(fromR))-1)
-                    out.emplace_back(fromR, to, MF_EP);
-            }
-        }
-    } else { // BLACK
-       
-         // Black
-        Bitboard single = south(P) & ~occAll;
-        Bitboard dbl    = south(single & RANK_6) & ~occAll;  // was RANK_7
-
-        for (Bitboard b=single; b;){ int to = lsb(b); pop_lsb(b);
-            int r = row_of(Square(to));
-            if (r==0){
-                out.emplace_back(to+8, to, MF_PROMO_Q);
-                out.emplace_back(to+8, to, MF_PROMO_R);
-                out.emplace_back(to+8, to, MF_PROMO_B);
-                out.emplace_back(to+8, to, MF_PROMO_N);
-            } else out.emplace_back(to+8, to, MF_QUIET);
-        }
-        for (Bitboard b=dbl; b;){ int to = lsb(b); pop_lsb(b);
-            out.emplace_back(to+16, to, MF_QUIET);
-        }
-        Bitboard left  = (P & ~FILE_A) >> 9;
-        Bitboard right = (P & ~FILE_H) >> 7;
-        Bitboard capsL = left  & occThem;
-        Bitboard capsR = right & occThem;
-        for (Bitboard b=capsL; b;){ int to = lsb(b); pop_lsb(b);
-            int from = to + 9; int r=row_of(Square(to));
-            if (r==0){
-                out.emplace_back(from, to, MF_PROMO_Q);
-                out.emplace_back(from, to, MF_PROMO_R);
-                out.emplace_back(from, to, MF_PROMO_B);
-                out.emplace_back(from, to, MF_PROMO_N);
-            } else out.emplace_back(from, to, MF_CAPTURE);
+template<Color Us, GenType Type, class List>
+void BoardBB::generate(List& out) const {
+    constexpr Color Them = other(Us);
+    constexpr int US = ci(Us), THEM = ci(Them);
+    using D = PawnDirs<Us>;
+    const Bitboard occUs = bb.occ[US], occThem = bb.occ[THEM], occAll = bb.occ_all;
+
+    // in check, non-king moves must take the checker or land between it and the king
+    Bitboard target = ~0ULL, checkers = 0;
+    if constexpr (Type==GenType::Evasions){
+        const Square ksq = king_square(Us);
+        checkers = attackers_to(ksq, Them);
+        if (!checkers) return generate<Us, GenType::All>(out);
+        target = popcount(checkers) > 1 ? 0 : checkers | between(ksq, lsb(checkers));
+    }
+
+    // Pawns; pushes onto the last rank count as captures
+    const Bitboard P = bb.pcs[US][PAWN];
+    Bitboard single = shift<D::UP>(P) & ~occAll;
+    Bitboard dbl    = shift<D::UP>(single & D::RANK3) & ~occAll;
+    if constexpr (Type==GenType::Captures) { single &= D::RANK8; dbl = 0; }
+    if constexpr (Type==GenType::Quiets)   single &= ~D::RANK8;
+    for (Bitboard b=single & target; b;){ int to = lsb(b); pop_lsb(b);
+        if (SQ(Square(to)) & D::RANK8) add_promotions(out, to-D::UP, to);
+        else out.emplace_back(to-D::UP, to, MF_QUIET);
+    }
+    for (Bitboard b=dbl & target; b;){ int to = lsb(b); pop_lsb(b);
+        out.emplace_back(to-2*D::UP, to, MF_QUIET);
+    }
+    if constexpr (Type!=GenType::Quiets){
+        const Bitboard left  = shift<D::UP_LEFT>(P & ~FILE_A);
+        const Bitboard right = shift<D::UP_RIGHT>(P & ~FILE_H);
+        for (Bitboard b=left & occThem & target; b;){ int to = lsb(b); pop_lsb(b);
+            if (SQ(Square(to)) & D::RANK8) add_promotions(out, to-D::UP_LEFT, to);
+            else out.emplace_back(to-D::UP_LEFT, to, MF_CAPTURE);
         }
-        for (Bitboard b=capsR; b;){ int to = lsb(b); pop_lsb(b);
-            int from = to + 7; int r=row_of(Square(to));
-            if (r==0){
-                out.emplace_back(from, to, MF_PROMO_Q);
-                out.emplace_back(from, to, MF_PROMO_R);
-                out.emplace_back(from, to, MF_PROMO_B);
-                out.emplace_back(from, to, MF_PROMO_N);
-            } else out.emplace_back(from, to, MF_CAPTURE);
+        for (Bitboard b=right & occThem & target; b;){ int to = lsb(b); pop_lsb(b);
+            if (SQ(Square(to)) & D::RANK8) add_promotions(out, to-D::UP_RIGHT, to);
+            else out.emplace_back(to-D::UP_RIGHT, to, MF_CAPTURE);
         }
+        // en-passant; in check it must take the checking pawn or block
         if (ep_sq>=0){
-            Bitboard ep = SQ(Square(ep_sq));
-            Bitboard can = ((P & ~FILE_A) >> 9) | ((P & ~FILE_H) >> 7);
-            if (can & ep){
-                int to = ep_sq;
-                int fromL = to + 9, fromR = to + 7;
-                if ((P & SQ(Square(fromL))) && col_of(Square(to))==col_of(Square(fromL))-1)
-                    out.emplace_back(fromL, to, MF_EP);
-                if ((P & SQ(Square(fromR))) && col_of(Square(to))==col_of(Square(fromR))+1)
-                    out.emplace_back(fromR, to, MF_EP);
+            const Bitboard ep = SQ(Square(ep_sq));
+            if (Type!=GenType::Evasions || (ep & target) || (checkers & SQ(Square(ep_sq-D::UP)))){
+                if (left  & ep) out.emplace_back(ep_sq-D::UP_LEFT,  ep_sq, MF_EP);
+                if (right & ep) out.emplace_back(ep_sq-D::UP_RIGHT, ep_sq, MF_EP);
             }
         }
     }
 
-    // Knights
-    for (Bitboard b = bb.pcs[ci(us)][KNIGHT]; b; ){
-        Square from = Square(lsb(b)); pop_lsb(b);
-        Bitboard moves = attacks_knight(from) & ~occUs;
+    // Pieces
+    const Bitboard to_mask = Type==GenType::Captures ? occThem
+                           : Type==GenType::Quiets   ? ~occAll
+                           :                           ~occUs & target;
+    auto add = [&](Square from, Bitboard moves){
         for (Bitboard m=moves; m; ){ Square to = Square(lsb(m)); pop_lsb(m);
-            MoveFlag f = (bb.occ[ci(them)] & SQ(to)) ? MF_CAPTURE : MF_QUIET;
-            out.emplace_back(from, to, f);
+            out.emplace_back(from, to, (occThem & SQ(to)) ? MF_CAPTURE : MF_QUIET);
         }
+    };
+    for (Bitboard b = bb.pcs[US][KNIGHT]; b; ){
+        Square from = Square(lsb(b)); pop_lsb(b);
+        add(from, attacks_knight(from) & to_mask);
     }
-
-    // Bishops
-    for (Bitboard b = bb.pcs[ci(us)][BISHOP]; b; ){
+    for (Bitboard b = bb.pcs[US][BISHOP]; b; ){
         Square from = Square(lsb(b)); pop_lsb(b);
-        Bitboard moves = attacks_bishop(from, occAll) & ~occUs;
-        for (Bitboard m=moves; m; ){ Square to = Square(lsb(m)); pop_lsb(m);
-            MoveFlag f = (bb.occ[ci(them)] & SQ(to)) ? MF_CAPTURE : MF_QUIET;
-            out.emplace_back(from, to, f);
-        }
+        add(from, attacks_bishop(from, occAll) & to_mask);
     }
-
-    // Rooks
-    for (Bitboard b = bb.pcs[ci(us)][ROOK]; b; ){
+    for (Bitboard b = bb.pcs[US][ROOK]; b; ){
         Square from = Square(lsb(b)); pop_lsb(b);
-        Bitboard moves = attacks_rook(from, occAll) & ~occUs;
-        for (Bitboard m=moves; m; ){ Square to = Square(lsb(m)); pop_lsb(m);
-            MoveFlag f = (bb.occ[ci(them)] & SQ(to)) ? MF_CAPTURE : MF_QUIET;
-            out.emplace_back(from, to, f);
-        }
+        add(from, attacks_rook(from, occAll) & to_mask);
     }
-
-    // Queens
-    for (Bitboard b = bb.pcs[ci(us)][QUEEN]; b; ){
+    for (Bitboard b = bb.pcs[US][QUEEN]; b; ){
         Square from = Square(lsb(b)); pop_lsb(b);
-        Bitboard moves = (attacks_bishop(from, occAll)|attacks_rook(from, occAll)) & ~occUs;
-        for (Bitboard m=moves; m; ){ Square to = Square(lsb(m)); pop_lsb(m);
-            MoveFlag f = (bb.occ[ci(them)] & SQ(to)) ? MF_CAPTURE : MF_QUIET;
-            out.emplace_back(from, to, f);
-        }
+        add(from, (attacks_bishop(from, occAll)|attacks_rook(from, occAll)) & to_mask);
     }
 
-    // King + castling
-    {
-        Square from = king_square(us);
-        Bitboard moves = attacks_king(from) & ~occUs;
-        for (Bitboard m=moves; m; ){ Square to = Square(lsb(m)); pop_lsb(m);
-            MoveFlag f = (bb.occ[ci(them)] & SQ(to)) ? MF_CAPTURE : MF_QUIET;
-            out.emplace_back(from, to, f);
-        }
-        // Castling (basic: squares empty and not attacked)
-        if (us==WHITE){
-            if ((castling & CR_WK) && !(occAll & (SQ(F1)|SQ(G1))) &&
-                !square_attacked(E1, them) && !square_attacked(F1, them) && !square_attacked(G1, them)){
-                out.emplace_back(E1, G1, MF_CASTLE);
-            }
-            if ((castling & CR_WQ) && !(occAll & (SQ(D1)|SQ(C1)|SQ(B1))) &&
-                !square_attacked(E1, them) && !square_attacked(D1, them) && !square_attacked(C1, them)){
-                out.emplace_back(E1, C1, MF_CASTLE);
-            }
-        } else {
-            if ((castling & CR_BK) && !(occAll & (SQ(F8)|SQ(G8))) &&
-                !square_attacked(E8, them) && !square_attacked(F8, them) && !square_attacked(G8, them)){
-                out.emplace_back(E8, G8, MF_CASTLE);
-            }
-            if ((castling & CR_BQ) && !(occAll & (SQ(D8)|SQ(C8)|SQ(B8))) &&
-                !square_attacked(E8, them) && !square_attacked(D8, them) && !square_attacked(C8, them)){
-                out.emplace_back(E8, C8, MF_CASTLE);
-            }
-        }
+    // King + castling (squares empty and not attacked)
+    const Square from = king_square(Us);
+    add(from, attacks_king(from) & (Type==GenType::Evasions ? ~occUs : to_mask));
+    if constexpr (Type==GenType::All || Type==GenType::Quiets){
+        constexpr int R = Us==WHITE ? 0 : 56; // back rank offset
+        constexpr uint8_t K_SIDE = Us==WHITE ? CR_WK : CR_BK, Q_SIDE = Us==WHITE ? CR_WQ : CR_BQ;
+        auto safe = [&](int s){ return !attacked_by<Them>(Square(R+s)); };
+        if ((castling & K_SIDE) && !(occAll & (SQ(Square(R+F1))|SQ(Square(R+G1)))) && safe(E1) && safe(F1) && safe(G1))
+            out.emplace_back(R+E1, R+G1, MF_CASTLE);
+        if ((castling & Q_SIDE) && !(occAll & (SQ(Square(R+D1))|SQ(Square(R+C1))|SQ(Square(R+B1)))) && safe(E1) && safe(D1) && safe(C1))
+            out.emplace_back(R+E1, R+C1, MF_CASTLE);
+    }
+}
+
+template<class List>
+void BoardBB::generate_any(List& out, GenType type) const {
+    out.clear();
+    const bool w = side==WHITE;
+    switch (type){
+        case GenType::All:      w ? generate<WHITE, GenType::All>(out)      : generate<BLACK, GenType::All>(out);      break;
+        case GenType::Captures: w ? generate<WHITE, GenType::Captures>(out) : generate<BLACK, GenType::Captures>(out); break;
+        case GenType::Quiets:   w ? generate<WHITE, GenType::Quiets>(out)   : generate<BLACK, GenType::Quiets>(out);   break;
+        case GenType::Evasions: w ? generate<WHITE, GenType::Evasions>(out) : generate<BLACK, GenType::Evasions>(out); break;
     }
 }
 
+void BoardBB::generate_moves(std::vector<Move>& out, GenType type) const { generate_any(out, type); }
+void BoardBB::generate_moves(MoveList& out, GenType type) const { generate_any(out, type); }
+
 // Filter by king safety
+bool BoardBB::is_legal(Move m) const{
+    const Color us = side, them = other(side);
+    const Square from = Square(m.from()), to = Square(m.to());
+    Bitboard occ = (bb.occ_all ^ SQ(from)) | SQ(to);
+    Bitboard their = occ_side(them) & ~SQ(to);
+    Square k = king_square(us);
+    if (k == from){
+        k = to;
+        if (m.flag()==MF_CASTLE){ // the rook lands between the king and any attack along the rank
+            const int r = to & ~7;
+            occ ^= to%8 == 6 ? SQ(Square(r+H1)) | SQ(Square(r+F1)) : SQ(Square(r+A1)) | SQ(Square(r+D1));
+        }
+    } else if (m.flag()==MF_EP){
+        const Square cap = Square(us==WHITE ? to - 8 : to + 8);
+        occ ^= SQ(cap);
+        their ^= SQ(cap);
+    }
+    const auto& p = bb.pcs[ci(them)];
+    const Bitboard attackers = (attacks_pawn(us, k) & p[PAWN]) | (attacks_knight(k) & p[KNIGHT])
+        | (attacks_king(k) & p[KING]) | (attacks_bishop(k, occ) & (p[BISHOP] | p[QUEEN]))
+        | (attacks_rook(k, occ) & (p[ROOK] | p[QUEEN]));
+    return !(attackers & their);
+}
+
+int BoardBB::count_legal_moves() const{
+    MoveList ml;
+    const bool in_check = square_attacked(king_square(side), other(side));
+    generate_moves(ml, in_check ? GenType::Evasions : GenType::All);
+    int n = 0;
+    for (Move m : ml) n += is_legal(m);
+    return n;
+}
+
 void BoardBB::generate_legal_moves(std::vector<Move>& out){
-    std::vector<Move> tmp;
-    generate_moves(tmp);
+    MoveList tmp;
+    const bool in_check = square_attacked(king_square(side), other(side));
+    generate_moves(tmp, in_check ? GenType::Evasions : GenType::All);
     out.clear();
     for (auto m : tmp){
         do_move(m);
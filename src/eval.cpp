@@ -8,25 +8,29 @@ namespace chess {
 int evaluate(const Game& g) {
     const Board& b = g.get_board();
 
-    auto val = [&](const Piece* p)->int {
-        if (!p) return 0;
-        int s = (p->color==Color::White) ? +1 : -1;
-        if (dynamic_cast<const Pawn*>(p))   return 100*s;
-        if (dynamic_cast<const Knight*>(p)) return 320*s;
-        if (dynamic_cast<const Bishop*>(p)) return 330*s;
-        if (dynamic_cast<const Rook*>(p))   return 500*s;
-        if (dynamic_cast<const Queen*>(p))  return 900*s;
-        return 0; // King not scored here
+    auto val = [&](Piece p)->int {
+        if (p.empty()) return 0;
+        int s = (p.color()==Color::White) ? +1 : -1;
+        switch (p.type()) {
+            case PAWN:   return 100*s;
+            case KNIGHT: return 320*s;
+            case BISHOP: return 330*s;
+            case ROOK:   return 500*s;
+            case QUEEN:  return 900*s;
+            default:     return 0; // King not scored here
+        }
     };
 
     int score = 0;
     for (int r=0;r<ROWS;++r)
         for (int c=0;c<COLS;++c)
-            score += val(b.board[r][c].get());
+            score += val(b.board[r][c]);
 
     // Tiny mobility bonus for side to move
     Game tmp = g;
-    int my_moves = (int)tmp.legal_moves().size();
+    MoveList ml;
+    tmp.legal_moves(ml);
+    int my_moves = ml.size();
     score += (tmp.side_to_move()==Color::White ? +my_moves : -my_moves);
 
     return score; // positive = good for White
@@ -7,7 +7,6 @@
 #include <utility>
 #include <algorithm>
 #include <optional>
-#include <memory>
 
 namespace chess {
 
@@ -29,33 +28,37 @@ bool Game::in_check(Color col) const {
 bool Game::leaves_self_in_check(int r0,int c0,int r1,int c1,
                           std::optional<std::pair<int,int>> extra_capture)
 {
-    auto& from = b.board[r0][c0];
-    auto& to   = b.board[r1][c1];
-    if (!from) return true;
+    Piece& from = b.board[r0][c0];
+    Piece& to   = b.board[r1][c1];
+    if (from.empty()) return true;
 
-    Color mover = from->color;
+    Color mover = from.color();
 
     // Handle temporary EP removal (captured pawn behind the target square)
-    std::unique_ptr<Piece> ep_saved;
+    Piece ep_saved;
     int er=-1, ec=-1;
     if (extra_capture) {
         er = extra_capture->first;
         ec = extra_capture->second;
-        ep_saved = std::move(b.board[er][ec]); // temporarily remove captured pawn
+        ep_saved = b.board[er][ec]; // temporarily remove captured pawn
+        b.board[er][ec] = Piece();
     }
 
-    // ---- Proper capture simulation (no swap) ----
-    std::unique_ptr<Piece> captured = std::move(to);   // may be null
-    std::unique_ptr<Piece> moving   = std::move(from); // must exist
-    to   = std::move(moving);                          // piece now at destination
+    // ---- Capture simulation ----
+    const bool king_move = from.type()==KING;
+    Piece captured = to;   // may be empty
+    to   = from;           // piece now at destination
+    from = Piece();
+    if (king_move) b.set_king(mover, r1, c1);
 
     bool check = in_check(mover);
 
     // ---- Revert ----
-    from = std::move(to);           // move piece back to origin
-    to   = std::move(captured);     // restore captured piece (if any)
+    from = to;             // move piece back to origin
+    to   = captured;       // restore captured piece (if any)
+    if (king_move) b.set_king(mover, r0, c0);
     if (extra_capture) {
-        b.board[er][ec] = std::move(ep_saved); // restore EP-captured pawn
+        b.board[er][ec] = ep_saved; // restore EP-captured pawn
     }
 
     return check;
@@ -64,12 +67,11 @@ bool Game::leaves_self_in_check(int r0,int c0,int r1,int c1,
 bool Game::can_castle_king_side(Color col) const {
     int row = (col==Color::White) ? 0 : 7;
     int kcol = 4, rcol = 7;
-    const Piece* king = b.board[row][kcol].get();
-    const Piece* rook = b.board[row][rcol].get();
-    if (!king || !rook) return false;
-    if (!dynamic_cast<const King*>(king) || !dynamic_cast<const Rook*>(rook)) return false;
-    if (king->color!=col || rook->color!=col) return false;
-    if (king->hasMoved || rook->hasMoved) return false;
+    const Piece king = b.board[row][kcol];
+    const Piece rook = b.board[row][rcol];
+    if (king.type()!=KING || rook.type()!=ROOK) return false;
+    if (king.color()!=col || rook.color()!=col) return false;
+    if (king.has_moved() || rook.has_moved()) return false;
     if (!b.path_clear(row, kcol, row, rcol)) return false;
     if (in_check(col)) return false;
     if (b.attacks_square(other(col), row, kcol+1)) return false;
@@ -80,12 +82,11 @@ bool Game::can_castle_king_side(Color col) const {
 bool Game::can_castle_queen_side(Color col) const {
     int row = (col==Color::White) ? 0 : 7;
     int kcol = 4, rcol = 0;
-    const Piece* king = b.board[row][kcol].get();
-    const Piece* rook = b.board[row][rcol].get();
-    if (!king || !rook) return false;
-    if (!dynamic_cast<const King*>(king) || !dynamic_cast<const Rook*>(rook)) return false;
-    if (king->color!=col || rook->color!=col) return false;
-    if (king->hasMoved || rook->hasMoved) return false;
+    const Piece king = b.board[row][kcol];
+    const Piece rook = b.board[row][rcol];
+    if (king.type()!=KING || rook.type()!=ROOK) return false;
+    if (king.color()!=col || rook.color()!=col) return false;
+    if (king.has_moved() || rook.has_moved()) return false;
     if (!b.path_clear(row, kcol, row, rcol)) return false;
     if (in_check(col)) return false;
     if (b.attacks_square(other(col), row, kcol-1)) return false;
@@ -93,87 +94,110 @@ bool Game::can_castle_queen_side(Color col) const {
     return true;
 }
 
-void Game::do_castle_king_side(Color col) {
-    int row = (col==Color::White) ? 0 : 7;
-    // king e->g (4->6), rook h->f (7->5)
-    auto& king = b.board[row][4];
-    auto& rook = b.board[row][7];
-    b.board[row][6] = std::move(king);
-    b.board[row][5] = std::move(rook);
-    b.board[row][4].reset();
-    b.board[row][7].reset();
-    b.board[row][6]->hasMoved = true;
-    b.board[row][5]->hasMoved = true;
-}
-
-void Game::do_castle_queen_side(Color col) {
-    int row = (col==Color::White) ? 0 : 7;
-    // king e->c (4->2), rook a->d (0->3)
-    auto& king = b.board[row][4];
-    auto& rook = b.board[row][0];
-    b.board[row][2] = std::move(king);
-    b.board[row][3] = std::move(rook);
-    b.board[row][4].reset();
-    b.board[row][0].reset();
-    b.board[row][2]->hasMoved = true;
-    b.board[row][3]->hasMoved = true;
-}
-
-void Game::maybe_promote(int r1, int c1) {
-    if (!b.board[r1][c1]) return;
-    if (dynamic_cast<Pawn*>(b.board[r1][c1].get()) == nullptr) return;
+void Game::maybe_promote(int r1, int c1, PieceType promo) {
+    const Piece p = b.board[r1][c1];
+    if (p.type() != PAWN) return;
     // white promotes at row 7, black at row 0
-    if ((b.board[r1][c1]->color==Color::White && r1==7) ||
-        (b.board[r1][c1]->color==Color::Black && r1==0))
+    if ((p.color()==Color::White && r1==7) ||
+        (p.color()==Color::Black && r1==0))
     {
-        Color col = b.board[r1][c1]->color;
-        b.board[r1][c1] = std::make_unique<Queen>(col); // auto-queen
-        b.board[r1][c1]->hasMoved = true;
+        b.board[r1][c1] = Piece(promo, p.color(), true);
     }
 }
 
 bool Game::has_any_legal_move(Color col) {
-    for (int r0=0;r0<ROWS;++r0)
-        for (int c0=0;c0<COLS;++c0) {
-            Piece* p = b.board[r0][c0].get();
-            if (!p || p->color!=col) continue;
-
-            for (int r1=0;r1<ROWS;++r1)
-                for (int c1=0;c1<COLS;++c1) {
-                    if (r0==r1 && c0==c1) continue;
-
-                    // Special: castling
-                    if (dynamic_cast<King*>(p) && r0==r1 && std::abs(c1-c0)==2) {
-                        if (c1>c0 ? can_castle_king_side(col) : can_castle_queen_side(col))
-                            return true;
-                        continue;
-                    }
+    return gen_moves(col, nullptr);
+}
 
-                    // En passant possibility
-                    if (dynamic_cast<Pawn*>(p) && std::abs(c1-c0)==1) {
-                        int dir = (col==Color::White)?+1:-1;
-                        if (r1==r0+dir && b.is_empty(r1,c1) && ep.valid
-                            && ep.target_r==r1 && ep.target_c==c1 && ep.pawnColor!=col) {
-                            if (!leaves_self_in_check(r0,c0,r1,c1, std::make_pair(ep.captured_r,ep.captured_c)))
-                                return true;
-                            continue;
-                        }
-                    }
+// Legal moves for col, generated per piece type from its reachable squares.
+// With out==nullptr, stops and returns true at the first legal move.
+bool Game::gen_moves(Color col, MoveList* out) {
+    bool found = false;
+    auto add = [&](int r0,int c0,int r1,int c1, uint8_t flag) {
+        found = true;
+        if (!out) return;
+        const uint8_t from = uint8_t(r0*8+c0), to = uint8_t(r1*8+c1);
+        if (flag!=MF_EP && b.board[r0][c0].type()==PAWN && (r1==0 || r1==7)) {
+            out->push(Move(from, to, MF_PROMO_Q));
+            out->push(Move(from, to, MF_PROMO_R));
+            out->push(Move(from, to, MF_PROMO_B));
+            out->push(Move(from, to, MF_PROMO_N));
+            return;
+        }
+        out->push(Move(from, to, flag));
+    };
+    // Ordinary move or capture, if it does not leave our king attacked
+    auto try_to = [&](int r0,int c0,int r1,int c1) {
+        if (!leaves_self_in_check(r0, c0, r1, c1))
+            add(r0, c0, r1, c1, b.is_empty(r1, c1) ? MF_QUIET : MF_CAPTURE);
+    };
+    auto slide = [&](int r0,int c0, const int (&d)[2]) {
+        int r1 = r0 + d[0], c1 = c0 + d[1];
+        while (b.in_bounds(r1, c1) && !b.is_friend(r1, c1, col)) {
+            try_to(r0, c0, r1, c1);
+            if (!b.is_empty(r1, c1)) break;
+            r1 += d[0]; c1 += d[1];
+        }
+    };
+
+    const int dir = (col == Color::White) ? +1 : -1;
+    const int start_row = (col == Color::White) ? 1 : 6;
 
-                    // Normal pseudo-legal then legality check
-                    if (p->can_move(b,r0,c0,r1,c1)) {
-                        if (!leaves_self_in_check(r0,c0,r1,c1))
-                            return true;
+    for (int r0 = 0; r0 < ROWS; ++r0) for (int c0 = 0; c0 < COLS; ++c0) {
+        const Piece p = b.board[r0][c0];
+        if (p.empty() || p.color() != col) continue;
+
+        switch (p.type()) {
+            case PAWN: {
+                const int r1 = r0 + dir;
+                if (!b.in_bounds(r1, c0)) break;
+                if (b.is_empty(r1, c0)) {
+                    try_to(r0, c0, r1, c0);
+                    if (r0 == start_row && b.is_empty(r1 + dir, c0))
+                        try_to(r0, c0, r1 + dir, c0);
+                }
+                for (int c1 = c0 - 1; c1 <= c0 + 1; c1 += 2) {
+                    if (!b.in_bounds(r1, c1)) continue;
+                    if (b.is_enemy(r1, c1, col)) {
+                        try_to(r0, c0, r1, c1);
+                    } else if (ep.valid && ep.target_r == r1 && ep.target_c == c1 && ep.pawnColor != col
+                               && b.is_empty(r1, c1)) {
+                        if (!leaves_self_in_check(r0, c0, r1, c1, std::make_pair(ep.captured_r, ep.captured_c)))
+                            add(r0, c0, r1, c1, MF_EP);
                     }
                 }
+                break;
+            }
+            case KNIGHT:
+            case KING: {
+                // Castling only from the home e-file square
+                const int homeRow = (col == Color::White) ? 0 : 7;
+                if (p.type() == KING && r0 == homeRow && c0 == 4) {
+                    if (can_castle_king_side(col))  add(r0, c0, homeRow, 6, MF_CASTLE);
+                    if (can_castle_queen_side(col)) add(r0, c0, homeRow, 2, MF_CASTLE);
+                }
+                const auto& steps = (p.type() == KNIGHT) ? KNIGHT_STEPS : KING_STEPS;
+                for (const auto& d : steps) {
+                    const int r1 = r0 + d[0], c1 = c0 + d[1];
+                    if (b.in_bounds(r1, c1) && !b.is_friend(r1, c1, col))
+                        try_to(r0, c0, r1, c1);
+                }
+                break;
+            }
+            case BISHOP: for (const auto& d : DIAG_STEPS) slide(r0, c0, d); break;
+            case ROOK:   for (const auto& d : ORTH_STEPS) slide(r0, c0, d); break;
+            case QUEEN:
+                for (const auto& d : DIAG_STEPS) slide(r0, c0, d);
+                for (const auto& d : ORTH_STEPS) slide(r0, c0, d);
+                break;
+            default: break;
         }
-    return false;
+        if (found && !out) return true;
+    }
+    return found;
 }
 
-// ---- public methods ----
 Game::Game() { b.create_board(); }
-Game::Game(const Game& g) : b(g.b), turn(g.turn), ep(g.ep) {}
-Game& Game::operator=(const Game& g){ b=g.b; turn=g.turn; ep=g.ep; return *this; }
 
 void Game::print() const { b.display_board(); }
 
@@ -201,19 +225,19 @@ bool Game::move(const std::string& input, std::string& errmsg) {
         return false;
     }
 
-    auto& src = b.board[r0][c0];
-    if (!src) {
+    const Piece src = b.board[r0][c0];
+    if (src.empty()) {
         errmsg = "No piece at origin";
         return false;
     }
-    if (src->color != turn) {
+    if (src.color() != turn) {
         errmsg = std::string("It's ") + to_cstr_local(turn) + "'s turn";
         return false;
     }
 
     // Optional sanity: if a letter was supplied, check it matches
     if (letter!='?') {
-        char disp = src->display()[0];
+        char disp = src.display();
         if (std::tolower(static_cast<unsigned char>(disp)) != std::tolower(static_cast<unsigned char>(letter))) {
             errmsg = "Piece letter doesn't match the origin square";
             return false;
@@ -221,22 +245,18 @@ bool Game::move(const std::string& input, std::string& errmsg) {
     }
 
     // ---------- Castling ----------
-    if (dynamic_cast<King*>(src.get()) && r0==r1 && std::abs(c1-c0)==2) {
+    if (src.type()==KING && r0==r1 && std::abs(c1-c0)==2) {
         bool kingside = (c1>c0);
-        if (kingside ? can_castle_king_side(turn) : can_castle_queen_side(turn)) {
-            if (kingside) do_castle_king_side(turn);
-            else          do_castle_queen_side(turn);
-            ep.valid = false; // EP cleared on any non-double-pawn move
-            turn = other(turn);
-            return true;
-        } else {
+        if (!(kingside ? can_castle_king_side(turn) : can_castle_queen_side(turn))) {
             errmsg = "Castling not allowed now";
             return false;
         }
+        Undo u; make_move(r0,c0,r1,c1,QUEEN,u); // CLI input auto-queens
+        return true;
     }
 
     // ---------- En passant ----------
-    if (dynamic_cast<Pawn*>(src.get()) && std::abs(c1-c0)==1) {
+    if (src.type()==PAWN && std::abs(c1-c0)==1) {
         int dir = (turn==Color::White)?+1:-1;
         if (r1==r0+dir && b.is_empty(r1,c1) && ep.valid
             && ep.target_r==r1 && ep.target_c==c1 && ep.pawnColor!=turn) {
@@ -245,21 +265,13 @@ bool Game::move(const std::string& input, std::string& errmsg) {
                 errmsg = "Move would leave king in check";
                 return false;
             }
-            // perform EP capture
-            b.board[ep.captured_r][ep.captured_c].reset();
-            b.board[r1][c1] = std::move(b.board[r0][c0]);
-            b.board[r0][c0].reset();
-            b.board[r1][c1]->hasMoved = true;
-
-            maybe_promote(r1,c1);
-            ep.valid = false;
-            turn = other(turn);
+            Undo u; make_move(r0,c0,r1,c1,QUEEN,u); // CLI input auto-queens
             return true;
         }
     }
 
     // ---------- Normal move (pseudo-legal + king safety) ----------
-    if (!src->can_move(b,r0,c0,r1,c1)) {
+    if (!can_move(b,r0,c0,r1,c1)) {
         errmsg = "Illegal move for that piece";
         return false;
     }
@@ -268,32 +280,71 @@ bool Game::move(const std::string& input, std::string& errmsg) {
         return false;
     }
 
-    // Execute normal move
-    b.board[r1][c1].reset(); // drop captured piece if any
-    b.board[r1][c1] = std::move(b.board[r0][c0]);
-    b.board[r0][c0].reset();
-    b.board[r1][c1]->hasMoved = true;
+    Undo u; make_move(r0,c0,r1,c1,QUEEN,u); // CLI input auto-queens
+    return true;
+}
 
-    // EP bookkeeping
+void Game::make_move(Move m, Undo& u) {
+    const PieceType promo = m.is_promo() ? PieceType(m.flag()-MF_PROMO_N+KNIGHT) : QUEEN;
+    make_move(m.from()/8, m.from()%8, m.to()/8, m.to()%8, promo, u);
+}
+
+void Game::make_move(int r0,int c0,int r1,int c1, PieceType promo, Undo& u) {
+    u.r0 = r0; u.c0 = c0; u.r1 = r1; u.c1 = c1;
+    u.moved    = b.board[r0][c0];
+    u.captured = b.board[r1][c1];
+    u.cap_r = r1; u.cap_c = c1;
+    u.rook_c0 = u.rook_c1 = -1;
+    u.ep = ep;
+
+    const PieceType t = u.moved.type();
+    if (t==KING && r0==r1 && std::abs(c1-c0)==2) {
+        // castling: rook h->f (kingside) or a->d (queenside)
+        u.rook_c0 = (c1>c0) ? 7 : 0;
+        u.rook_c1 = (c1>c0) ? 5 : 3;
+        u.rook = b.board[r0][u.rook_c0];
+        b.board[r0][u.rook_c1] = u.rook;
+        b.board[r0][u.rook_c1].set_moved();
+        b.board[r0][u.rook_c0] = Piece();
+    } else if (t==PAWN && c0!=c1 && u.captured.empty()) {
+        // en passant: the captured pawn stands behind the target square
+        u.cap_r = ep.captured_r; u.cap_c = ep.captured_c;
+        u.captured = b.board[u.cap_r][u.cap_c];
+        b.board[u.cap_r][u.cap_c] = Piece();
+    }
+
+    b.board[r1][c1] = u.moved; // drops captured piece if any
+    b.board[r0][c0] = Piece();
+    b.board[r1][c1].set_moved();
+    maybe_promote(r1,c1,promo);
+    if (t==KING) b.set_king(turn, r1, c1);
+
+    // EP bookkeeping (cleared on any non-double-pawn move)
     ep.valid = false;
-    if (dynamic_cast<Pawn*>(b.board[r1][c1].get())) {
+    if (t==PAWN && std::abs(r1 - r0) == 2) {
         int dir = (turn==Color::White)?+1:-1;
-        if (std::abs(r1 - r0) == 2) {
-            ep.valid = true;
-            ep.target_r = r0 + dir;
-            ep.target_c = c0;
-            ep.captured_r = r1;
-            ep.captured_c = c0;
-            ep.pawnColor  = turn;
-        }
+        ep.valid = true;
+        ep.target_r = r0 + dir;
+        ep.target_c = c0;
+        ep.captured_r = r1;
+        ep.captured_c = c0;
+        ep.pawnColor  = turn;
     }
 
-    // Promotion
-    maybe_promote(r1,c1);
+    turn = other(turn);
+}
 
-    // Switch sides
+void Game::unmake_move(const Undo& u) {
     turn = other(turn);
-    return true;
+    ep = u.ep;
+    b.board[u.r1][u.c1] = Piece();
+    b.board[u.cap_r][u.cap_c] = u.captured; // destination, or the EP square
+    b.board[u.r0][u.c0] = u.moved;          // original piece: pawn before promotion, old hasMoved
+    if (u.rook_c0 >= 0) {
+        b.board[u.r0][u.rook_c1] = Piece();
+        b.board[u.r0][u.rook_c0] = u.rook;
+    }
+    if (u.moved.type()==KING) b.set_king(turn, u.r0, u.c0);
 }
 
 bool Game::is_checkmate(Color col) {
@@ -303,52 +354,24 @@ bool Game::is_stalemate(Color col) {
     return !in_check(col) && !has_any_legal_move(col);
 }
 
-std::vector<std::string> Game::legal_moves() {
-    std::vector<std::string> out;
-    auto fmt = [](int r, int c){
-        std::string s; s.push_back(char('0'+r)); s.push_back(char('0'+c));
-        return s;
-    };
-
-    for (int r0 = 0; r0 < ROWS; ++r0) for (int c0 = 0; c0 < COLS; ++c0) {
-        const Piece* p = b.board[r0][c0].get();
-        if (!p || p->color != turn) continue;
-
-        // ---- Castling: add once per king on the home e-file ----
-        if (dynamic_cast<const King*>(p)) {
-            int homeRow = (turn == Color::White) ? 0 : 7;
-
-            // Castling is only generated if King is on its home square (r0, c0) = (0,4) or (7,4)
-            if (r0 == homeRow && c0 == 4) {
-                // kingside e->g
-                if (can_castle_king_side(turn))
-                    out.push_back(fmt(r0, c0) + " " + fmt(homeRow, 6));
-                // queenside e->c
-                if (can_castle_queen_side(turn))
-                    out.push_back(fmt(r0, c0) + " " + fmt(homeRow, 2));
-            }
-        }
+void Game::legal_moves(MoveList& out) {
+    out.clear();
+    gen_moves(turn, &out);
+}
 
-        // ---- Normal moves / EP (scan destinations) ----
-        for (int r1 = 0; r1 < ROWS; ++r1) for (int c1 = 0; c1 < COLS; ++c1) {
-            if (r0 == r1 && c0 == c1) continue;
-
-            // En passant (mirror move() logic)
-            if (dynamic_cast<const Pawn*>(p) && std::abs(c1 - c0) == 1) {
-                int dir = (turn == Color::White) ? +1 : -1;
-                if (r1 == r0 + dir && b.is_empty(r1, c1) && ep.valid
-                    && ep.target_r == r1 && ep.target_c == c1 && ep.pawnColor != turn) {
-                    if (!leaves_self_in_check(r0, c0, r1, c1, std::make_pair(ep.captured_r, ep.captured_c)))
-                        out.push_back(fmt(r0, c0) + " " + fmt(r1, c1));
-                    continue;
-                }
-            }
+std::string Game::format_move(Move m) {
+    std::string s = "00 00";
+    s[0] = char('0' + m.from()/8); s[1] = char('0' + m.from()%8);
+    s[3] = char('0' + m.to()/8);   s[4] = char('0' + m.to()%8);
+    return s;
+}
 
-            // King normal moves are ONLY one-square now; castling handled above
-            if (p->can_move(b, r0, c0, r1, c1) && !leaves_self_in_check(r0, c0, r1, c1))
-                out.push_back(fmt(r0, c0) + " " + fmt(r1, c1));
-        }
-    }
+std::vector<std::string> Game::legal_moves() {
+    MoveList ml;
+    legal_moves(ml);
+    std::vector<std::string> out;
+    for (Move m : ml)
+        if (!m.is_promo() || m.flag()==MF_PROMO_Q) out.push_back(format_move(m));
     return out;
 }
 
@@ -368,17 +391,15 @@ void Game::loop() {
             continue;
         }
 
-        if (is_checkmate(turn)) {
-            b.display_board();
-            std::cout << "Checkmate! " << to_cstr_local(other(turn)) << " wins.\n";
-            break;
-        }
-        if (is_stalemate(turn)) {
+        // one legal-move probe decides both mate and stalemate
+        const bool check = in_check(turn);
+        if (!has_any_legal_move(turn)) {
             b.display_board();
-            std::cout << "Stalemate! Draw.\n";
+            if (check) std::cout << "Checkmate! " << to_cstr_local(other(turn)) << " wins.\n";
+            else       std::cout << "Stalemate! Draw.\n";
             break;
         }
-        if (in_check(turn)) {
+        if (check) {
             std::cout << "Check on " << to_cstr_local(turn) << "!\n";
         }
     }
@@ -401,20 +422,21 @@ bool Game::load_fen(const std::string& fen, std::string& errmsg) {
         if (std::isdigit(static_cast<unsigned char>(ch))) { c += (ch - '0'); continue; }
         if (c > 7 || r < 0) { errmsg = "Bad FEN: placement overflow"; return false; }
 
-        std::unique_ptr<Piece> up;
+        PieceType pt;
         Color col = std::isupper(static_cast<unsigned char>(ch)) ? Color::White : Color::Black;
         char pc = std::tolower(static_cast<unsigned char>(ch));
         switch (pc) {
-            case 'p': up = std::make_unique<Pawn>(col);   break;
-            case 'n': up = std::make_unique<Knight>(col); break;
-            case 'b': up = std::make_unique<Bishop>(col); break;
-            case 'r': up = std::make_unique<Rook>(col);   break;
-            case 'q': up = std::make_unique<Queen>(col);  break;
-            case 'k': up = std::make_unique<King>(col);   break;
+            case 'p': pt = PAWN;   break;
+            case 'n': pt = KNIGHT; break;
+            case 'b': pt = BISHOP; break;
+            case 'r': pt = ROOK;   break;
+            case 'q': pt = QUEEN;  break;
+            case 'k': pt = KING;   break;
             default: errmsg = "Bad FEN: bad piece"; return false;
         }
-        b.board[r][c++] = std::move(up);
+        b.board[r][c++] = Piece(pt, col);
     }
+    b.locate_kings();
 
     if (stm == "w") turn = Color::White;
     else if (stm == "b") turn = Color::Black;
@@ -422,13 +444,13 @@ bool Game::load_fen(const std::string& fen, std::string& errmsg) {
 
     // --- castling rights: default to "moved" (no castling), then enable only if pieces present
     auto setMoved = [&](int rr, int cc, bool moved){
-        if (b.board[rr][cc]) b.board[rr][cc]->hasMoved = moved;
+        if (!b.board[rr][cc].empty()) b.board[rr][cc].set_moved(moved);
     };
     auto kingAt = [&](int rr, int cc){
-        return b.board[rr][cc] && dynamic_cast<King*>(b.board[rr][cc].get());
+        return b.board[rr][cc].type() == KING;
     };
     auto rookAt = [&](int rr, int cc){
-        return b.board[rr][cc] && dynamic_cast<Rook*>(b.board[rr][cc].get());
+        return b.board[rr][cc].type() == ROOK;
     };
 
     // Disable all by default
@@ -494,9 +516,14 @@ void Game::loop_with_strategies(Strategy* white, Strategy* black) {
         std::string err;
         if (!move(line, err)) { std::cout << "Invalid: " << err << "\n"; continue; }
 
-        if (is_checkmate(turn)) { b.display_board(); std::cout << "Checkmate! " << to_cstr_local(other(turn)) << " wins.\n"; break; }
-        if (is_stalemate(turn)) { b.display_board(); std::cout << "Stalemate! Draw.\n"; break; }
-        if (in_check(turn))     { std::cout << "Check on " << to_cstr_local(turn) << "!\n"; }
+        const bool check = in_check(turn);
+        if (!has_any_legal_move(turn)) {
+            b.display_board();
+            if (check) std::cout << "Checkmate! " << to_cstr_local(other(turn)) << " wins.\n";
+            else       std::cout << "Stalemate! Draw.\n";
+            break;
+        }
+        if (check) { std::cout << "Check on " << to_cstr_local(turn) << "!\n"; }
     }
 }
 
@@ -4,6 +4,8 @@
 #include "chess/attacks.hpp"
 #include "chess/board_bb.hpp"
 #include "chess/search_bb.hpp"
+#include "chess/san.hpp"
+#include "chess/polyglot.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -11,6 +13,7 @@
 #include <sstream>
 #include <thread>
 #include <chrono>
+#include <random>
 
 using namespace chess;
 
@@ -150,6 +153,23 @@ static bool pick_move_from_to(BoardBB& pos, int r0,int c0,int r1,int c1, Move& o
     return found;
 }
 
+// SAN ("Nf3", "exd5", "O-O") first, then the coordinate forms above
+static bool read_bb_move(BoardBB& pos, const std::string& line, Move& out, bool& bad_format) {
+    bad_format = false;
+    if (line.find(' ') == std::string::npos && (out = parse_san(pos, line)).v) return true;
+    int r0,c0,r1,c1;
+    if (!parse_engine_move(line, r0,c0,r1,c1)) { bad_format = true; return false; }
+    return pick_move_from_to(pos, r0,c0,r1,c1, out);
+}
+
+// Book move if the book knows pos (weighted pick), otherwise a fixed-depth search
+static Move engine_move(BoardBB& pos, int depth, const PolyglotBook& book, bool& from_book) {
+    static std::mt19937_64 rng{std::random_device{}()};
+    Move m = book.is_open() ? book.pick(pos, BookPick::Weighted, rng()) : Move();
+    from_book = m.v != 0;
+    return from_book ? m : search_best_move(pos, depth);
+}
+
 static const char* to_cstr_color(Color c) {
     return c==Color::White ? "white" : (c==Color::Black ? "black" : "none");
 }
@@ -159,7 +179,7 @@ static void cli_bitboard_hvh(){
     BoardBB pos; pos.set_startpos();
     while (true) {
         std::cout << "\n" << to_cstr_color(pos.side)
-          << " to move. Enter like 'pa1 a3' or 'a1 a3' (commas ok), or '10 30'. Type 'quit' to exit.\n";
+          << " to move. Enter SAN like 'Nf3', or 'pa1 a3' / 'a1 a3' (commas ok), or '10 30'. Type 'quit' to exit.\n";
         /*std::cout << "\n" << to_cstr_color(pos.side) << " to move. Enter (e.g.) 10 30. Type 'quit' to exit.\n";*/
         display_board_bb(pos);
         std::cout << "> ";
@@ -168,11 +188,10 @@ static void cli_bitboard_hvh(){
         if (line=="quit" || line=="exit") break;
         if (line.empty()) continue;
 
-        int r0,c0,r1,c1;
-        if (!parse_engine_move(line, r0,c0,r1,c1)) { std::cout << "Invalid format.\n"; continue; }
-
-        Move m;
-        if (!pick_move_from_to(pos, r0,c0,r1,c1, m)) { std::cout << "Not a legal move.\n"; continue; }
+        Move m; bool bad_format;
+        if (!read_bb_move(pos, line, m, bad_format)) {
+            std::cout << (bad_format ? "Invalid format.\n" : "Not a legal move.\n"); continue;
+        }
         pos.do_move(m);
 
         std::vector<Move> reply; pos.generate_legal_moves(reply);
@@ -188,13 +207,13 @@ static void cli_bitboard_hvh(){
     }
 }
 
-static void cli_bitboard_hvai(bool humanIsWhite, int aiDepth){
+static void cli_bitboard_hvai(bool humanIsWhite, int aiDepth, const PolyglotBook& book){
     BoardBB pos; pos.set_startpos();
 
-    auto human_move = [&](Color who)->bool{
+    auto human_move = [&]([[maybe_unused]] Color who)->bool{
         while (true){
             std::cout << "\n" << to_cstr_color(pos.side)
-          << " to move. Enter like 'pa1 a3' or 'a1 a3' (commas ok), or '10 30'. Type 'quit' to exit.\n";
+          << " to move. Enter SAN like 'Nf3', or 'pa1 a3' / 'a1 a3' (commas ok), or '10 30'. Type 'quit' to exit.\n";
             /*std::cout << "\n" << to_cstr_color(who) << " to move. Enter (e.g.) 10 30, or 'quit'.\n";*/
             display_board_bb(pos);
             std::cout << "> ";
@@ -203,10 +222,10 @@ static void cli_bitboard_hvai(bool humanIsWhite, int aiDepth){
             if (line=="quit" || line=="exit") return false;
             if (line.empty()) continue;
 
-            int r0,c0,r1,c1;
-            if (!parse_engine_move(line, r0,c0,r1,c1)) { std::cout << "Invalid format.\n"; continue; }
-            Move m;
-            if (!pick_move_from_to(pos, r0,c0,r1,c1, m)) { std::cout << "Not a legal move.\n"; continue; }
+            Move m; bool bad_format;
+            if (!read_bb_move(pos, line, m, bad_format)) {
+                std::cout << (bad_format ? "Invalid format.\n" : "Not a legal move.\n"); continue;
+            }
             pos.do_move(m);
             return true;
         }
@@ -215,8 +234,10 @@ static void cli_bitboard_hvai(bool humanIsWhite, int aiDepth){
     auto ai_move = [&](Color who)->bool{
         std::vector<Move> ml; pos.generate_legal_moves(ml);
         if (ml.empty()) return false;
-        Move best = search_best_move(pos, aiDepth);
-        std::cout << to_cstr_color(who) << " (AI, depth " << aiDepth << ") plays " << to_uci(best) << "\n";
+        bool from_book;
+        Move best = engine_move(pos, aiDepth, book, from_book);
+        std::cout << to_cstr_color(who) << " (AI, " << (from_book ? std::string("book") : "depth " + std::to_string(aiDepth))
+                  << ") plays " << to_san(pos, best) << "\n";
         pos.do_move(best);
         return true;
     };
@@ -248,7 +269,7 @@ static void cli_bitboard_hvai(bool humanIsWhite, int aiDepth){
     }
 }
 
-static void cli_bitboard_aivai(int depthW, int depthB, int msDelay=150){
+static void cli_bitboard_aivai(int depthW, int depthB, const PolyglotBook& book, int msDelay=150){
     BoardBB pos; pos.set_startpos();
     while (true){
         display_board_bb(pos);
@@ -260,17 +281,35 @@ static void cli_bitboard_aivai(int depthW, int depthB, int msDelay=150){
             break;
         }
         int d = (pos.side==WHITE? depthW : depthB);
-        Move best = search_best_move(pos, d);
-        std::cout << to_cstr_color(pos.side) << " (AI d" << d << ") plays " << to_uci(best) << "\n";
+        bool from_book;
+        Move best = engine_move(pos, d, book, from_book);
+        std::cout << to_cstr_color(pos.side) << " (AI " << (from_book ? std::string("book") : "d" + std::to_string(d))
+                  << ") plays " << to_san(pos, best) << "\n";
         pos.do_move(best);
         std::this_thread::sleep_for(std::chrono::milliseconds(msDelay));
     }
 }
 
 // ---- Your original OOP engine loop remains below ----
-int main() {
+// chess_app [--keys <Random64 table>] [--book <polyglot.bin>]   (the book is used by the
+// bitboard AI modes, and only with the reference keys; see load_polyglot_random64)
+int main(int argc, char** argv) {
     chess::init_attacks();
 
+    PolyglotBook book;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "--keys") continue;
+        MappedFile f;
+        if (!f.open(argv[++i]) || !load_polyglot_random64(f.view()))
+            std::cout << "No reference Random64 table in " << argv[i] << "\n";
+    }
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "--book") continue;
+        if (!polyglot_keys_standard()) { std::cout << "Book " << argv[++i] << " needs --keys\n"; continue; }
+        if (book.open(argv[++i])) std::cout << "Book " << argv[i] << ": " << book.size() << " entries\n";
+        else std::cout << "Cannot open book " << argv[i] << "\n";
+    }
+
     Game game;
     MinimaxStrategy aiWhite, aiBlack;
     aiWhite.max_depth = 3; aiBlack.max_depth = 3;
@@ -293,9 +332,9 @@ int main() {
 
     switch (mode){
         case 5: cli_bitboard_hvh(); return 0;
-        case 6: cli_bitboard_hvai(true,  6 /*depth*/); return 0;
-        case 7: cli_bitboard_hvai(false, 6 /*depth*/); return 0;
-        case 8: cli_bitboard_aivai(6,6,150); return 0;
+        case 6: cli_bitboard_hvai(true,  6 /*depth*/, book); return 0;
+        case 7: cli_bitboard_hvai(false, 6 /*depth*/, book); return 0;
+        case 8: cli_bitboard_aivai(6,6,book,150); return 0;
         default: break; // fall through to classic engine modes
     }
 
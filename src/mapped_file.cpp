@@ -0,0 +1,76 @@
+#include "chess/mapped_file.hpp"
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHESS_HAVE_MMAP 1
+#else
+#define CHESS_HAVE_MMAP 0
+#endif
+
+namespace chess {
+
+bool MappedFile::open(const std::string& path, bool sequential){
+    close();
+#if CHESS_HAVE_MMAP
+    if (path != "-"){
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)){
+            size_ = size_t(st.st_size);
+            if (size_ == 0){ ::close(fd); open_ = true; return true; }
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED){ size_ = 0; return false; }
+            ::madvise(p, size_, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            data_ = static_cast<const char*>(p);
+            mapped_ = open_ = true;
+            return true;
+        }
+        ::close(fd);
+    }
+#endif
+    std::FILE* f = (path == "-") ? stdin : std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    constexpr size_t CHUNK = size_t(1) << 20;
+    for (;;){
+        size_t old = buf_.size();
+        buf_.resize(old + CHUNK);
+        size_t n = std::fread(&buf_[old], 1, CHUNK, f);
+        buf_.resize(old + n);
+        if (n < CHUNK) break;
+    }
+    if (f != stdin) std::fclose(f);
+    data_ = buf_.data();
+    size_ = buf_.size();
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close(){
+#if CHESS_HAVE_MMAP
+    if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+    data_ = nullptr; size_ = 0;
+    open_ = mapped_ = false;
+    buf_.clear(); buf_.shrink_to_fit();
+}
+
+bool LineCursor::next(std::string_view& line){
+    if (pos_ >= text_.size()) return false;
+    const char* base = text_.data() + pos_;
+    const void* nl = std::memchr(base, '\n', text_.size() - pos_);
+    size_t len = nl ? size_t(static_cast<const char*>(nl) - base) : text_.size() - pos_;
+    pos_ += len + (nl ? 1 : 0);
+    if (len && base[len-1] == '\r') --len;
+    line = std::string_view(base, len);
+    ++line_no_;
+    return true;
+}
+
+} // namespace chess
@@ -0,0 +1,166 @@
+#include "chess/pgn.hpp"
+#include "chess/san.hpp"
+#include <cstring>
+#include <thread>
+
+namespace chess {
+
+const char* to_cstr(GameResult r){
+    switch (r){
+        case GameResult::WhiteWin: return "1-0";
+        case GameResult::BlackWin: return "0-1";
+        case GameResult::Draw:     return "1/2-1/2";
+        default:                   return "*";
+    }
+}
+
+static bool parse_result(std::string_view t, GameResult& r){
+    if (t=="1-0")     { r = GameResult::WhiteWin; return true; }
+    if (t=="0-1")     { r = GameResult::BlackWin; return true; }
+    if (t=="1/2-1/2") { r = GameResult::Draw;     return true; }
+    if (t=="*")       { r = GameResult::Unknown;  return true; }
+    return false;
+}
+
+// ---- tokenizer ----
+
+static inline bool pgn_space(char c){ return c==' ' || c=='\t' || c=='\n' || c=='\r'; }
+
+bool PgnReader::next_game(PgnVisitor& v){
+    const char* s = text_.data();
+    const size_t n = text_.size();
+    size_t& p = pos_;
+    auto skip_ws = [&]{ while (p<n && pgn_space(s[p])) ++p; };
+    auto skip_line = [&]{ while (p<n && s[p]!='\n') ++p; };
+
+    skip_ws();
+    if (p >= n) return false;
+
+    v.begin_game();
+    board_.set_startpos();
+    GameResult result = GameResult::Unknown;
+    bool ok = true;
+
+    // tag pairs: [Name "value"]
+    while (p<n && s[p]=='['){
+        size_t b = ++p;
+        while (p<n && !pgn_space(s[p]) && s[p]!='"' && s[p]!=']') ++p;
+        std::string_view name(s+b, p-b), value;
+        while (p<n && s[p]!='"' && s[p]!=']' && s[p]!='\n') ++p;
+        if (p<n && s[p]=='"'){
+            b = ++p;
+            while (p<n && s[p]!='"' && s[p]!='\n'){ if (s[p]=='\\' && p+1<n) ++p; ++p; }
+            value = std::string_view(s+b, p-b);
+        }
+        skip_line();
+        v.header(name, value);
+        if (name=="Result") parse_result(value, result);
+        else if (name=="FEN" && board_.parse_fen(value)!=FenError::Ok) ok = false;
+        skip_ws();
+    }
+
+    // movetext, up to the termination marker (or the next tag section)
+    GameResult term = result;
+    while (true){
+        skip_ws();
+        if (p>=n || s[p]=='[') break;
+        const char c = s[p];
+        if (c=='{'){ const void* e = std::memchr(s+p, '}', n-p); p = e ? size_t(static_cast<const char*>(e)-s)+1 : n; continue; }
+        if (c==';' || (c=='%' && (p==0 || s[p-1]=='\n'))){ skip_line(); continue; }
+        if (c=='('){
+            // variations nest and may hold comments
+            int depth = 0;
+            for (; p<n; ++p){
+                if (s[p]=='{'){ while (p<n && s[p]!='}') ++p; }
+                else if (s[p]=='(') ++depth;
+                else if (s[p]==')' && --depth==0){ ++p; break; }
+            }
+            continue;
+        }
+        if (c==')'){ ++p; continue; }
+        if (c=='$'){ ++p; while (p<n && s[p]>='0' && s[p]<='9') ++p; continue; }
+
+        size_t b = p;
+        while (p<n && !pgn_space(s[p]) && !std::strchr("{}();[", s[p])) ++p;
+        std::string_view tok(s+b, p-b);
+
+        if (parse_result(tok, term)) break;
+        // move number: "12." / "12..." possibly glued to the move ("12.e4")
+        size_t d = 0;
+        while (d<tok.size() && tok[d]>='0' && tok[d]<='9') ++d;
+        if (d && d<tok.size() && tok[d]=='.'){
+            while (d<tok.size() && tok[d]=='.') ++d;
+            tok.remove_prefix(d);
+        }
+        if (tok.empty() || !ok) continue;
+
+        Move m = parse_san(board_, tok);
+        if (!m.v){ ok = false; continue; }
+        v.ply(board_, m, result);
+        board_.do_move(m);
+        ++stats_.plies;
+    }
+
+    ++stats_.games;
+    if (!ok) ++stats_.errors;
+    v.end_game(result!=GameResult::Unknown ? result : term, ok);
+    return true;
+}
+
+// ---- parallel reading ----
+
+// Is the line ending just before line start p empty (or is p the start of text)?
+static bool prev_line_blank(std::string_view t, size_t p){
+    if (p==0) return true;
+    size_t e = p-1; // the '\n' that ends the previous line
+    size_t b = (e==0) ? std::string_view::npos : t.rfind('\n', e-1);
+    b = (b==std::string_view::npos) ? 0 : b+1;
+    return t.substr(b, e-b).find_first_not_of(" \t\r")==std::string_view::npos;
+}
+
+// Start of the first tag line at or after `from` that follows a blank line
+static size_t next_game_start(std::string_view t, size_t from){
+    size_t p = from;
+    if (p && t[p-1]!='\n'){
+        p = t.find('\n', p);
+        if (p==std::string_view::npos) return t.size();
+        ++p;
+    }
+    while (p < t.size()){
+        if (t[p]=='[' && prev_line_blank(t, p)) return p;
+        p = t.find('\n', p);
+        if (p==std::string_view::npos) break;
+        ++p;
+    }
+    return t.size();
+}
+
+std::vector<std::string_view> split_pgn(std::string_view text, int parts){
+    std::vector<std::string_view> out;
+    size_t start = 0;
+    for (int k=1; k<=parts && start<text.size(); ++k){
+        size_t cut = (k==parts) ? text.size() : next_game_start(text, std::max(start+1, text.size()*size_t(k)/size_t(parts)));
+        if (cut > start) out.push_back(text.substr(start, cut-start));
+        start = cut;
+    }
+    return out;
+}
+
+PgnStats read_pgn_parallel(std::string_view text, const std::vector<PgnVisitor*>& visitors){
+    auto parts = split_pgn(text, int(visitors.size()));
+    std::vector<PgnStats> stats(parts.size());
+    std::vector<std::thread> pool;
+    for (size_t i=0; i<parts.size(); ++i){
+        pool.emplace_back([&, i]{
+            PgnReader r(parts[i]);
+            while (r.next_game(*visitors[i])) {}
+            stats[i] = r.stats();
+        });
+    }
+    for (auto& t : pool) t.join();
+    PgnStats all;
+    for (const auto& s : stats) all.merge(s);
+    return all;
+}
+
+} // namespace chess
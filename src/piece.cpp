@@ -5,40 +5,15 @@
 
 namespace chess {
 
-// ---- ctors / displays ----
-Pawn::Pawn(Color col)     : Piece(col) {}
-Knight::Knight(Color col) : Piece(col) {}
-Bishop::Bishop(Color col) : Piece(col) {}
-Rook::Rook(Color col)     : Piece(col) {}
-Queen::Queen(Color col)   : Piece(col) {}
-King::King(Color col)     : Piece(col) {}
-
-Empty_Square::Empty_Square() : Piece(Color::None) {}
-std::string Empty_Square::display() const { return "-"; }
-bool Empty_Square::can_move(const Board&, int, int, int, int) const { return false; }
-std::unique_ptr<Piece> Empty_Square::clone() const {
-    return std::make_unique<Empty_Square>(*this);
+char Piece::display() const {
+    if (empty()) return '-';
+    const char map[6] = {'P','N','B','R','Q','K'};
+    char ch = map[type()];
+    return color() == Color::White ? ch : char(ch - 'A' + 'a');
 }
 
-std::string Pawn::display()   const { return (color == Color::White) ? "P" : "p"; }
-std::string Knight::display() const { return (color == Color::White) ? "N" : "n"; }
-std::string Bishop::display() const { return (color == Color::White) ? "B" : "b"; }
-std::string Rook::display()   const { return (color == Color::White) ? "R" : "r"; }
-std::string Queen::display()  const { return (color == Color::White) ? "Q" : "q"; }
-std::string King::display()   const { return (color == Color::White) ? "K" : "k"; }
-
-std::unique_ptr<Piece> Pawn::clone()   const { return std::make_unique<Pawn>(*this); }
-std::unique_ptr<Piece> Knight::clone() const { return std::make_unique<Knight>(*this); }
-std::unique_ptr<Piece> Bishop::clone() const { return std::make_unique<Bishop>(*this); }
-std::unique_ptr<Piece> Rook::clone()   const { return std::make_unique<Rook>(*this); }
-std::unique_ptr<Piece> Queen::clone()  const { return std::make_unique<Queen>(*this); }
-std::unique_ptr<Piece> King::clone()   const { return std::make_unique<King>(*this); }
-
 // ---- can_move implementations (pseudo-legal) ----
-bool Pawn::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
-    if (r0 == r1 && c0 == c1) return false;
-    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, color)) return false;
-
+static bool pawn_can_move(const Board& b, Color color, int r0, int c0, int r1, int c1) {
     int dir = (color == Color::White) ? +1 : -1;
     int start_row = (color == Color::White) ? 1 : 6;
 
@@ -57,41 +32,22 @@ bool Pawn::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
     return false; // EP handled in Game
 }
 
-bool Knight::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
-    if (r0 == r1 && c0 == c1) return false;
-    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, color)) return false;
-    int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
-    return (dr == 2 && dc == 1) || (dr == 1 && dc == 2);
-}
-
-bool Bishop::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
-    if (r0 == r1 && c0 == c1) return false;
-    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, color)) return false;
-    int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
-    if (dr != dc) return false;
-    return b.path_clear(r0, c0, r1, c1);
-}
-
-bool Rook::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
-    if (r0 == r1 && c0 == c1) return false;
-    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, color)) return false;
-    if (r0 != r1 && c0 != c1) return false;
-    return b.path_clear(r0, c0, r1, c1);
-}
-
-bool Queen::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
+bool can_move(const Board& b, int r0, int c0, int r1, int c1) {
     if (r0 == r1 && c0 == c1) return false;
-    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, color)) return false;
-    int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
-    if (!(r0 == r1 || c0 == c1 || dr == dc)) return false;
-    return b.path_clear(r0, c0, r1, c1);
-}
+    const Piece p = b.board[r0][c0];
+    if (p.empty()) return false;
+    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, p.color())) return false;
 
-bool King::can_move(const Board& b, int r0, int c0, int r1, int c1) const {
-    if (r0 == r1 && c0 == c1) return false;
-    if (!b.in_bounds(r1, c1) || b.is_friend(r1, c1, color)) return false;
     int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
-    return std::max(dr, dc) == 1; // castling handled in Game
+    switch (p.type()) {
+        case PAWN:   return pawn_can_move(b, p.color(), r0, c0, r1, c1);
+        case KNIGHT: return (dr == 2 && dc == 1) || (dr == 1 && dc == 2);
+        case BISHOP: return dr == dc && b.path_clear(r0, c0, r1, c1);
+        case ROOK:   return (r0 == r1 || c0 == c1) && b.path_clear(r0, c0, r1, c1);
+        case QUEEN:  return (r0 == r1 || c0 == c1 || dr == dc) && b.path_clear(r0, c0, r1, c1);
+        case KING:   return std::max(dr, dc) == 1; // castling handled in Game
+        default:     return false;
+    }
 }
 
 } // namespace chess
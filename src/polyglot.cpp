@@ -0,0 +1,246 @@
+#include "chess/polyglot.hpp"
+#include "chess/attacks.hpp"
+#include <array>
+
+namespace chess {
+
+// Random64[781]: 64*kind+square for pieces (kind = 2*PieceType + white), 768..771
+// castling KQkq, 772..779 en-passant file, 780 white to move.
+static constexpr int RND_CASTLE = 768, RND_EP = 772, RND_TURN = 780;
+
+// The test positions of the Polyglot book format description: e4 d5 e5 f5 Ke2 Kf7 from
+// the start, then a4 b5 h4 b4 c4 (ep c3) bxc3 Ra3 (castling right lost).
+struct KeyVector { const char* fen; uint64_t key; };
+static constexpr KeyVector KEY_VECTORS[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",          0x463B96181691FC9CULL},
+    {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",       0x823C9B50FD114196ULL},
+    {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2",     0x0756B94461C50FB0ULL},
+    {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2",       0x662FAFB965DB29D4ULL},
+    {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",     0x22A48B5A8E47FF78ULL},
+    {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3",        0x652A607CA3F242C1ULL},
+    {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4",         0x00FDD303C946BDD9ULL},
+    {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3",     0x3C8123EA7B067637ULL},
+    {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4",      0x5C3F9B829B279560ULL},
+};
+
+// polyglot_key of a well-formed FEN under table t, as a constant expression so that a
+// compiled-in table is checked against KEY_VECTORS when the library is built
+static constexpr uint64_t fen_key(const std::array<uint64_t, 781>& t, const char* fen){
+    constexpr char KINDS[] = "pPnNbBrRqQkK";
+    int board[64] = {}; // kind + 1, 0 if empty
+    uint64_t k = 0;
+    int row = 7, file = 0;
+    const char* p = fen;
+    for (; *p != ' '; ++p) {
+        if (*p == '/') { --row; file = 0; }
+        else if (*p >= '1' && *p <= '8') file += *p - '0';
+        else {
+            int kind = 0;
+            while (KINDS[kind] != *p) ++kind;
+            board[8*row + file] = kind + 1;
+            k ^= t[64*kind + 8*row + file++];
+        }
+    }
+    const bool white = *++p == 'w';
+    if (white) k ^= t[RND_TURN];
+    for (p += 2; *p != ' '; ++p) {
+        if (*p == 'K') k ^= t[RND_CASTLE + 0];
+        if (*p == 'Q') k ^= t[RND_CASTLE + 1];
+        if (*p == 'k') k ^= t[RND_CASTLE + 2];
+        if (*p == 'q') k ^= t[RND_CASTLE + 3];
+    }
+    if (*++p != '-') {
+        const int f = p[0] - 'a', r = white ? 4 : 3, pawn = white ? 2 : 1;
+        if ((f > 0 && board[8*r + f - 1] == pawn) || (f < 7 && board[8*r + f + 1] == pawn)) k ^= t[RND_EP + f];
+    }
+    return k;
+}
+
+#if CHESS_POLYGLOT_EMBEDDED
+// generated by CMake from the file named by CHESS_POLYGLOT_RANDOM64
+static constexpr std::array<uint64_t, 781> REFERENCE_RANDOM64 = {
+#include "polyglot_random64.inc"
+};
+static constexpr bool reference_matches(){
+    for (const KeyVector& v : KEY_VECTORS)
+        if (fen_key(REFERENCE_RANDOM64, v.fen) != v.key) return false;
+    return true;
+}
+static_assert(reference_matches(), "CHESS_POLYGLOT_RANDOM64 is not the Polyglot Random64 table");
+static std::array<uint64_t, 781> RANDOM64 = REFERENCE_RANDOM64;
+#else
+// Without the reference table a fixed splitmix64 stream with the same layout is active,
+// which keeps keys well mixed but matches no third-party book.
+static constexpr std::array<uint64_t, 781> make_random64(){
+    std::array<uint64_t, 781> t{};
+    uint64_t x = 0x9D39247E33776D41ULL;
+    for (auto& v : t){
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        v = z ^ (z >> 31);
+    }
+    return t;
+}
+// books written under the fallback keys stay readable as long as this holds
+static_assert(fen_key(make_random64(), KEY_VECTORS[0].fen) == 0x0F32F24C1B58C8A2ULL);
+static std::array<uint64_t, 781> RANDOM64 = make_random64();
+#endif
+
+void write_entry(unsigned char* out, const BookEntry& e){
+    for (int i=0; i<8; ++i) out[i] = uint8_t(e.key >> (56 - 8*i));
+    out[8]  = uint8_t(e.move >> 8);   out[9]  = uint8_t(e.move);
+    out[10] = uint8_t(e.weight >> 8); out[11] = uint8_t(e.weight);
+    for (int i=0; i<4; ++i) out[12+i] = uint8_t(e.learn >> (24 - 8*i));
+}
+
+static uint64_t read_key(const unsigned char* in){
+    uint64_t k = 0;
+    for (int i=0; i<8; ++i) k = (k << 8) | in[i];
+    return k;
+}
+
+BookEntry read_entry(const unsigned char* in){
+    BookEntry e;
+    e.key = read_key(in);
+    e.move = uint16_t(in[8] << 8 | in[9]);
+    e.weight = uint16_t(in[10] << 8 | in[11]);
+    e.learn = uint32_t(in[12]) << 24 | uint32_t(in[13]) << 16 | uint32_t(in[14]) << 8 | in[15];
+    return e;
+}
+
+uint64_t polyglot_key(const BoardBB& pos){
+    uint64_t k = 0;
+    for (int c=0; c<2; ++c)
+        for (int p=0; p<6; ++p)
+            for (Bitboard b = pos.bb.pcs[c][p]; b; b &= b-1)
+                k ^= RANDOM64[64*(2*p + (c==0)) + lsb(b)];
+    if (pos.castling & CR_WK) k ^= RANDOM64[RND_CASTLE + 0];
+    if (pos.castling & CR_WQ) k ^= RANDOM64[RND_CASTLE + 1];
+    if (pos.castling & CR_BK) k ^= RANDOM64[RND_CASTLE + 2];
+    if (pos.castling & CR_BQ) k ^= RANDOM64[RND_CASTLE + 3];
+    // the ep file only counts if a pawn of the side to move stands next to the pushed pawn
+    if (pos.ep_sq >= 0 && (attacks_pawn(other(pos.side), Square(pos.ep_sq)) & pos.pieces(pos.side, PAWN)))
+        k ^= RANDOM64[RND_EP + pos.ep_sq % 8];
+    if (pos.side == WHITE) k ^= RANDOM64[RND_TURN];
+    return k;
+}
+
+bool polyglot_keys_standard(){
+    BoardBB pos;
+    for (const KeyVector& v : KEY_VECTORS)
+        if (pos.parse_fen(v.fen) != FenError::Ok || polyglot_key(pos) != v.key) return false;
+    return true;
+}
+
+static int hex_digit(char c){
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool load_polyglot_random64(std::string_view text){
+    std::array<uint64_t, 781> t{};
+    size_t n = 0;
+    for (size_t i = 0; n < t.size() && i + 18 <= text.size(); ++i) {
+        if (text[i] != '0' || (text[i+1] != 'x' && text[i+1] != 'X')) continue;
+        if (i + 18 < text.size() && hex_digit(text[i+18]) >= 0) continue; // wider than 64 bits
+        uint64_t v = 0;
+        size_t d = 0;
+        for (; d < 16 && hex_digit(text[i+2+d]) >= 0; ++d) v = v << 4 | uint64_t(hex_digit(text[i+2+d]));
+        if (d < 16) continue;
+        t[n++] = v;
+        i += 17;
+    }
+    if (n < t.size()) return false;
+    const auto old = RANDOM64;
+    RANDOM64 = t;
+    if (polyglot_keys_standard()) return true;
+    RANDOM64 = old;
+    return false;
+}
+
+uint16_t to_polyglot_move(Move m){
+    int from = m.from(), to = m.to();
+    if (m.flag() == MF_CASTLE) to = (to & ~7) | (to % 8 == 6 ? 7 : 0);
+    int promo = m.is_promo() ? m.flag() - MF_PROMO_N + 1 : 0;
+    return uint16_t(promo << 12 | from << 6 | to);
+}
+
+Move from_polyglot_move(const BoardBB& pos, uint16_t pm){
+    const int from = (pm >> 6) & 63, promo = (pm >> 12) & 7;
+    int to = pm & 63;
+    if ((pos.pieces(pos.side, KING) & bb(Square(from))) && from % 8 == 4 && (to & ~7) == (from & ~7)) {
+        if (to % 8 == 7) to = from + 2;
+        else if (to % 8 == 0) to = from - 2;
+    }
+    BoardBB tmp = pos;
+    std::vector<Move> ml;
+    tmp.generate_legal_moves(ml);
+    for (Move m : ml) {
+        if (m.from() != from || m.to() != to) continue;
+        if (m.is_promo() ? m.flag() - MF_PROMO_N + 1 == promo : promo == 0) return m;
+    }
+    return Move();
+}
+
+bool PolyglotBook::open(const std::string& path){
+    close();
+    if (!file_.open(path, false)) return false;
+    if (file_.view().size() % BOOK_ENTRY_SIZE) { close(); return false; }
+    data_ = reinterpret_cast<const unsigned char*>(file_.view().data());
+    n_ = file_.view().size() / BOOK_ENTRY_SIZE;
+    return true;
+}
+
+void PolyglotBook::close(){
+    file_.close();
+    data_ = nullptr;
+    n_ = 0;
+}
+
+size_t PolyglotBook::find(uint64_t key, std::vector<BookEntry>& out) const {
+    out.clear();
+    size_t lo = 0, hi = n_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (read_key(data_ + mid * BOOK_ENTRY_SIZE) < key) lo = mid + 1;
+        else hi = mid;
+    }
+    for (; lo < n_ && read_key(data_ + lo * BOOK_ENTRY_SIZE) == key; ++lo)
+        out.push_back(read_entry(data_ + lo * BOOK_ENTRY_SIZE));
+    return out.size();
+}
+
+Move PolyglotBook::pick(const BoardBB& pos, BookPick how, uint64_t rnd) const {
+    std::vector<BookEntry> es;
+    if (!find(polyglot_key(pos), es)) return Move();
+
+    Move moves[64];
+    uint32_t weights[64];
+    size_t n = 0;
+    uint64_t total = 0;
+    for (const BookEntry& e : es) {
+        Move m = from_polyglot_move(pos, e.move);
+        if (!m.v || n == 64) continue; // stale or colliding entry
+        moves[n] = m;
+        weights[n++] = e.weight;
+        total += e.weight;
+    }
+    if (!n) return Move();
+
+    size_t best = 0;
+    if (how == BookPick::Best || total == 0) {
+        for (size_t i=1; i<n; ++i) if (weights[i] > weights[best]) best = i;
+        return moves[best];
+    }
+    uint64_t r = rnd % total;
+    for (size_t i=0; i<n; ++i) {
+        if (r < weights[i]) return moves[i];
+        r -= weights[i];
+    }
+    return moves[n-1];
+}
+
+} // namespace chess
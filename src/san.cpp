@@ -0,0 +1,204 @@
+#include "chess/san.hpp"
+#include "chess/attacks.hpp"
+#include <vector>
+
+namespace chess {
+
+static PieceType piece_from_letter(char ch){
+    switch (ch){
+        case 'N': return KNIGHT; case 'B': return BISHOP; case 'R': return ROOK;
+        case 'Q': return QUEEN;  case 'K': return KING;   default:  return NO_PIECE;
+    }
+}
+
+static PieceType piece_at(const BoardBB& pos, Color c, Square s){
+    for (int p=0; p<6; ++p) if (pos.pieces(c, PieceType(p)) & bb(s)) return PieceType(p);
+    return NO_PIECE;
+}
+
+// Squares holding c's pieces of type pt that attack `to` (pseudo-legal origins)
+static Bitboard origins(const BoardBB& pos, Color c, PieceType pt, Square to){
+    const Bitboard occ = pos.occ_all();
+    Bitboard a;
+    switch (pt){
+        case KNIGHT: a = attacks_knight(to);      break;
+        case BISHOP: a = attacks_bishop(to, occ); break;
+        case ROOK:   a = attacks_rook(to, occ);   break;
+        case QUEEN:  a = attacks_queen(to, occ);  break;
+        case KING:   a = attacks_king(to);        break;
+        default:     return 0;
+    }
+    return a & pos.pieces(c, pt);
+}
+
+// Does the non-castling pseudo-legal move m keep the mover's king safe? Works on
+// the post-move occupancy, so pos is not touched.
+static bool king_safe_after(const BoardBB& pos, Move m){
+    const Color us = pos.side, them = other(us);
+    const Square from = Square(m.from()), to = Square(m.to());
+    Bitboard occ = (pos.occ_all() ^ bb(from)) | bb(to);
+    Bitboard captured = bb(to);
+    if (m.flag()==MF_EP){
+        Square cap = Square(int(to) + (us==WHITE ? -8 : 8));
+        occ ^= bb(cap);
+        captured = bb(cap);
+    }
+    const Square k = (pos.pieces(us, KING) & bb(from)) ? to : pos.king_square(us);
+    auto enemy = [&](PieceType p){ return pos.pieces(them, p) & ~captured; };
+    return !(attacks_pawn(us, k) & enemy(PAWN))
+        && !(attacks_knight(k) & enemy(KNIGHT))
+        && !(attacks_king(k) & enemy(KING))
+        && !(attacks_bishop(k, occ) & (enemy(BISHOP) | enemy(QUEEN)))
+        && !(attacks_rook(k, occ) & (enemy(ROOK) | enemy(QUEEN)));
+}
+
+// Does m attack the opponent's king once played? (direct or discovered)
+static bool gives_check(const BoardBB& pos, Move m, PieceType moved){
+    const Color us = pos.side, them = other(us);
+    const Square from = Square(m.from()), to = Square(m.to());
+    Bitboard mine[6];
+    for (int p=0; p<6; ++p) mine[p] = pos.pieces(us, PieceType(p));
+    Bitboard occ = (pos.occ_all() ^ bb(from)) | bb(to);
+
+    const PieceType placed = m.is_promo() ? PieceType(m.flag()-MF_PROMO_N+KNIGHT) : moved;
+    mine[moved] ^= bb(from);
+    mine[placed] |= bb(to);
+    if (m.flag()==MF_EP) occ ^= bb(Square(int(to) + (us==WHITE ? -8 : 8)));
+    if (m.flag()==MF_CASTLE){
+        const int r = int(to) & ~7;
+        const Square rf = Square(r + (to%8==6 ? 7 : 0)), rt = Square(r + (to%8==6 ? 5 : 3));
+        mine[ROOK] ^= bb(rf) | bb(rt);
+        occ ^= bb(rf) | bb(rt);
+    }
+    const Square k = pos.king_square(them);
+    return (attacks_pawn(them, k) & mine[PAWN])
+        || (attacks_knight(k) & mine[KNIGHT])
+        || (attacks_bishop(k, occ) & (mine[BISHOP] | mine[QUEEN]))
+        || (attacks_rook(k, occ) & (mine[ROOK] | mine[QUEEN]));
+}
+
+std::string to_san(const BoardBB& pos, Move m){
+    static const char LETTER[6] = {'P','N','B','R','Q','K'};
+    const Square from = Square(m.from()), to = Square(m.to());
+    const PieceType pt = piece_at(pos, pos.side, from);
+    const bool capture = m.flag()==MF_EP || (pos.occ_side(other(pos.side)) & bb(to));
+    std::string s;
+    s.reserve(8);
+
+    if (m.flag()==MF_CASTLE){
+        s = (to%8==6) ? "O-O" : "O-O-O";
+    } else if (pt==PAWN){
+        if (capture){ s += char('a' + from%8); s += 'x'; }
+        s += char('a' + to%8); s += char('1' + to/8);
+        if (m.is_promo()){ s += '='; s += LETTER[m.flag()-MF_PROMO_N+KNIGHT]; }
+    } else {
+        s += LETTER[pt];
+        // other pieces of the same kind that could legally go to `to`
+        Bitboard rivals = 0;
+        for (Bitboard o = origins(pos, pos.side, pt, to) & ~bb(from); o; o &= o-1){
+            Move alt(uint8_t(lsb(o)), uint8_t(to), m.flag());
+            if (king_safe_after(pos, alt)) rivals |= bb(Square(lsb(o)));
+        }
+        if (rivals){
+            if (!(rivals & file_mask(from%8)))      s += char('a' + from%8);
+            else if (!(rivals & rank_mask(from/8))) s += char('1' + from/8);
+            else { s += char('a' + from%8); s += char('1' + from/8); }
+        }
+        if (capture) s += 'x';
+        s += char('a' + to%8); s += char('1' + to/8);
+    }
+
+    if (gives_check(pos, m, pt)){
+        BoardBB after = pos; // only checking moves pay for the copy
+        after.do_move(m);
+        std::vector<Move> replies;
+        after.generate_legal_moves(replies);
+        s += replies.empty() ? '#' : '+';
+    }
+    return s;
+}
+
+Move parse_san(const BoardBB& pos, std::string_view san){
+    while (!san.empty() && (san.back()=='+' || san.back()=='#' || san.back()=='!' || san.back()=='?'))
+        san.remove_suffix(1);
+    const Color us = pos.side, them = other(us);
+
+    if (san=="O-O" || san=="0-0" || san=="O-O-O" || san=="0-0-0"){
+        const int to = (us==WHITE ? 0 : 56) + (san.size()==5 ? 2 : 6);
+        std::vector<Move> ml;
+        pos.generate_moves(ml); // castles are only generated when legal
+        for (Move m : ml) if (m.flag()==MF_CASTLE && m.to()==to) return m;
+        return Move();
+    }
+
+    PieceType pt = piece_from_letter(san.empty() ? 0 : san[0]);
+    size_t i = 0;
+    if (pt==NO_PIECE) pt = PAWN; else i = 1;
+
+    PieceType promo = NO_PIECE;
+    size_t end = san.size();
+    if (pt==PAWN && end >= 2 && san[end-2]=='='){ promo = piece_from_letter(san[end-1]); end -= 2; }
+    else if (pt==PAWN && end >= 1 && piece_from_letter(san[end-1])!=NO_PIECE){ promo = piece_from_letter(san[end-1]); end -= 1; }
+    if (promo==KING || end < i+2) return Move();
+
+    const int tf = san[end-2]-'a', tr = san[end-1]-'1';
+    if (tf<0 || tf>7 || tr<0 || tr>7) return Move();
+    const Square to = Square(tr*8 + tf);
+
+    int ff = -1, fr = -1;
+    bool capture = false;
+    for (char ch : san.substr(i, end-2-i)){
+        if (ch>='a' && ch<='h') ff = ch-'a';
+        else if (ch>='1' && ch<='8') fr = ch-'1';
+        else if (ch=='x' || ch==':') capture = true;
+        else if (ch!='-') return Move();
+    }
+    if (pos.occ_side(us) & bb(to)) return Move();
+
+    if (pt==PAWN){
+        const int dir = (us==WHITE) ? 8 : -8;
+        const bool last = (tr == (us==WHITE ? 7 : 0));
+        if (!last && promo!=NO_PIECE) return Move();
+        if (last && promo==NO_PIECE) promo = QUEEN; // tolerate a missing "=Q"
+        int from;
+        uint8_t flag;
+        if (ff >= 0 && ff != tf){
+            if (ff-tf != 1 && tf-ff != 1) return Move();
+            from = int(to) - dir + (ff - tf);
+            if (to == pos.ep_sq) flag = MF_EP;
+            else if (pos.occ_side(them) & bb(to)) flag = MF_CAPTURE;
+            else return Move();
+        } else {
+            if (capture || (pos.occ_all() & bb(to))) return Move();
+            from = int(to) - dir;
+            flag = MF_QUIET;
+            if (from<0 || from>63) return Move();
+            if (!(pos.pieces(us, PAWN) & bb(Square(from)))){
+                // double push from the home rank over an empty square
+                if (tr != (us==WHITE ? 3 : 4) || (pos.occ_all() & bb(Square(from)))) return Move();
+                from -= dir;
+            }
+        }
+        if (from<0 || from>63 || !(pos.pieces(us, PAWN) & bb(Square(from)))) return Move();
+        if (fr >= 0 && from/8 != fr) return Move();
+        if (promo!=NO_PIECE) flag = uint8_t(MF_PROMO_N + (promo - KNIGHT));
+        Move m(uint8_t(from), uint8_t(to), flag);
+        return king_safe_after(pos, m) ? m : Move();
+    }
+
+    Bitboard cand = origins(pos, us, pt, to);
+    if (ff >= 0) cand &= file_mask(ff);
+    if (fr >= 0) cand &= rank_mask(fr);
+
+    const uint8_t flag = (pos.occ_side(them) & bb(to)) ? MF_CAPTURE : MF_QUIET;
+    Move found;
+    for (; cand; cand &= cand-1){
+        Move m(uint8_t(lsb(cand)), uint8_t(to), flag);
+        if (!king_safe_after(pos, m)) continue;
+        if (found.v) return Move(); // ambiguous
+        found = m;
+    }
+    return found;
+}
+
+} // namespace chess
@@ -1,8 +1,16 @@
 #include "chess/search_bb.hpp"
 #include "chess/attacks.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/tbprobe.hpp"
+#include "chess/eval_terms.hpp"
+#include "chess/eval_weights.hpp"
 #include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <limits>
+#include <memory>
 #include <cstdint>
+#include <ostream>
 
 namespace chess {
 
@@ -31,25 +39,112 @@ static inline PieceType piece_on(const BoardBB& P, Square s, Color& who){
     who = Color::None; return NO_PIECE;
 }
 
+// bitbase wins: below mate scores, above any material balance
+static constexpr int KNOWN_WIN = 10000;
+
+// Score for the strong side of a won bitbase ending, shaped so search makes progress:
+// advance the pawn, or drive the lone king to the edge and bring our king closer.
+static int known_win(const BoardBB& pos, Color strong){
+    const Square k = pos.king_square(strong), lk = pos.king_square(other(strong));
+    if (Bitboard p = pos.pieces(strong, PAWN)){
+        const int r = row_of(Square(lsb(p)));
+        return KNOWN_WIN + pv(PAWN) + 20 * (strong==WHITE ? r : 7-r);
+    }
+    auto edge = [](int x){ return std::max(3-x, x-4); };
+    const int to_edge = std::max(edge(col_of(lk)), edge(row_of(lk)));
+    const int kings = std::max(std::abs(col_of(k)-col_of(lk)), std::abs(row_of(k)-row_of(lk)));
+    return KNOWN_WIN + pv(pos.pieces(strong, QUEEN) ? QUEEN : ROOK) + 20*to_edge + 10*(7-kings);
+}
+
+static EvalWeights g_eval_weights = DEFAULT_EVAL_WEIGHTS;
+
+// SearchLimits::weights of the search running on this thread, if any
+static thread_local const EvalWeights* t_search_weights = nullptr;
+
+const EvalWeights& eval_weights(){ return g_eval_weights; }
+void set_eval_weights(const EvalWeights& w){ g_eval_weights = w; }
+
+bool parse_eval_weights(std::string_view text, EvalWeights& out){
+    size_t i = text.find("{{");
+    if (i == std::string_view::npos) return false;
+    EvalWeights w;
+    int n = 0;
+    for (i += 2; i < text.size(); ++i){
+        const char c = text[i];
+        if (c == '}') break;
+        if (c == '/' && i + 1 < text.size() && text[i+1] == '/'){
+            i = text.find('\n', i);
+            if (i == std::string_view::npos) return false;
+        } else if (c == '-' || (c >= '0' && c <= '9')){
+            int v = 0;
+            auto [end, ec] = std::from_chars(text.data() + i, text.data() + text.size(), v);
+            if (ec != std::errc() || n == EVAL_TERM_COUNT || v < INT16_MIN || v > INT16_MAX) return false;
+            w.w[n++] = int16_t(v);
+            i = size_t(end - text.data()) - 1;
+        } else if (c != ',' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            return false;
+        }
+    }
+    if (i == text.size() || n != EVAL_TERM_COUNT) return false;
+    out = w;
+    return true;
+}
+
+// K+P/R/Q vs K with a bitbase result
+static bool bitbase_ending(const BoardBB& pos, Color& strong, bool& wins){
+    return popcount(pos.occ_all()) == 3 && bitbase::probe(pos, strong, wins);
+}
+
+// Keep in step with eval_features (the test suite checks they agree)
 int eval_bb(const BoardBB& pos){
-    // material
+    Color strong; bool wins;
+    if (bitbase_ending(pos, strong, wins)) return wins ? side_sign(strong) * known_win(pos, strong) : 0;
+
+    const int16_t* w = (t_search_weights ? t_search_weights : &g_eval_weights)->w;
     int score = 0;
     for (int c=0;c<2;++c){
+        const int sign = c==0 ? +1 : -1; // White is index 0
+        const int flip = c==0 ? 0 : 56;  // Black's squares seen from White's side
         for (int pt=0; pt<6; ++pt){
-            int pc = popcount(pos.bb.pcs[c][pt]);
-            int val = pv((PieceType)pt) * pc;
-            score += (c==0 ? +val : -val); // White is index 0
+            Bitboard b = pos.bb.pcs[c][pt];
+            if (pt != KING) score += sign * w[TERM_PIECE + pt] * popcount(b);
+            for (; b; b &= b-1) score += sign * w[TERM_PST + 64*pt + (lsb(b) ^ flip)];
         }
+        if (popcount(pos.bb.pcs[c][BISHOP]) >= 2) score += sign * w[TERM_BISHOP_PAIR];
     }
-    // mobility (tiny)
-    std::vector<Move> ml;
-    BoardBB tmp = pos;
-    tmp.generate_legal_moves(ml);
-    score += (pos.side==WHITE ? + (int)ml.size() : - (int)ml.size());
-
+    score += side_sign(pos.side) * pos.count_legal_moves() * w[TERM_MOBILITY];
     return score; // from White's perspective
 }
 
+bool eval_features(const BoardBB& pos, std::vector<EvalFeature>& out){
+    out.clear();
+    Color strong; bool wins;
+    if (bitbase_ending(pos, strong, wins)) return false;
+
+    auto add = [&](int term, int count){ out.push_back({uint16_t(term), int16_t(count)}); };
+    for (int c=0;c<2;++c){
+        const int sign = c==0 ? +1 : -1;
+        const int flip = c==0 ? 0 : 56;
+        for (int pt=0; pt<6; ++pt)
+            for (Bitboard b = pos.bb.pcs[c][pt]; b; b &= b-1) add(TERM_PST + 64*pt + (lsb(b) ^ flip), sign);
+    }
+    for (int pt=PAWN; pt<KING; ++pt) add(TERM_PIECE + pt, popcount(pos.bb.pcs[0][pt]) - popcount(pos.bb.pcs[1][pt]));
+    add(TERM_MOBILITY, side_sign(pos.side) * pos.count_legal_moves());
+    add(TERM_BISHOP_PAIR, int(popcount(pos.bb.pcs[0][BISHOP]) >= 2) - int(popcount(pos.bb.pcs[1][BISHOP]) >= 2));
+
+    // merge mirrored PST hits, drop zeros
+    std::sort(out.begin(), out.end(), [](EvalFeature a, EvalFeature b){ return a.term < b.term; });
+    size_t n = 0;
+    for (size_t i=0; i<out.size(); ++i){
+        const EvalFeature f = out[i];
+        if (n && out[n-1].term == f.term) out[n-1].count = int16_t(out[n-1].count + f.count);
+        else out[n++] = f;
+    }
+    out.resize(n);
+    std::erase_if(out, [](EvalFeature f){ return f.count == 0; });
+    return true;
+}
+
 // simple move ordering: captures first (MVV), then promotions, castles, quiets
 static inline int move_order_score(const BoardBB& pos, Move m){
     int s = 0;
@@ -66,15 +161,140 @@ static inline int move_order_score(const BoardBB& pos, Move m){
     return s;
 }
 
-static int negamax(BoardBB& pos, int depth, int alpha, int beta){
+// ---- stats plumbing: compiles away unless CHESS_SEARCH_STATS ----
+#if CHESS_SEARCH_STATS
+#define STAT(expr) do { expr; } while (0)
+struct StatTimer {
+    uint64_t& acc;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    explicit StatTimer(uint64_t& a) : acc(a) {}
+    ~StatTimer(){
+        acc += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+};
+#define STAT_TIMER(acc) StatTimer stat_timer_(acc)
+#else
+#define STAT(expr) do {} while (0)
+#define STAT_TIMER(acc) do {} while (0)
+#endif
+
+void SearchStats::merge(const SearchStats& o){
+    nodes += o.nodes; leaf_nodes += o.leaf_nodes; beta_cutoffs += o.beta_cutoffs;
+    for (int i=0;i<STATS_CUT_SLOTS;++i) cutoff_at[i] += o.cutoff_at[i];
+    for (int i=0;i<STATS_MAX_PLY;++i) nodes_at_ply[i] += o.nodes_at_ply[i];
+    movegen_ns += o.movegen_ns; eval_ns += o.eval_ns; total_ns += o.total_ns;
+}
+
+double SearchStats::first_move_cutoff_rate() const {
+    return beta_cutoffs ? double(cutoff_at[0]) / double(beta_cutoffs) : 0.0;
+}
+
+double SearchStats::branching_factor(int ply) const {
+    if (ply < 0 || ply+1 >= STATS_MAX_PLY || !nodes_at_ply[ply]) return 0.0;
+    return double(nodes_at_ply[ply+1]) / double(nodes_at_ply[ply]);
+}
+
+void write_stats(std::ostream& os, const SearchStats& s, const char* prefix){
+    auto pct = [](double x){ return int(x*1000.0 + 0.5) / 10.0; };
+    auto r2  = [](double x){ return int(x*100.0 + 0.5) / 100.0; };
+    auto ms  = [](uint64_t ns){ return ns / 1'000'000; };
+    os << prefix << "nodes " << s.nodes << " leaf " << s.leaf_nodes << "\n";
+    os << prefix << "cutoffs " << s.beta_cutoffs << " first-move " << pct(s.first_move_cutoff_rate()) << "% by-index";
+    for (int i=0;i<STATS_CUT_SLOTS;++i) os << ' ' << s.cutoff_at[i];
+    os << "\n" << prefix << "ebf";
+    for (int p=0; p+1<STATS_MAX_PLY && s.nodes_at_ply[p+1]; ++p) os << ' ' << r2(s.branching_factor(p));
+    os << "\n" << prefix << "time ms movegen " << ms(s.movegen_ns) << " eval " << ms(s.eval_ns)
+       << " search " << ms(s.search_ns()) << " total " << ms(s.total_ns) << "\n";
+}
+
+// tablebase results: below mate scores, above bitbase wins and any evaluation
+static constexpr int TB_WIN_SCORE = 50000;
+
+// per-search state, threaded through the recursion (one per searching thread)
+struct SearchContext {
+    uint64_t nodes = 0;
+    uint64_t node_limit = 0;   // 0 = none
+    bool timed = false;        // deadline applies
+    std::chrono::steady_clock::time_point deadline;
+    bool stopped = false;      // node budget ran out; unwind without using scores
+    int tb_pieces = 0;         // tb::max_pieces() at the start, 0 = no probing
+    int tb_depth = 1;
+    uint64_t tbhits = 0;
+    SearchStats stats;
+    Move pv[MAX_PLY][MAX_PLY]; // triangular PV table: pv[ply] = line from ply onward
+    int pv_len[MAX_PLY]{};
+#if CHESS_COPY_MAKE
+    std::unique_ptr<BoardBB[]> line{new BoardBB[MAX_PLY + 1]}; // line[ply] = position at ply (root excluded)
+#endif
+
+    void update_pv(int ply, Move m){
+        pv[ply][0] = m;
+        std::copy(pv[ply+1], pv[ply+1] + pv_len[ply+1], pv[ply] + 1);
+        pv_len[ply] = pv_len[ply+1] + 1;
+    }
+};
+
+// Child position after m: the next slot (copy-make) or pos itself (make/unmake)
+static inline BoardBB& make_move([[maybe_unused]] SearchContext& ctx, BoardBB& pos, [[maybe_unused]] int ply, Move m){
+#if CHESS_COPY_MAKE
+    BoardBB& child = ctx.line[ply + 1];
+    child.copy_make(pos, m);
+    return child;
+#else
+    pos.do_move(m);
+    return pos;
+#endif
+}
+
+static inline void unmake_move([[maybe_unused]] BoardBB& pos){
+#if !CHESS_COPY_MAKE
+    pos.undo_move();
+#endif
+}
+
+static bool is_mated(BoardBB& pos){
+    if (!pos.square_attacked(pos.king_square(pos.side), other(pos.side))) return false;
+    std::vector<Move> ml;
+    pos.generate_legal_moves(ml);
+    return ml.empty();
+}
+
+static int negamax(SearchContext& ctx, BoardBB& pos, int depth, int ply, int alpha, int beta){
+    ++ctx.nodes;
+    ctx.pv_len[ply] = 0;
+    if (ctx.node_limit && ctx.nodes > ctx.node_limit){ ctx.stopped = true; return 0; }
+    if (ctx.timed && (ctx.nodes & 1023) == 0 && std::chrono::steady_clock::now() >= ctx.deadline){ ctx.stopped = true; return 0; }
+    STAT(++ctx.stats.nodes_at_ply[std::min(ply, STATS_MAX_PLY-1)]);
+    // repetitions and the 50-move rule end the line (mate on the 100th ply still counts)
+    if (pos.is_repetition(ply) || (pos.halfmove >= 100 && !is_mated(pos))) return 0;
+    // a reversible move from here repeats a position of this line: a draw is within reach
+    if (alpha < 0 && pos.has_upcoming_repetition(ply)){
+        alpha = 0;
+        if (alpha >= beta) return alpha;
+    }
+    // WDL tables assume a fresh 50-move count, so probe right after captures and pawn moves
+    if (ctx.tb_pieces && depth >= ctx.tb_depth && pos.halfmove == 0 && popcount(pos.occ_all()) <= ctx.tb_pieces){
+        Wdl w;
+        if (tb::probe_wdl(pos, w)){
+            ++ctx.tbhits;
+            if (w == Wdl::Win)  return TB_WIN_SCORE - ply;
+            if (w == Wdl::Loss) return -TB_WIN_SCORE + ply;
+            return int(w); // draws, and wins/losses spoiled by the 50-move rule
+        }
+    }
     if (depth==0){
+        STAT(++ctx.stats.leaf_nodes);
+        STAT_TIMER(ctx.stats.eval_ns);
         // evaluate from side-to-move perspective via sign
         int e = eval_bb(pos);
         return side_sign(pos.side) * e;
     }
 
     std::vector<Move> moves;
-    pos.generate_legal_moves(moves);
+    {
+        STAT_TIMER(ctx.stats.movegen_ns);
+        pos.generate_legal_moves(moves);
+    }
 
     if (moves.empty()){
         // checkmate/stalemate
@@ -89,45 +309,110 @@ static int negamax(BoardBB& pos, int depth, int alpha, int beta){
     });
 
     int best = std::numeric_limits<int>::min()/2;
-    for (auto m : moves){
-        pos.do_move(m);
-        int sc = -negamax(pos, depth-1, -beta, -alpha);
-        pos.undo_move();
+    for (size_t i=0; i<moves.size(); ++i){
+        Move m = moves[i];
+        int sc = -negamax(ctx, make_move(ctx, pos, ply, m), depth-1, ply+1, -beta, -alpha);
+        unmake_move(pos);
+        if (ctx.stopped) return 0;
 
+        if (sc > alpha) ctx.update_pv(ply, m);
         if (sc > best) best = sc;
         if (best > alpha) alpha = best;
-        if (alpha >= beta) break;
+        if (alpha >= beta){
+            STAT(++ctx.stats.beta_cutoffs);
+            STAT(++ctx.stats.cutoff_at[std::min<size_t>(i, STATS_CUT_SLOTS-1)]);
+            break;
+        }
     }
     return best;
 }
 
-Move search_best_move(BoardBB& pos, int depth){
-    std::vector<Move> moves;
-    pos.generate_legal_moves(moves);
-    if (moves.empty()) return Move(); // no move
-
-    // order first layer too
-    std::sort(moves.begin(), moves.end(), [&](const Move& a, const Move& b){
-        return move_order_score(pos,a) > move_order_score(pos,b);
-    });
-
+// One full-width iteration over the (already ordered) root moves.
+// Returns false if the node budget ran out before it finished.
+static bool search_root(SearchContext& ctx, BoardBB& pos, const std::vector<Move>& moves, int depth,
+                        SearchResult& res){
     int alpha = std::numeric_limits<int>::min()/2;
     int beta  = std::numeric_limits<int>::max()/2;
     Move best = moves.front();
     int bestSc = std::numeric_limits<int>::min()/2;
+    ctx.pv_len[0] = 0;
 
     for (auto m : moves){
-        pos.do_move(m);
-        int sc = -negamax(pos, depth-1, -beta, -alpha);
-        pos.undo_move();
+        int sc = -negamax(ctx, make_move(ctx, pos, 0, m), depth-1, 1, -beta, -alpha);
+        unmake_move(pos);
+        if (ctx.stopped) return false;
 
         if (sc > bestSc){
             bestSc = sc;
             best = m;
+            ctx.update_pv(0, m);
         }
         if (sc > alpha) alpha = sc;
     }
-    return best;
+    res.best = best;
+    res.score = bestSc;
+    res.depth = depth;
+    res.pv.assign(ctx.pv[0], ctx.pv[0] + ctx.pv_len[0]);
+    return true;
+}
+
+// Installs SearchLimits::weights for one search on this thread
+struct SearchWeightsScope {
+    const EvalWeights* saved = t_search_weights;
+    explicit SearchWeightsScope(const EvalWeights* w){ if (w) t_search_weights = w; }
+    ~SearchWeightsScope(){ t_search_weights = saved; }
+};
+
+SearchResult search_position(BoardBB& pos, const SearchLimits& limits){
+    SearchWeightsScope weights(limits.weights);
+    SearchContext ctx;
+    ctx.node_limit = limits.nodes;
+    ctx.timed = limits.movetime_ms != 0;
+    ctx.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.movetime_ms);
+    ctx.tb_pieces = tb::max_pieces();
+    ctx.tb_depth = std::max(1, limits.tb_probe_depth);
+    SearchResult res;
+    [[maybe_unused]] auto t0 = std::chrono::steady_clock::now();
+    ++ctx.nodes;
+    STAT(++ctx.stats.nodes_at_ply[0]);
+
+    std::vector<Move> moves;
+    {
+        STAT_TIMER(ctx.stats.movegen_ns);
+        pos.generate_legal_moves(moves);
+    }
+    if (moves.empty()){ res.nodes = ctx.nodes; return res; } // no move
+
+    // order first layer too
+    std::sort(moves.begin(), moves.end(), [&](const Move& a, const Move& b){
+        return move_order_score(pos,a) > move_order_score(pos,b);
+    });
+    // with tablebase coverage, only moves that keep the best outcome are searched
+    if (ctx.tb_pieces && tb::filter_root_moves(pos, moves)) ++ctx.tbhits;
+    res.best = moves.front(); // fallback if the budget dies inside depth 1
+
+    const int depth = std::clamp(limits.depth, 1, MAX_PLY-1);
+    for (int d = (limits.nodes || limits.movetime_ms) ? 1 : depth; d <= depth; ++d){
+        if (!search_root(ctx, pos, moves, d, res)) break;
+        // try the previous best first on the next iteration
+        auto it = std::find(moves.begin(), moves.end(), res.best);
+        std::rotate(moves.begin(), it, it + 1);
+    }
+    res.nodes = ctx.nodes;
+    res.tbhits = ctx.tbhits;
+    STAT(ctx.stats.nodes = ctx.nodes);
+    STAT(ctx.stats.total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - t0).count());
+    res.stats = ctx.stats;
+    return res;
+}
+
+SearchResult search_position(BoardBB& pos, int depth){
+    return search_position(pos, SearchLimits{depth, 0});
+}
+
+Move search_best_move(BoardBB& pos, int depth){
+    return search_position(pos, depth).best;
 }
 
 } // namespace chess
@@ -0,0 +1,106 @@
+#include "chess/selfplay.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/mapped_file.hpp"
+#include <cstdlib>
+
+namespace chess {
+
+const char* to_cstr(GameEnd e){
+    switch (e){
+        case GameEnd::Mate:            return "mate";
+        case GameEnd::Stalemate:       return "stalemate";
+        case GameEnd::Repetition:      return "repetition";
+        case GameEnd::FiftyMoves:      return "fifty moves";
+        case GameEnd::Material:        return "insufficient material";
+        case GameEnd::Bitbase:         return "bitbase";
+        case GameEnd::DrawAdjudicated: return "draw adjudication";
+        case GameEnd::Resign:          return "resign adjudication";
+        default:                       return "max plies";
+    }
+}
+
+static GameResult win_for(Color c){ return c==WHITE ? GameResult::WhiteWin : GameResult::BlackWin; }
+
+// bare kings, or one minor piece against a bare king
+static bool insufficient_material(const BoardBB& pos){
+    for (int c=0; c<2; ++c)
+        if (pos.bb.pcs[c][PAWN] | pos.bb.pcs[c][ROOK] | pos.bb.pcs[c][QUEEN]) return false;
+    const int minors = popcount(pos.bb.pcs[0][KNIGHT] | pos.bb.pcs[0][BISHOP] | pos.bb.pcs[1][KNIGHT] | pos.bb.pcs[1][BISHOP]);
+    return minors <= 1;
+}
+
+PlayedGame play_game(BoardBB& pos, const SearchLimits limits[2], const Adjudication& adj, const PlyHook& hook){
+    if (adj.bitbases) bitbase::init();
+    PlayedGame g;
+    int quiet_run = 0;            // consecutive plies inside the draw score
+    int win_run = 0, win_sign = 0; // consecutive plies beyond the resign score for one side
+    auto finish = [&](GameResult r, GameEnd e){ g.result = r; g.end = e; return g; };
+
+    for (;; ++g.plies){
+        if (pos.is_repetition(0))  return finish(GameResult::Draw, GameEnd::Repetition);
+        if (insufficient_material(pos)) return finish(GameResult::Draw, GameEnd::Material);
+        Color strong; bool wins;
+        if (adj.bitbases && bitbase::probe(pos, strong, wins))
+            return finish(wins ? win_for(strong) : GameResult::Draw, GameEnd::Bitbase);
+        if (g.plies >= adj.max_plies) return finish(GameResult::Draw, GameEnd::MaxPlies);
+
+        SearchResult r = search_position(pos, limits[ci(pos.side)]);
+        if (!r.best.v){
+            if (pos.square_attacked(pos.king_square(pos.side), other(pos.side)))
+                return finish(win_for(other(pos.side)), GameEnd::Mate);
+            return finish(GameResult::Draw, GameEnd::Stalemate);
+        }
+        // a mate on the 100th ply was caught above
+        if (pos.halfmove >= 100) return finish(GameResult::Draw, GameEnd::FiftyMoves);
+
+        const int white_cp = pos.side==WHITE ? r.score : -r.score;
+        quiet_run = (g.plies >= adj.draw_from_ply && std::abs(white_cp) <= adj.draw_cp) ? quiet_run + 1 : 0;
+        const int sign = white_cp >= adj.resign_cp ? 1 : white_cp <= -adj.resign_cp ? -1 : 0;
+        win_run = (sign && sign == win_sign) ? win_run + 1 : (sign ? 1 : 0);
+        win_sign = sign;
+
+        if (hook) hook(pos, r);
+        pos.do_move(r.best);
+
+        if (adj.draw_plies && quiet_run >= adj.draw_plies){ ++g.plies; return finish(GameResult::Draw, GameEnd::DrawAdjudicated); }
+        if (adj.resign_plies && win_run >= adj.resign_plies){
+            ++g.plies;
+            return finish(win_for(win_sign > 0 ? WHITE : BLACK), GameEnd::Resign);
+        }
+    }
+}
+
+std::vector<std::string> load_openings(std::string_view epd){
+    std::vector<std::string> out;
+    LineCursor cur(epd);
+    std::string_view line;
+    BoardBB pos;
+    std::vector<Move> moves;
+    while (cur.next(line)){
+        size_t b = line.find_first_not_of(" \t");
+        if (b == std::string_view::npos || line[b] == '#') continue;
+        std::string_view fen = line.substr(b, line.find(';') - b);
+        while (!fen.empty() && (fen.back() == ' ' || fen.back() == '\t' || fen.back() == '\r')) fen.remove_suffix(1);
+        if (pos.parse_fen(fen) != FenError::Ok) continue;
+        pos.generate_legal_moves(moves);
+        if (!moves.empty()) out.emplace_back(fen);
+    }
+    return out;
+}
+
+bool random_opening(BoardBB& pos, std::string_view fen, int plies, std::mt19937_64& rng){
+    std::vector<Move> moves;
+    for (int attempt = 0; attempt < 64; ++attempt){
+        if (pos.parse_fen(fen) != FenError::Ok) return false;
+        for (int i = 0;; ++i){
+            pos.generate_legal_moves(moves);
+            if (moves.empty() && i == 0) return false; // the opening itself is over
+            if (moves.empty() || i == plies) break;
+            pos.do_move(moves[rng() % moves.size()]);
+        }
+        if (!moves.empty()) return true;
+    }
+    return false;
+}
+
+} // namespace chess
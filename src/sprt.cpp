@@ -0,0 +1,54 @@
+#include "chess/sprt.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace chess {
+
+static double elo_of(double s){ return -400.0 * std::log10(1.0 / s - 1.0) + 0.0; } // no "-0.0"
+static double score_of(double elo){ return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+double MatchScore::score() const {
+    const uint64_t n = games();
+    return n ? (double(wins) + 0.5 * double(draws)) / double(n) : 0.5;
+}
+
+double MatchScore::elo() const { return elo_of(score()); }
+
+// per-game variance of the score for w/d/l games
+static double variance(double w, double d, double l){
+    const double n = w + d + l, s = (w + 0.5 * d) / n;
+    return (w * (1 - s) * (1 - s) + d * (0.5 - s) * (0.5 - s) + l * s * s) / n;
+}
+
+double MatchScore::elo_error95() const {
+    const uint64_t n = games();
+    if (!n) return 0;
+    if (!losses && !draws) return std::numeric_limits<double>::infinity(); // one-sided so far
+    if (!wins && !draws)   return std::numeric_limits<double>::infinity();
+    const double se = std::sqrt(variance(double(wins), double(draws), double(losses)) / double(n)), s = score();
+    const double lo = std::clamp(s - 1.959964 * se, 1e-9, 1 - 1e-9);
+    const double hi = std::clamp(s + 1.959964 * se, 1e-9, 1 - 1e-9);
+    return (elo_of(hi) - elo_of(lo)) / 2;
+}
+
+// Normal approximation: with pair scores x (0, 1/4, .. 1) of mean m and variance v over
+// N pairs, LLR = N (s1 - s0) (2m - s0 - s1) / (2v), s0/s1 the expected scores of H0/H1
+double MatchScore::llr(double elo0, double elo1) const {
+    const uint64_t n = pair_count();
+    if (!n) return 0;
+    double m = 0, var = 0;
+    for (int i = 0; i < 5; ++i) m += double(pairs[i]) * (i / 4.0);
+    m /= double(n);
+    for (int i = 0; i < 5; ++i) var += double(pairs[i]) * (i / 4.0 - m) * (i / 4.0 - m);
+    var /= double(n);
+    if (var <= 0) return 0;
+    const double s0 = score_of(elo0), s1 = score_of(elo1);
+    return double(n) * (s1 - s0) * (2 * m - s0 - s1) / (2 * var);
+}
+
+SprtBounds sprt_bounds(double alpha, double beta){
+    return { std::log(beta / (1 - alpha)), std::log((1 - beta) / alpha) };
+}
+
+} // namespace chess
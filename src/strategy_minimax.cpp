@@ -6,10 +6,17 @@
 
 namespace chess {
 
+// select_move() answers in "rc rc" form, which Game::move() auto-queens,
+// so underpromotions are not searched
+static inline bool searched(Move m) {
+    return !m.is_promo() || m.flag()==MF_PROMO_Q;
+}
+
 int MinimaxStrategy::search(Game& pos, int depth, int alpha, int beta) {
     if (depth==0) return evaluate(pos);
 
-    auto moves = pos.legal_moves();
+    MoveList moves;
+    pos.legal_moves(moves);
     if (moves.empty()) {
         if (pos.is_checkmate(pos.side_to_move()))
             return (pos.side_to_move()==Color::White ? -100000 : +100000);
@@ -17,51 +24,43 @@ int MinimaxStrategy::search(Game& pos, int depth, int alpha, int beta) {
     }
 
     bool maxing = (pos.side_to_move()==Color::White);
-    if (maxing) {
-        int best = std::numeric_limits<int>::min()/2;
-        for (auto& m : moves) {
-            Game child = pos; std::string err;
-            if (!child.move(m, err)) continue;
-            int sc = search(child, depth-1, alpha, beta);
-            best = std::max(best, sc);
-            alpha = std::max(alpha, sc);
-            if (beta <= alpha) break;
-        }
-        return best;
-    } else {
-        int best = std::numeric_limits<int>::max()/2;
-        for (auto& m : moves) {
-            Game child = pos; std::string err;
-            if (!child.move(m, err)) continue;
-            int sc = search(child, depth-1, alpha, beta);
-            best = std::min(best, sc);
-            beta = std::min(beta, sc);
-            if (beta <= alpha) break;
-        }
-        return best;
+    int best = maxing ? std::numeric_limits<int>::min()/2 : std::numeric_limits<int>::max()/2;
+    for (Move m : moves) {
+        if (!searched(m)) continue;
+        Game::Undo u;
+        pos.make_move(m, u);
+        int sc = search(pos, depth-1, alpha, beta);
+        pos.unmake_move(u);
+        if (maxing) { best = std::max(best, sc); alpha = std::max(alpha, sc); }
+        else        { best = std::min(best, sc); beta  = std::min(beta, sc);  }
+        if (beta <= alpha) break;
     }
+    return best;
 }
 
 std::string MinimaxStrategy::select_move(const Game& g0) {
-    Game root = g0; // need non-const for legal_moves()
-    auto moves = root.legal_moves();
+    Game root = g0; // searched in place via make/unmake
+    MoveList moves;
+    root.legal_moves(moves);
     if (moves.empty()) return "";
 
     int bestScore = (g0.side_to_move()==Color::White ? std::numeric_limits<int>::min()/2
                                                      : std::numeric_limits<int>::max()/2);
-    std::string best = moves.front();
+    Move best = moves[0];
 
-    for (auto& m : moves) {
-        Game child = g0; std::string err;
-        if (!child.move(m, err)) continue;
-        int sc = search(child, max_depth-1, std::numeric_limits<int>::min()/2, std::numeric_limits<int>::max()/2);
+    for (Move m : moves) {
+        if (!searched(m)) continue;
+        Game::Undo u;
+        root.make_move(m, u);
+        int sc = search(root, max_depth-1, std::numeric_limits<int>::min()/2, std::numeric_limits<int>::max()/2);
+        root.unmake_move(u);
         if (g0.side_to_move()==Color::White) {
             if (sc > bestScore) { bestScore = sc; best = m; }
         } else {
             if (sc < bestScore) { bestScore = sc; best = m; }
         }
     }
-    return best;
+    return Game::format_move(best);
 }
 
 } // namespace chess
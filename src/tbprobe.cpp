@@ -0,0 +1,778 @@
+#include "chess/tbprobe.hpp"
+#include "chess/mapped_file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace chess::tb {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ---- file format ----
+// After the magic: a flags byte, then per leading-pawn file (one without pawns) the
+// encoding order and pieces of each stored side, then per table: the Huffman code
+// lengths and the recursive-pairing symbol tree, the DTZ value maps, the sparse
+// index, the block lengths and the 64-byte aligned blocks of compressed values.
+enum Kind { WDL, DTZ };
+constexpr const char* EXT[2] = { ".rtbw", ".rtbz" };
+constexpr uint8_t MAGIC[2][4] = { {0x71, 0xE8, 0x23, 0x5D}, {0xD7, 0x66, 0x0C, 0xA5} };
+
+// per-table flags; all but SINGLE_VALUE are used by DTZ tables only
+enum : uint8_t { F_STM = 1, F_MAPPED = 2, F_WIN_PLIES = 4, F_LOSS_PLIES = 8, F_WIDE = 16, F_SINGLE_VALUE = 128 };
+
+inline uint16_t le16(const uint8_t* p){ return uint16_t(p[0] | p[1] << 8); }
+inline uint32_t le32(const uint8_t* p){ return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24; }
+inline uint32_t be32(const uint8_t* p){ return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]); }
+
+inline int file_of(int s){ return s & 7; }
+inline int rank_of(int s){ return s >> 3; }
+inline int off_diagonal(int s){ return rank_of(s) - file_of(s); } // < 0 below a1-h8, > 0 above
+
+// Syzygy piece codes: 1..6 white pawn..king, 9..14 black
+inline int piece_code(int c, int pt){ return pt + 1 + 8*c; }
+
+// ---- position indexing ----
+struct IndexTables {
+    int map_b1h1h7[64]{};        // squares below the a1-h8 diagonal -> 0..27
+    int map_a1d1d4[64]{};        // a1-d1-d4 triangle -> 0..9, the diagonal last
+    int map_kk[10][64]{};        // two kings, the first in the triangle -> 0..461
+    uint64_t binomial[6][64]{};  // [k][n]: ways to choose k of n squares
+    int map_pawns[64]{};         // a2..h7 -> 0..47, highest toward the edge and rank 2
+    uint64_t lead_pawn_idx[6][64]{};
+    uint64_t lead_pawns_size[6][4]{}; // [leading pawns][file a..d]
+
+    IndexTables(){
+        int code = 0;
+        for (int s = 0; s < 64; ++s)
+            if (off_diagonal(s) < 0) map_b1h1h7[s] = code++;
+
+        code = 0;
+        int diagonal[4], nd = 0;
+        for (int s = 0; s <= 27; ++s) // a1..d4
+            if (file_of(s) <= 3 && off_diagonal(s) < 0) map_a1d1d4[s] = code++;
+            else if (file_of(s) <= 3 && off_diagonal(s) == 0) diagonal[nd++] = s;
+        for (int i = 0; i < nd; ++i) map_a1d1d4[diagonal[i]] = code++;
+
+        // first king on the diagonal: the second may not be above it; pairs with both
+        // on the diagonal come last
+        code = 0;
+        int both[10*8][2], nb = 0;
+        for (int idx = 0; idx < 10; ++idx)
+            for (int s1 = 0; s1 <= 27; ++s1){
+                if (map_a1d1d4[s1] != idx || (idx == 0 && s1 != 1)) continue; // b1 is 0
+                for (int s2 = 0; s2 < 64; ++s2){
+                    if (std::abs(file_of(s1) - file_of(s2)) <= 1 && std::abs(rank_of(s1) - rank_of(s2)) <= 1) continue;
+                    if (!off_diagonal(s1) && off_diagonal(s2) > 0) continue;
+                    if (!off_diagonal(s1) && !off_diagonal(s2)) { both[nb][0] = idx; both[nb++][1] = s2; }
+                    else map_kk[idx][s2] = code++;
+                }
+            }
+        for (int i = 0; i < nb; ++i) map_kk[both[i][0]][both[i][1]] = code++;
+
+        binomial[0][0] = 1;
+        for (int n = 1; n < 64; ++n)
+            for (int k = 0; k < 6 && k <= n; ++k)
+                binomial[k][n] = (k > 0 ? binomial[k-1][n-1] : 0) + (k < n ? binomial[k][n-1] : 0);
+
+        int available = 47;
+        for (int lead = 1; lead <= 5; ++lead)
+            for (int f = 0; f < 4; ++f){
+                uint64_t idx = 0;
+                for (int r = 1; r <= 6; ++r){
+                    const int s = 8*r + f;
+                    if (lead == 1){
+                        map_pawns[s] = available--;
+                        map_pawns[s ^ 7] = available--;
+                    }
+                    lead_pawn_idx[lead][s] = idx;
+                    idx += binomial[lead-1][map_pawns[s]];
+                }
+                lead_pawns_size[lead][f] = idx;
+            }
+    }
+};
+const IndexTables IDX;
+
+// One compressed table: a side to move (WDL) for one leading-pawn file
+struct PairsData {
+    uint8_t flags = 0;
+    uint64_t block_size = 0;       // bytes per block
+    uint64_t span = 0;             // values between sparse index entries
+    uint64_t sparse_size = 0;
+    uint32_t num_blocks = 0, block_length_size = 0;
+    int max_len = 0, min_len = 0;  // code lengths; min_len holds the value of a single-value table
+    const uint8_t* lowest_sym = nullptr;   // u16 per code length: first symbol of that length
+    const uint8_t* btree = nullptr;        // 3 bytes per symbol: left and right child, 12 bits each
+    const uint8_t* sparse_index = nullptr; // 6 bytes per entry: block (u32), offset in it (u16)
+    const uint8_t* block_length = nullptr; // u16 per block: values in it minus one
+    const uint8_t* data = nullptr;
+    std::vector<uint64_t> base64;  // lowest code of each length, left-aligned in 64 bits
+    std::vector<uint8_t> symlen;   // values a symbol expands to, minus one
+    uint8_t pieces[7]{};           // piece codes in encoding order
+    int group_len[8]{};            // pieces per group, 0-terminated
+    uint64_t group_idx[8]{};       // index multiplier per group; [groups] = table size
+    uint16_t map_idx[4]{};         // DTZ value maps: win, loss, cursed win, blessed loss
+
+    int left(int s) const { return (btree[3*s+1] & 15) << 8 | btree[3*s]; }
+    int right(int s) const { return btree[3*s+2] << 4 | btree[3*s+1] >> 4; }
+    uint64_t size() const { int n = 0; while (group_len[n]) ++n; return group_idx[n]; }
+};
+
+struct TableFile {
+    std::string path;            // empty if this kind is absent
+    std::once_flag once;
+    MappedFile file;
+    bool ready = false;          // mapped and header parsed
+    int sides = 1;
+    const uint8_t* end = nullptr;
+    const uint8_t* map = nullptr; // DTZ value maps
+    PairsData items[2][4];       // [side to move, WDL only][leading pawn file, 0 without pawns]
+};
+
+struct Table {
+    std::string name;             // "KRvK": white's pieces first
+    uint64_t key = 0, key2 = 0;   // material as named / with colours swapped
+    int piece_count = 0;
+    bool has_pawns = false, has_unique = false; // unique: some non-king piece type appears once
+    uint8_t pawn_count[2]{};      // leading colour (the one with fewer pawns), other colour
+    int counts[2][5]{};           // [white, black as named][pawn..queen]
+    TableFile kind[2];
+};
+
+std::vector<std::unique_ptr<Table>> g_tables;
+std::unordered_map<uint64_t, Table*> g_by_key;
+int g_max_pieces = 0;
+std::atomic<size_t> g_mapped{0};
+
+// counts: 4 bits per colour and type
+uint64_t material_key(const int counts[2][5]){
+    uint64_t k = 0;
+    for (int c = 0; c < 2; ++c)
+        for (int pt = 0; pt < 5; ++pt) k |= uint64_t(counts[c][pt]) << (4 * (5*c + pt));
+    return k;
+}
+
+uint64_t material_key(const BoardBB& pos){
+    int counts[2][5];
+    for (int c = 0; c < 2; ++c)
+        for (int pt = 0; pt < 5; ++pt) counts[c][pt] = popcount(pos.bb.pcs[c][pt]);
+    return material_key(counts);
+}
+
+// "KRPvKR" -> piece counts per side; false unless each side is 'K' plus "QRBNP" letters
+bool parse_name(const std::string& s, int counts[2][5]){
+    const size_t v = s.find('v');
+    if (v == std::string::npos || s.size() > 8 || s[0] != 'K' || v + 1 >= s.size() || s[v+1] != 'K') return false;
+    std::memset(counts, 0, sizeof(int) * 10);
+    for (size_t i = 0; i < s.size(); ++i){
+        if (i == 0 || i == v || i == v + 1) continue;
+        const char* p = std::strchr("PNBRQ", s[i]);
+        if (!p || !s[i]) return false;
+        ++counts[i > v][p - "PNBRQ"];
+    }
+    return true;
+}
+
+// Groups are encoded together: same type and colour, or the leading group (pawns of
+// the leading colour; else three unique pieces, or the two kings). order[] says where
+// the leading group and the other side's pawns come in the mixed-radix index.
+void set_groups(const Table& t, PairsData& d, const int order[2], int f){
+    int n = 0, first_len = t.has_pawns ? 0 : t.has_unique ? 3 : 2;
+    d.group_len[n] = 1;
+    for (int i = 1; i < t.piece_count; ++i)
+        if (--first_len > 0 || d.pieces[i] == d.pieces[i-1]) d.group_len[n]++;
+        else d.group_len[++n] = 1;
+    d.group_len[++n] = 0;
+
+    const bool pp = t.has_pawns && t.pawn_count[1]; // pawns on both sides
+    int next = pp ? 2 : 1;
+    int free_squares = 64 - d.group_len[0] - (pp ? d.group_len[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; ++k)
+        if (k == order[0]){
+            d.group_idx[0] = idx;
+            idx *= t.has_pawns ? IDX.lead_pawns_size[d.group_len[0]][f] : t.has_unique ? 31332 : 462;
+        } else if (k == order[1]){
+            d.group_idx[1] = idx;
+            idx *= IDX.binomial[d.group_len[1]][48 - d.group_len[0]];
+        } else {
+            d.group_idx[next] = idx;
+            idx *= IDX.binomial[d.group_len[next]][free_squares];
+            free_squares -= d.group_len[next++];
+        }
+    d.group_idx[n] = idx;
+}
+
+// values symbol s stands for, minus one (its subtree in the pairing tree)
+uint8_t set_symlen(PairsData& d, int s, std::vector<bool>& visited){
+    visited[size_t(s)] = true;
+    const int r = d.right(s);
+    if (r == 0xFFF) return 0;
+    const int l = d.left(s);
+    if (!visited[size_t(l)]) d.symlen[size_t(l)] = set_symlen(d, l, visited);
+    if (!visited[size_t(r)]) d.symlen[size_t(r)] = set_symlen(d, r, visited);
+    return uint8_t(d.symlen[size_t(l)] + d.symlen[size_t(r)] + 1);
+}
+
+bool fits(const uint8_t* p, const uint8_t* end, uint64_t n){ return p <= end && uint64_t(end - p) >= n; }
+
+// Code lengths and symbol tree of one table; nullptr if they run past the file
+const uint8_t* set_sizes(PairsData& d, const uint8_t* p, const uint8_t* end){
+    if (!fits(p, end, 1)) return nullptr;
+    d.flags = *p++;
+    if (d.flags & F_SINGLE_VALUE){
+        if (!fits(p, end, 1)) return nullptr;
+        d.min_len = *p++;
+        return p;
+    }
+    if (!fits(p, end, 9) || p[0] > 20 || p[1] > 40) return nullptr;
+    d.block_size = uint64_t(1) << p[0];
+    d.span = uint64_t(1) << p[1];
+    d.sparse_size = (d.size() + d.span - 1) / d.span;
+    d.num_blocks = le32(p + 3);
+    d.block_length_size = d.num_blocks + p[2]; // padded so the sparse index stays in range
+    d.max_len = p[7];
+    d.min_len = p[8];
+    p += 9;
+    if (d.min_len < 1 || d.max_len < d.min_len || d.max_len > 32) return nullptr;
+
+    // canonical code: longer codes have lower values, lowest_sym[i] - lowest_sym[i+1]
+    // symbols have length min_len + i + 1
+    const size_t lengths = size_t(d.max_len - d.min_len + 1);
+    if (!fits(p, end, 2*lengths + 2)) return nullptr;
+    d.lowest_sym = p;
+    d.base64.assign(lengths, 0);
+    for (int i = int(lengths) - 2; i >= 0; --i)
+        d.base64[size_t(i)] = (d.base64[size_t(i)+1] + le16(p + 2*i) - le16(p + 2*i + 2)) / 2;
+    for (size_t i = 0; i < lengths; ++i) d.base64[i] <<= 64 - i - size_t(d.min_len);
+    p += 2*lengths;
+
+    const size_t symbols = le16(p);
+    p += 2;
+    if (!symbols || !fits(p, end, 3*symbols + (symbols & 1))) return nullptr;
+    d.btree = p;
+    for (size_t s = 0; s < symbols; ++s)
+        if (d.right(int(s)) != 0xFFF && (size_t(d.right(int(s))) >= symbols || size_t(d.left(int(s))) >= symbols))
+            return nullptr;
+    d.symlen.assign(symbols, 0);
+    std::vector<bool> visited(symbols);
+    for (size_t s = 0; s < symbols; ++s)
+        if (!visited[s]) d.symlen[s] = set_symlen(d, int(s), visited);
+    return p + 3*symbols + (symbols & 1);
+}
+
+// Parse the header of a freshly mapped file
+bool set_up(Table& t, Kind k){
+    TableFile& tf = t.kind[k];
+    if (!tf.file.open(tf.path, false)) return false;
+    const std::string_view v = tf.file.view();
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(v.data());
+    const uint8_t* end = tf.end = base + v.size();
+    if (v.size() < 5 || std::memcmp(base, MAGIC[k], 4)) return false;
+    const uint8_t* p = base + 4;
+    const bool split = *p & 1, pawns = *p & 2;
+    ++p;
+    if (pawns != t.has_pawns || split != (t.key != t.key2)) return false;
+
+    tf.sides = k == WDL && split ? 2 : 1;
+    const int files = t.has_pawns ? 4 : 1;
+    const bool pp = t.has_pawns && t.pawn_count[1];
+    for (int f = 0; f < files; ++f){
+        if (!fits(p, end, size_t(1 + pp + t.piece_count))) return false;
+        const int order[2][2] = { { p[0] & 15, pp ? p[1] & 15 : 15 }, { p[0] >> 4, pp ? p[1] >> 4 : 15 } };
+        p += 1 + pp;
+        for (int j = 0; j < t.piece_count; ++j, ++p)
+            for (int i = 0; i < tf.sides; ++i) tf.items[i][f].pieces[j] = uint8_t(i ? *p >> 4 : *p & 15);
+        for (int i = 0; i < tf.sides; ++i){
+            // the pieces must be this table's material
+            int seen[16]{}, want[16]{};
+            for (int j = 0; j < t.piece_count; ++j) ++seen[tf.items[i][f].pieces[j]];
+            for (int c = 0; c < 2; ++c){
+                ++want[piece_code(c, KING)];
+                for (int pt = 0; pt < 5; ++pt) want[piece_code(c, pt)] += t.counts[c][pt];
+            }
+            if (std::memcmp(seen, want, sizeof seen)) return false;
+            if (t.has_pawns && (tf.items[i][f].pieces[0] & 7) != piece_code(0, PAWN)) return false;
+            set_groups(t, tf.items[i][f], order[i], f);
+        }
+    }
+    p += (p - base) & 1;
+
+    for (int f = 0; f < files; ++f)
+        for (int i = 0; i < tf.sides; ++i)
+            if (!(p = set_sizes(tf.items[i][f], p, end))) return false;
+
+    if (k == DTZ){
+        tf.map = p;
+        for (int f = 0; f < files; ++f){
+            PairsData& d = tf.items[0][f];
+            if (!(d.flags & F_MAPPED)) continue;
+            if (d.flags & F_WIDE){
+                p += (p - base) & 1;
+                for (int i = 0; i < 4; ++i){
+                    if (!fits(p, end, 2)) return false;
+                    d.map_idx[i] = uint16_t((p - tf.map) / 2 + 1);
+                    p += 2 * le16(p) + 2;
+                }
+            } else {
+                for (int i = 0; i < 4; ++i){
+                    if (!fits(p, end, 1)) return false;
+                    d.map_idx[i] = uint16_t(p - tf.map + 1);
+                    p += *p + 1;
+                }
+            }
+        }
+        p += (p - base) & 1;
+    }
+
+    for (int f = 0; f < files; ++f)
+        for (int i = 0; i < tf.sides; ++i){
+            PairsData& d = tf.items[i][f];
+            if (!fits(p, end, 6 * d.sparse_size)) return false;
+            d.sparse_index = p;
+            p += 6 * d.sparse_size;
+        }
+    for (int f = 0; f < files; ++f)
+        for (int i = 0; i < tf.sides; ++i){
+            PairsData& d = tf.items[i][f];
+            if (!fits(p, end, 2 * uint64_t(d.block_length_size))) return false;
+            d.block_length = p;
+            p += 2 * uint64_t(d.block_length_size);
+        }
+    for (int f = 0; f < files; ++f)
+        for (int i = 0; i < tf.sides; ++i){
+            PairsData& d = tf.items[i][f];
+            p = base + ((p - base + 63) & ~ptrdiff_t(63));
+            if (!fits(p, end, d.num_blocks * d.block_size)) return false;
+            d.data = p;
+            p += d.num_blocks * d.block_size;
+        }
+    return true;
+}
+
+TableFile* mapped(Table& t, Kind k){
+    TableFile& tf = t.kind[k];
+    if (tf.path.empty()) return nullptr;
+    std::call_once(tf.once, [&]{
+        tf.ready = set_up(t, k);
+        if (tf.ready) ++g_mapped;
+        else tf.file.close();
+    });
+    return tf.ready ? &tf : nullptr;
+}
+
+// Value number idx of a table, -1 if the data is inconsistent. Each block holds up to
+// 65536 values as Huffman-coded symbols; a symbol expands through the pairing tree
+// into symlen + 1 consecutive values.
+int decompress(const PairsData& d, uint64_t idx, const uint8_t* end){
+    if (d.flags & F_SINGLE_VALUE) return d.min_len;
+
+    // the sparse index entry k points at value k * span + span / 2; walk the block
+    // lengths from there to the block holding idx
+    const uint64_t k = idx / d.span;
+    if (k >= d.sparse_size) return -1;
+    uint32_t block = le32(d.sparse_index + 6*k);
+    int64_t offset = le16(d.sparse_index + 6*k + 4);
+    offset += int64_t(idx % d.span) - int64_t(d.span / 2);
+    if (block >= d.block_length_size) return -1;
+    while (offset < 0){
+        if (!block) return -1;
+        offset += le16(d.block_length + 2 * --block) + 1;
+    }
+    while (offset > le16(d.block_length + 2*block)){
+        offset -= le16(d.block_length + 2*block) + 1;
+        if (++block >= d.block_length_size) return -1;
+    }
+    if (block >= d.num_blocks) return -1;
+
+    // codes are read MSB first through a 64-bit window, refilled 32 bits at a time
+    const uint8_t* ptr = d.data + block * d.block_size;
+    auto next32 = [&]() -> uint64_t { uint64_t w = fits(ptr, end, 4) ? be32(ptr) : 0; ptr += 4; return w; };
+    uint64_t buf = next32() << 32;
+    buf |= next32();
+    int bits = 64;
+    int sym;
+    for (;;){
+        size_t len = 0;
+        while (buf < d.base64[len]) ++len; // base64.back() is 0
+        sym = int((buf - d.base64[len]) >> (64 - len - size_t(d.min_len)));
+        sym += le16(d.lowest_sym + 2*len);
+        if (size_t(sym) >= d.symlen.size()) return -1;
+        if (offset < d.symlen[size_t(sym)] + 1) break;
+        offset -= d.symlen[size_t(sym)] + 1;
+        len += size_t(d.min_len);
+        buf <<= len;
+        bits -= int(len);
+        if (bits <= 32){
+            bits += 32;
+            buf |= next32() << (64 - bits);
+        }
+    }
+
+    // pairs expand left then right, so the offset picks the branch
+    while (d.symlen[size_t(sym)]){
+        const int l = d.left(sym);
+        if (offset < d.symlen[size_t(l)] + 1) sym = l;
+        else {
+            offset -= d.symlen[size_t(l)] + 1;
+            sym = d.right(sym);
+        }
+    }
+    return d.left(sym);
+}
+
+enum class State { Fail, Ok, ChangeStm, ZeroingBestMove };
+
+// DTZ tables keep values per WDL class, sorted by frequency, and count in moves
+// unless the plies flags are set; cursed and blessed results always count in moves.
+int map_score(const TableFile& tf, int f, int value, int wdl){
+    static constexpr int WDL_MAP[5] = { 1, 3, 0, 2, 0 }; // by wdl + 2
+    const PairsData& d = tf.items[0][f];
+    if (d.flags & F_MAPPED){
+        const int i = d.map_idx[WDL_MAP[wdl + 2]] + value;
+        if (d.flags & F_WIDE) value = fits(tf.map + 2*i, tf.end, 2) ? le16(tf.map + 2*i) : 0;
+        else                  value = fits(tf.map + i, tf.end, 1) ? tf.map[i] : 0;
+    }
+    if ((wdl == 2 && !(d.flags & F_WIN_PLIES)) || (wdl == -2 && !(d.flags & F_LOSS_PLIES)) || wdl == 1 || wdl == -1)
+        value *= 2;
+    return value + 1;
+}
+
+// Table value for pos: WDL -2..2, or DTZ plies for the given WDL. Tables are stored
+// with white as the side named first; other positions are colour-flipped first.
+int probe_table(const BoardBB& pos, Kind k, int wdl, State& st){
+    if (popcount(pos.occ_all()) == 2) return 0; // bare kings
+    const uint64_t key = material_key(pos);
+    auto it = g_by_key.find(key);
+    if (it == g_by_key.end()) { st = State::Fail; return 0; }
+    Table& t = *it->second;
+    const TableFile* tf = mapped(t, k);
+    if (!tf) { st = State::Fail; return 0; }
+
+    const bool black_to_move = pos.side == BLACK;
+    const bool flip = t.key == t.key2 ? black_to_move : key != t.key;
+    const int flip_color = flip ? 8 : 0, flip_squares = flip ? 56 : 0;
+    const int stm = int(flip) ^ int(black_to_move);
+
+    int squares[8], pieces[8], size = 0, lead = 0, file = 0;
+    Bitboard lead_pawns = 0;
+    auto by_map_pawns = [](int a, int b){ return IDX.map_pawns[a] < IDX.map_pawns[b]; };
+    if (t.has_pawns){
+        // leading pawns first; the one toward the edge and rank 2 picks the table
+        const int pc = tf->items[0][0].pieces[0] ^ flip_color;
+        lead_pawns = pos.bb.pcs[pc >> 3][PAWN];
+        for (Bitboard b = lead_pawns; b; b &= b-1) squares[size++] = lsb(b) ^ flip_squares;
+        lead = size;
+        std::swap(squares[0], *std::max_element(squares, squares + lead, by_map_pawns));
+        file = std::min(file_of(squares[0]), 7 - file_of(squares[0]));
+    }
+
+    // DTZ tables store one side to move per file
+    if (k == DTZ && (tf->items[0][file].flags & F_STM) != stm && !(t.key == t.key2 && !t.has_pawns)){
+        st = State::ChangeStm;
+        return 0;
+    }
+
+    for (int c = 0; c < 2; ++c)
+        for (int pt = 0; pt < 6; ++pt)
+            for (Bitboard b = pos.bb.pcs[c][pt] & ~lead_pawns; b && size < 8; b &= b-1){
+                squares[size] = lsb(b) ^ flip_squares;
+                pieces[size++] = piece_code(c, pt) ^ flip_color;
+            }
+    if (size != t.piece_count) { st = State::Fail; return 0; }
+
+    const PairsData& d = tf->items[k == WDL ? stm % tf->sides : 0][file];
+
+    // put the pieces in the table's encoding order
+    for (int i = lead; i < size - 1; ++i)
+        for (int j = i + 1; j < size; ++j)
+            if (d.pieces[i] == pieces[j]){
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+
+    // mirror so the leading piece is on files a-d
+    if (file_of(squares[0]) > 3)
+        for (int i = 0; i < size; ++i) squares[i] ^= 7;
+
+    uint64_t idx;
+    if (t.has_pawns){
+        idx = IDX.lead_pawn_idx[lead][squares[0]];
+        std::stable_sort(squares + 1, squares + lead, by_map_pawns);
+        for (int i = 1; i < lead; ++i) idx += IDX.binomial[i][IDX.map_pawns[squares[i]]];
+    } else {
+        // without pawns also mirror to ranks 1-4, then below the a1-h8 diagonal: the
+        // first leading piece off the diagonal decides
+        if (rank_of(squares[0]) > 3)
+            for (int i = 0; i < size; ++i) squares[i] ^= 56;
+        for (int i = 0; i < d.group_len[0]; ++i){
+            if (!off_diagonal(squares[i])) continue;
+            if (off_diagonal(squares[i]) > 0)
+                for (int j = i; j < size; ++j) squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+        }
+        if (t.has_unique){
+            // three leading pieces: 6 squares of the triangle below the diagonal, or
+            // the diagonal pieces first and the first off-diagonal piece below it
+            const int adjust1 = squares[1] > squares[0];
+            const int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (off_diagonal(squares[0]))
+                idx = (uint64_t(IDX.map_a1d1d4[squares[0]]) * 63 + uint64_t(squares[1] - adjust1)) * 62
+                      + uint64_t(squares[2] - adjust2);
+            else if (off_diagonal(squares[1]))
+                idx = (6*63 + uint64_t(rank_of(squares[0])) * 28 + uint64_t(IDX.map_b1h1h7[squares[1]])) * 62
+                      + uint64_t(squares[2] - adjust2);
+            else if (off_diagonal(squares[2]))
+                idx = 6*63*62 + 4*28*62 + uint64_t(rank_of(squares[0])) * 7*28
+                      + uint64_t(rank_of(squares[1]) - adjust1) * 28 + uint64_t(IDX.map_b1h1h7[squares[2]]);
+            else
+                idx = 6*63*62 + 4*28*62 + 4*7*28 + uint64_t(rank_of(squares[0])) * 7*6
+                      + uint64_t(rank_of(squares[1]) - adjust1) * 6 + uint64_t(rank_of(squares[2]) - adjust2);
+        } else {
+            idx = uint64_t(IDX.map_kk[IDX.map_a1d1d4[squares[0]]][squares[1]]);
+        }
+    }
+
+    // remaining groups: squares sorted within a group, counted without the squares
+    // taken by earlier groups (and the first/last rank for the other side's pawns)
+    idx *= d.group_idx[0];
+    int* group_sq = squares + d.group_len[0];
+    bool remaining_pawns = t.has_pawns && t.pawn_count[1];
+    for (int next = 1; d.group_len[next]; ++next){
+        std::stable_sort(group_sq, group_sq + d.group_len[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d.group_len[next]; ++i){
+            const int below = int(std::count_if(squares, group_sq, [&](int s){ return group_sq[i] > s; }));
+            n += IDX.binomial[i + 1][group_sq[i] - below - 8 * remaining_pawns];
+        }
+        remaining_pawns = false;
+        idx += n * d.group_idx[next];
+        group_sq += d.group_len[next];
+    }
+    if (idx >= d.size()) { st = State::Fail; return 0; }
+
+    const int value = decompress(d, idx, tf->end);
+    if (value < 0) { st = State::Fail; return 0; }
+    return k == WDL ? value - 2 : map_score(*tf, file, value, wdl);
+}
+
+inline bool in_check(const BoardBB& pos){ return pos.square_attacked(pos.king_square(pos.side), other(pos.side)); }
+inline bool is_capture(const BoardBB& pos, Move m){
+    return m.flag() == MF_EP || (pos.occ_side(other(pos.side)) & bb(Square(m.to())));
+}
+inline bool is_pawn_move(const BoardBB& pos, Move m){ return pos.pieces(pos.side, PAWN) & bb(Square(m.from())); }
+inline int sign_of(int v){ return (v > 0) - (v < 0); }
+
+// DTZ just before a capture or pawn move with this result
+inline int dtz_before_zeroing(int wdl){ return wdl == 2 ? 1 : wdl == 1 ? 101 : wdl == -1 ? -101 : wdl == -2 ? -1 : 0; }
+
+// WDL of pos. Tables may store any value where a capture (for DTZ also a pawn move)
+// decides the result, so those moves are searched and the best result taken.
+// st = ZeroingBestMove when such a move is best: the DTZ table value is not usable.
+int search(BoardBB& pos, bool pawn_moves, State& st){
+    int best = -2, legal = 0, searched = 0;
+    MoveList ml;
+    pos.generate_moves(ml);
+    for (Move m : ml){
+        if (!pos.is_legal(m)) continue;
+        ++legal;
+        if (!is_capture(pos, m) && (!pawn_moves || !is_pawn_move(pos, m))) continue;
+        ++searched;
+        pos.do_move(m);
+        const int v = -search(pos, false, st);
+        pos.undo_move();
+        if (st == State::Fail) return 0;
+        if (v > best){
+            best = v;
+            if (v >= 2) { st = State::ZeroingBestMove; return v; }
+        }
+    }
+    // every move was searched: the table value may be wrong (it ignores EP, for one)
+    const bool no_more_moves = searched && searched == legal;
+    int v = best;
+    if (!no_more_moves){
+        v = probe_table(pos, WDL, 0, st);
+        if (st == State::Fail) return 0;
+    }
+    if (best >= v){
+        st = best > 0 || no_more_moves ? State::ZeroingBestMove : State::Ok;
+        return best;
+    }
+    st = State::Ok;
+    return v;
+}
+
+int dtz(BoardBB& pos, State& st){
+    st = State::Ok;
+    const int wdl = search(pos, true, st);
+    if (st == State::Fail || wdl == 0) return 0;
+    if (st == State::ZeroingBestMove) return dtz_before_zeroing(wdl);
+
+    int d = probe_table(pos, DTZ, wdl, st);
+    if (st == State::Fail) return 0;
+    if (st != State::ChangeStm) return (d + 100 * (wdl == 1 || wdl == -1)) * sign_of(wdl);
+
+    // the table holds the other side to move: best DTZ over one ply
+    int best = 0xFFFF;
+    MoveList ml;
+    pos.generate_moves(ml);
+    for (Move m : ml){
+        if (!pos.is_legal(m)) continue;
+        const bool zeroing = is_capture(pos, m) || is_pawn_move(pos, m);
+        pos.do_move(m);
+        // a zeroing move counts from before it; search() gives the sign
+        d = zeroing ? -dtz_before_zeroing(search(pos, false, st)) : -dtz(pos, st);
+        if (d == 1 && in_check(pos) && !pos.count_legal_moves()) best = 1; // mate
+        if (!zeroing) d += sign_of(d);
+        if (d < best && sign_of(d) == sign_of(wdl)) best = d;
+        pos.undo_move();
+        if (st == State::Fail) return 0;
+    }
+    return best == 0xFFFF ? -1 : best; // no legal move: mated
+}
+
+bool probeable(const BoardBB& pos){
+    return g_max_pieces && !pos.castling && popcount(pos.occ_all()) <= g_max_pieces;
+}
+
+} // namespace
+
+int init(const std::string& paths){
+    g_by_key.clear();
+    g_tables.clear();
+    g_max_pieces = 0;
+    g_mapped = 0;
+    if (paths.empty() || paths == "<empty>") return 0;
+#ifdef _WIN32
+    const char sep = ';';
+#else
+    const char sep = ':';
+#endif
+    std::unordered_map<std::string, Table*> by_name;
+    int found = 0;
+    for (size_t b = 0; b <= paths.size(); ){
+        const size_t e = std::min(paths.find(sep, b), paths.size());
+        std::error_code ec;
+        for (fs::directory_iterator it(paths.substr(b, e - b), ec), end; !ec && it != end; it.increment(ec)){
+            const std::string name = it->path().stem().string(), ext = it->path().extension().string();
+            const int k = ext == EXT[WDL] ? WDL : ext == EXT[DTZ] ? DTZ : -1;
+            int counts[2][5];
+            if (k < 0 || !parse_name(name, counts)) continue;
+            Table*& t = by_name[name];
+            if (!t){
+                g_tables.push_back(std::make_unique<Table>());
+                t = g_tables.back().get();
+                t->name = name;
+                std::memcpy(t->counts, counts, sizeof counts);
+                int swapped[2][5];
+                for (int c = 0; c < 2; ++c) std::memcpy(swapped[c], counts[1 - c], sizeof swapped[c]);
+                t->key = material_key(counts);
+                t->key2 = material_key(swapped);
+                t->piece_count = 2;
+                for (int c = 0; c < 2; ++c)
+                    for (int pt = 0; pt < 5; ++pt){
+                        t->piece_count += counts[c][pt];
+                        t->has_unique |= counts[c][pt] == 1;
+                    }
+                t->has_pawns = counts[0][PAWN] || counts[1][PAWN];
+                // leading colour: the side with pawns, the one with fewer if both have some
+                const bool white_leads = !counts[1][PAWN] || (counts[0][PAWN] && counts[1][PAWN] >= counts[0][PAWN]);
+                t->pawn_count[0] = uint8_t(counts[white_leads ? 0 : 1][PAWN]);
+                t->pawn_count[1] = uint8_t(counts[white_leads ? 1 : 0][PAWN]);
+                g_by_key.emplace(t->key, t);
+                g_by_key.emplace(t->key2, t);
+            }
+            if (!t->kind[k].path.empty()) continue; // first directory wins
+            t->kind[k].path = it->path().string();
+            ++found;
+            g_max_pieces = std::max(g_max_pieces, t->piece_count);
+        }
+        b = e + 1;
+    }
+    return found;
+}
+
+int max_pieces(){ return g_max_pieces; }
+size_t mapped_tables(){ return g_mapped; }
+
+bool probe_wdl(BoardBB& pos, Wdl& out){
+    if (!probeable(pos)) return false;
+    State st = State::Ok;
+    const int v = search(pos, false, st);
+    if (st == State::Fail) return false;
+    out = Wdl(v);
+    return true;
+}
+
+bool probe_dtz(BoardBB& pos, int& out){
+    if (!probeable(pos)) return false;
+    State st;
+    const int v = dtz(pos, st);
+    if (st == State::Fail) return false;
+    out = v;
+    return true;
+}
+
+// Any position since the last capture or pawn move occurred twice?
+static bool repeated_since_zeroing(const BoardBB& pos){
+    const int n = std::min<int>(pos.halfmove, int(pos.stack.size()));
+    auto key_at = [&](int back){ return back ? pos.stack[pos.stack.size() - size_t(back)].key : pos.key; };
+    for (int i = 0; i <= n; ++i)
+        for (int j = i + 4; j <= n; j += 2)
+            if (key_at(i) == key_at(j)) return true;
+    return false;
+}
+
+bool filter_root_moves(BoardBB& pos, std::vector<Move>& moves){
+    if (!probeable(pos) || moves.empty()) return false;
+    const int rule50 = pos.halfmove;
+    const bool rep = repeated_since_zeroing(pos);
+    std::vector<int> rank(moves.size());
+
+    // DTZ from the root: wins within the 50-move rule first, the quickest best; then
+    // wins spoiled by it; draws; losses, the slowest best. A repetition since the last
+    // zeroing move may have spent the margin, so such wins are only sure at dtz <= 1.
+    bool dtz_ok = true;
+    for (size_t i = 0; i < moves.size() && dtz_ok; ++i){
+        pos.do_move(moves[i]);
+        State st = State::Ok;
+        int d;
+        if (pos.halfmove == 0) d = dtz_before_zeroing(-search(pos, false, st));
+        else {
+            d = -dtz(pos, st);
+            d += sign_of(d);
+        }
+        if (d == 2 && in_check(pos) && !pos.count_legal_moves()) d = 1; // mate
+        pos.undo_move();
+        dtz_ok = st != State::Fail;
+        rank[i] = d > 0 ? (d + rule50 <= 100 && (!rep || d <= 1) ? 3000 : 1000) - d
+                : d < 0 ? (-d + rule50 <= 100 ? -3000 : -1000) - d
+                : 0;
+    }
+    // without DTZ tables: WDL only
+    if (!dtz_ok)
+        for (size_t i = 0; i < moves.size(); ++i){
+            pos.do_move(moves[i]);
+            State st = State::Ok;
+            const int w = -search(pos, false, st);
+            pos.undo_move();
+            if (st == State::Fail) return false;
+            rank[i] = w;
+        }
+
+    const int best = *std::max_element(rank.begin(), rank.end());
+    size_t n = 0;
+    for (size_t i = 0; i < moves.size(); ++i)
+        if (rank[i] == best) moves[n++] = moves[i];
+    moves.resize(n);
+    return true;
+}
+
+} // namespace chess::tb
@@ -0,0 +1,24 @@
+#include "chess/training.hpp"
+#include <cstdlib>
+
+namespace chess {
+
+uint8_t result_code(GameResult r){
+    switch (r){
+        case GameResult::WhiteWin: return 2;
+        case GameResult::BlackWin: return 0;
+        default:                   return 1;
+    }
+}
+
+bool trainable(const BoardBB& pos, const SearchResult& r, int max_score){
+    if (!r.best.v || r.best.is_capture() || r.best.is_promo()) return false;
+    if (std::abs(r.score) > max_score) return false;
+    return !pos.square_attacked(pos.king_square(pos.side), other(pos.side));
+}
+
+std::span<const TrainingRecord> training_records(std::string_view data){
+    return { reinterpret_cast<const TrainingRecord*>(data.data()), data.size() / sizeof(TrainingRecord) };
+}
+
+} // namespace chess
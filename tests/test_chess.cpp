@@ -1,10 +1,30 @@
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <thread>
 #include <iostream>
+#include <type_traits>
 
 #include "chess/game.hpp"
 #include "chess/board.hpp"
 #include "chess/piece.hpp"
+#include "chess/board_bb.hpp"
+#include "chess/attacks.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/eval_terms.hpp"
+#include "chess/mapped_file.hpp"
+#include "chess/pgn.hpp"
+#include "chess/polyglot.hpp"
+#include "chess/san.hpp"
+#include "chess/selfplay.hpp"
+#include "chess/sprt.hpp"
+#include "chess/tbprobe.hpp"
+#include "chess/training.hpp"
+#include "chess/search_bb.hpp"
 
 using namespace chess;
 
@@ -22,9 +42,7 @@ static bool do_bad(Game& g, const std::string& mv) {
 }
 static char at(const Game& g, int r, int c) {
     const Board& b = g.get_board();
-    const Piece* p = b.board[r][c].get();
-    if (!p) return '-';
-    return p->display().empty() ? '?' : p->display()[0];
+    return b.board[r][c].display();
 }
 static Color turn(const Game& g) { return g.side_to_move(); }
 
@@ -96,13 +114,893 @@ void test_deep_copy_independence() {
     assert(at(g,1,4) == '-' && at(g,3,4) == 'P');
 }
 
+void test_board_is_value_type() {
+    static_assert(sizeof(Piece) == 1);
+    static_assert(sizeof(Board) == ROWS * COLS + 2); // mailbox + king-square cache
+    static_assert(std::is_trivially_copyable_v<Board>);
+    Game g;
+    std::string err;
+    assert(g.load_fen("4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1", err));
+    assert(at(g,0,0)=='R' && at(g,0,4)=='K' && at(g,7,4)=='k');
+    assert(g.debug_can_castle_king_side(Color::White));
+    assert(g.debug_can_castle_queen_side(Color::White));
+}
+
+// make_move/unmake_move must restore board, side and EP/castling state exactly
+void test_make_unmake_roundtrip() {
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+    };
+    for (const char* fen : fens) {
+        Game g; std::string err;
+        assert(g.load_fen(fen, err));
+        const Game before = g;
+        MoveList moves;
+        g.legal_moves(moves);
+        for (Move m : moves) {
+            Game::Undo u;
+            g.make_move(m, u);
+            assert(turn(g) != turn(before));
+            g.unmake_move(u);
+            assert(std::memcmp(&g.get_board(), &before.get_board(), sizeof(Board)) == 0);
+            assert(turn(g) == turn(before));
+            MoveList again;
+            g.legal_moves(again);
+            assert(again.size() == moves.size());
+            assert(std::equal(again.begin(), again.end(), moves.begin()));
+        }
+    }
+}
+
+// Packed moves carry each promotion piece; the string view shows one per square pair
+void test_move_list_promotions() {
+    Game g; std::string err;
+    assert(g.load_fen("8/P6k/8/8/8/8/8/K7 w - - 0 1", err));
+    MoveList ml;
+    g.legal_moves(ml);
+    int promos = 0;
+    Move under;
+    for (Move m : ml) {
+        if (!m.is_promo()) continue;
+        ++promos;
+        assert(m.from() == 6*8+0 && m.to() == 7*8+0);
+        if (m.flag() == MF_PROMO_N) under = m;
+    }
+    assert(promos == 4);
+    assert(ml.size() == 3 + 4);            // Ka1: a2, b1, b2
+    assert(g.legal_moves().size() == 3 + 1);
+    assert(Game::format_move(under) == "60 70");
+
+    g.apply(under);
+    assert(at(g,7,0) == 'N' && at(g,6,0) == '-');
+    assert(turn(g) == Color::Black);
+}
+
+// Board::king_sq follows king moves (including castling) and is restored by unmake
+void test_king_square_cache() {
+    Game g; std::string err;
+    assert(g.get_board().king_pos(Color::White) == std::make_pair(0,4));
+    assert(g.load_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", err));
+    MoveList ml;
+    g.legal_moves(ml);
+    for (Move m : ml) {
+        if (m.flag() != MF_CASTLE) continue;
+        Game::Undo u;
+        g.make_move(m, u);
+        assert(g.get_board().king_pos(Color::White) == std::make_pair(0, int(m.to()%8)));
+        assert(g.get_board().king_pos(Color::Black) == std::make_pair(7,4));
+        g.unmake_move(u);
+        assert(g.get_board().king_pos(Color::White) == std::make_pair(0,4));
+    }
+}
+
+// BoardBB::encode/decode round-trips through FEN, including EP and large clocks
+void test_packed_position_roundtrip() {
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2k5/8/8/8/8/5K2/8 b - - 99 300",
+        "4k3/8/8/8/8/8/8/4K2R w K - 0 1",
+    };
+    for (const char* fen : fens) {
+        BoardBB a, b;
+        assert(a.set_fen(fen));
+        PackedPos pp;
+        assert(a.encode(pp));
+        assert(b.decode(pp));
+        assert(b.to_fen() == fen);
+        PackedPos again;
+        assert(b.encode(again) && again == pp);
+    }
+
+    PackedPos bad;
+    BoardBB b;
+    bad.data[0] = 1;     // one piece on a1 ...
+    bad.data[8] = 0x7;   // ... with piece code 7
+    assert(!b.decode(bad));
+
+    // EP byte: out of range, or on the wrong rank for the side to move
+    BoardBB a;
+    assert(a.set_fen(fens[2]));
+    PackedPos ep;
+    assert(a.encode(ep) && ep.data[25] == F6);
+    for (uint8_t byte : {uint8_t(0x80), uint8_t(0xFE), uint8_t(64), uint8_t(F3), uint8_t(F5), uint8_t(A1)}) {
+        bad = ep;
+        bad.data[25] = byte;
+        assert(!b.decode(bad));
+    }
+    bad = ep;
+    bad.data[25] = 0xFF;
+    assert(b.decode(bad) && b.ep_sq == -1);
+    bad.data[24] |= 1;   // Black to move: a rank-3 square is fine, rank 6 is not
+    bad.data[25] = F3;
+    assert(b.decode(bad));
+    bad.data[25] = F6;
+    assert(!b.decode(bad));
+}
+
+// parse_fen reports why a FEN is rejected; write_fen fills a caller buffer
+void test_fen_parse_errors() {
+    BoardBB b;
+    assert(b.parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -") == FenError::Ok);
+    assert(b.fullmove == 1);
+    assert(b.parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w") == FenError::MissingField);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4K3 w - - 0 1 x") == FenError::TrailingData);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4X3 w - - 0 1") == FenError::BadPiece);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4K4 w - - 0 1") == FenError::BadRankLength);
+    assert(b.parse_fen("4k3/8/8/8/8/8/4K3 w - - 0 1") == FenError::BadRankCount);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4K3 x - - 0 1") == FenError::BadSide);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4K3 w KK - 0 1") == FenError::BadCastling);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4K3 w - e6 0 1") == FenError::BadEnPassant);
+    assert(b.parse_fen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1") == FenError::Ok);
+    assert(b.parse_fen("4k3/8/8/8/8/8/8/4K3 w - - x 1") == FenError::BadClock);
+    assert(b.parse_fen("8/8/8/8/8/8/8/4K3 w - - 0 1") == FenError::KingCount);
+    assert(b.parse_fen("4k3/8/8/8/8/PPPPPPPP/P7/4K3 w - - 0 1") == FenError::TooManyPieces);
+    assert(b.parse_fen("P3k3/8/8/8/8/8/8/4K3 w - - 0 1") == FenError::PawnOnBackRank);
+
+    const char* fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 12 345";
+    assert(b.parse_fen(fen) == FenError::Ok);
+    char buf[FEN_BUF_SIZE];
+    assert(b.write_fen(buf, 10) == 0);
+    assert(b.write_fen(buf, sizeof buf) == std::strlen(fen));
+    assert(std::strcmp(buf, fen) == 0);
+}
+
+// PV starts with the best move and is legal; a node budget stops deepening early
+void test_search_pv_and_node_limit() {
+    init_attacks();
+    BoardBB pos;
+    assert(pos.set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+    const std::string fen = pos.to_fen();
+
+    SearchResult r = search_position(pos, 3);
+    assert(r.depth == 3 && !r.pv.empty() && r.pv.size() <= 3);
+    assert(r.pv[0] == r.best);
+    for (Move m : r.pv) {
+        std::vector<Move> ml;
+        pos.generate_legal_moves(ml);
+        assert(std::find(ml.begin(), ml.end(), m) != ml.end());
+        pos.do_move(m);
+    }
+    for (size_t i = 0; i < r.pv.size(); ++i) pos.undo_move();
+    assert(pos.to_fen() == fen);
+
+    SearchResult lim = search_position(pos, SearchLimits{MAX_PLY - 1, 5000});
+    assert(lim.depth >= 1 && lim.depth < MAX_PLY - 1);
+    assert(lim.nodes <= 5001);
+    assert(lim.best.v != 0 && lim.pv[0] == lim.best);
+    assert(pos.to_fen() == fen);
+}
+
+void test_line_cursor() {
+    LineCursor lc("a\r\n\nbc\nd");
+    std::string_view l;
+    assert(lc.next(l) && l == "a");
+    assert(lc.next(l) && l.empty());
+    assert(lc.next(l) && l == "bc");
+    assert(lc.next(l) && l == "d" && lc.line_no() == 4);
+    assert(!lc.next(l));
+}
+
+struct PgnCollector : PgnVisitor {
+    int games = 0, plies = 0, bad = 0, ep = 0, promos = 0, underpromos = 0;
+    void begin_game() override { ++games; }
+    void ply(const BoardBB&, Move m, GameResult) override {
+        ++plies;
+        if (m.flag() == MF_EP) ++ep;
+        if (m.is_promo()) { ++promos; if (m.flag() != MF_PROMO_Q) ++underpromos; }
+    }
+    void end_game(GameResult, bool ok) override { if (!ok) ++bad; }
+};
+
+// games.pgn: Opera game, EP/promotion/disambiguation, FEN start, comments and variations
+void test_pgn_reader() {
+    MappedFile f(CHESS_TEST_DATA "/games.pgn");
+    assert(f.is_open());
+
+    PgnCollector c;
+    PgnReader r(f.view());
+    while (r.next_game(c)) {}
+    assert(r.stats().games == 5 && r.stats().plies == 69 && r.stats().errors == 0);
+    assert(c.games == 5 && c.plies == 69 && c.bad == 0);
+    assert(c.ep == 1 && c.promos == 2 && c.underpromos == 1);
+
+    auto parts = split_pgn(f.view(), 3);
+    assert(parts.size() == 3);
+    for (auto part : parts) assert(part[0] == '[');
+    PgnCollector a, b;
+    PgnStats ps = read_pgn_parallel(f.view(), {&a, &b});
+    assert(ps.games == 5 && ps.plies == 69 && a.plies + b.plies == 69);
+
+    // both knights reach d4: plain "Nd4" is ambiguous and stops the replay
+    PgnCollector amb;
+    PgnReader ra("1. Nc3 e6 2. Nf3 e5 3. Nb5 e4 4. Nd4 *");
+    while (ra.next_game(amb)) {}
+    assert(amb.plies == 6 && amb.bad == 1 && ra.stats().errors == 1);
+}
+
+static std::string san_of(const char* fen, const std::string& uci) {
+    BoardBB pos;
+    assert(pos.parse_fen(fen) == FenError::Ok);
+    std::vector<Move> ml;
+    pos.generate_legal_moves(ml);
+    for (Move m : ml) if (to_uci(m) == uci) return to_san(pos, m);
+    assert(false && "no such move");
+    return "";
+}
+
+void test_san_roundtrip() {
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        "1k6/8/8/8/Q7/8/8/Q2Q3K w - - 0 1",
+    };
+    for (const char* fen : fens) {
+        BoardBB pos;
+        assert(pos.parse_fen(fen) == FenError::Ok);
+        std::vector<Move> ml;
+        pos.generate_legal_moves(ml);
+        for (Move m : ml) assert(parse_san(pos, to_san(pos, m)) == m);
+    }
+
+    const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    const char* kiwi  = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    const char* queens = "1k6/8/8/8/Q7/8/8/Q2Q3K w - - 0 1";
+    const char* promo = "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1";
+    assert(san_of(start, "g1f3") == "Nf3" && san_of(start, "e2e4") == "e4");
+    assert(san_of(kiwi, "e1g1") == "O-O" && san_of(kiwi, "e1c1") == "O-O-O");
+    assert(san_of(kiwi, "e5g6") == "Nxg6" && san_of(kiwi, "d5e6") == "dxe6");
+    assert(san_of(queens, "a1d4") == "Qa1d4" && san_of(queens, "a4d4") == "Q4d4" && san_of(queens, "d1d4") == "Qdd4");
+    assert(san_of(promo, "g2h1q") == "gxh1=Q" && san_of(promo, "g2f1n") == "gxf1=N" && san_of(promo, "g2g1n") == "g1=N+");
+    assert(san_of("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", "e5f6") == "exf6");
+    assert(san_of("rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq g3 0 2", "d8h4") == "Qh4#");
+
+    BoardBB pos;
+    pos.set_startpos();
+    assert(to_uci(parse_san(pos, "Nf3!?")) == "g1f3" && to_uci(parse_san(pos, "e4")) == "e2e4");
+    assert(!parse_san(pos, "e5").v && !parse_san(pos, "Ke2").v && !parse_san(pos, "Nd4").v && !parse_san(pos, "O-O").v);
+    assert(pos.parse_fen(promo) == FenError::Ok);
+    assert(to_uci(parse_san(pos, "gxf1Q")) == "g2f1q" && !parse_san(pos, "gxf1K").v);
+}
+
+static BoardBB bb_from(const char* fen) {
+    BoardBB p;
+    assert(p.parse_fen(fen) == FenError::Ok);
+    return p;
+}
+
+void test_polyglot_book() {
+    const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    const char* kiwi  = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    BoardBB sp = bb_from(start), kp = bb_from(kiwi);
+
+    // transpositions share a key; the ep file only counts when a capture is possible
+    BoardBB a = sp, b = sp;
+    for (const char* m : {"Nf3", "Nf6", "Nc3"}) a.do_move(parse_san(a, m));
+    for (const char* m : {"Nc3", "Nf6", "Nf3"}) b.do_move(parse_san(b, m));
+    assert(polyglot_key(a) == polyglot_key(b) && polyglot_key(a) != polyglot_key(sp));
+    BoardBB e4 = sp;
+    e4.do_move(parse_san(e4, "e4"));
+    assert(polyglot_key(e4) == polyglot_key(bb_from("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1")));
+    assert(polyglot_key(bb_from("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3"))
+        != polyglot_key(bb_from("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3")));
+
+    Move oo = parse_san(kp, "O-O");
+    assert(to_polyglot_move(oo) == (E1 << 6 | H1) && from_polyglot_move(kp, to_polyglot_move(oo)) == oo);
+    assert(!from_polyglot_move(sp, uint16_t(E2 << 6 | E5)).v);
+
+    std::vector<BookEntry> es = {
+        {polyglot_key(sp), to_polyglot_move(parse_san(sp, "e4")), 3, 0},
+        {polyglot_key(sp), to_polyglot_move(parse_san(sp, "d4")), 1, 0},
+        {polyglot_key(e4), to_polyglot_move(parse_san(e4, "e5")), 5, 7},
+        {polyglot_key(kp), to_polyglot_move(oo), 1, 0},
+    };
+    std::stable_sort(es.begin(), es.end(), [](const BookEntry& x, const BookEntry& y) { return x.key < y.key; });
+    const char* path = "polyglot_test.bin";
+    std::FILE* f = std::fopen(path, "wb");
+    assert(f);
+    for (const BookEntry& e : es) {
+        unsigned char buf[BOOK_ENTRY_SIZE];
+        write_entry(buf, e);
+        BookEntry back = read_entry(buf);
+        assert(back.key == e.key && back.move == e.move && back.weight == e.weight && back.learn == e.learn);
+        std::fwrite(buf, 1, sizeof buf, f);
+    }
+    std::fclose(f);
+
+    PolyglotBook book;
+    assert(book.open(path) && book.size() == 4);
+    std::vector<BookEntry> found;
+    assert(book.find(polyglot_key(sp), found) == 2 && book.find(12345, found) == 0);
+    assert(to_san(sp, book.pick(sp, BookPick::Best)) == "e4");
+    assert(to_san(sp, book.pick(sp, BookPick::Weighted, 2)) == "e4");
+    assert(to_san(sp, book.pick(sp, BookPick::Weighted, 3)) == "d4");
+    assert(to_san(e4, book.pick(e4, BookPick::Weighted, 99)) == "e5");
+    assert(book.pick(kp, BookPick::Best) == oo);
+    assert(!book.pick(a, BookPick::Best).v);
+
+    f = std::fopen(path, "ab");
+    std::fputc(0, f);
+    std::fclose(f);
+    assert(!book.open(path) && !book.is_open());
+
+    // the reference table is only installed if it reproduces the documented keys
+    const uint64_t before = polyglot_key(sp);
+    const bool standard = polyglot_keys_standard();
+    std::string wrong;
+    for (uint64_t i = 1; i <= 781; ++i) {
+        char buf[24];
+        std::snprintf(buf, sizeof buf, "0x%016llX,\n", (unsigned long long)(i * 0x9E3779B97F4A7C15ULL));
+        wrong += buf;
+    }
+    assert(!load_polyglot_random64(wrong) && !load_polyglot_random64(wrong.substr(0, 780 * 20)));
+    assert(polyglot_key(sp) == before && polyglot_keys_standard() == standard);
+    if (const char* ref = std::getenv("CHESS_POLYGLOT_RANDOM64")) {
+        assert(standard); // the same table is compiled in; loading it again is a no-op override
+        MappedFile table;
+        assert(table.open(ref) && load_polyglot_random64(table.view()) && polyglot_keys_standard());
+        assert(polyglot_key(sp) == 0x463B96181691FC9CULL);
+        // e3 does not count (no black pawn beside e4), f6 does; Ke2 drops KQ
+        assert(polyglot_key(e4) == 0x823C9B50FD114196ULL);
+        assert(polyglot_key(bb_from("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3")) == 0x22A48B5A8E47FF78ULL);
+        assert(polyglot_key(bb_from("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3")) == 0x652A607CA3F242C1ULL);
+    }
+    std::remove(path);
+}
+
+// The book chess_bookgen writes from games.pgn (bookgen_probe): only games 1 (1-0) and
+// 2 (0-1) count, both 1. e4, so the start position has e4 with 2 + 0 points and after
+// 1. e4 only Black's winning d5 is kept (e5 scored nothing).
+void test_generated_book(const char* path) {
+    init_attacks();
+    PolyglotBook book;
+    assert(book.open(path) && book.size() == 30);
+    BoardBB sp = bb_from("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    std::vector<BookEntry> found;
+    assert(book.find(polyglot_key(sp), found) == 1);
+    assert(found[0].move == to_polyglot_move(parse_san(sp, "e4")) && found[0].weight == 2);
+    assert(to_san(sp, book.pick(sp, BookPick::Weighted, 12345)) == "e4");
+    sp.do_move(parse_san(sp, "e4"));
+    found.clear();
+    assert(book.find(polyglot_key(sp), found) == 1);
+    assert(found[0].move == to_polyglot_move(parse_san(sp, "d5")) && found[0].weight == 2);
+    sp.do_move(parse_san(sp, "d5")); // 2. e5 lost
+    assert(!book.pick(sp, BookPick::Best).v);
+}
+
+void test_bitbases() {
+    auto result = [](const char* fen) {
+        Color strong; bool wins;
+        assert(bitbase::probe(bb_from(fen), strong, wins));
+        return wins ? (strong == WHITE ? 1 : -1) : 0;
+    };
+    // king on the sixth in front of the pawn wins with either side to move
+    assert(result("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1") == 1 && result("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1") == 1);
+    assert(result("k7/8/8/8/8/8/P7/K7 w - - 0 1") == 0);  // rook pawn, defender in the corner
+    assert(result("7k/8/8/8/8/8/P7/K7 w - - 0 1") == 1);  // pawn outruns the king
+    assert(result("8/8/8/4p3/4k3/8/8/4K3 b - - 0 1") == -1); // colours mirrored
+    assert(result("8/8/8/4p3/4k3/8/8/4K3 w - - 0 1") == 0);  // White takes the opposition
+    assert(result("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1") == 0);   // stalemate
+    assert(result("k7/2Q5/1K6/8/8/8/8/8 w - - 0 1") == 1);
+    assert(result("8/8/8/3k4/8/8/8/R3K3 b - - 0 1") == 1);
+    assert(result("8/8/8/8/8/8/1k6/R6K b - - 0 1") == 0);  // the rook hangs
+
+    Color strong; bool wins;
+    assert(!bitbase::probe(bb_from("4k3/8/8/8/8/8/8/4K2R w K - 0 1"), strong, wins)); // castling rights
+    assert(!bitbase::probe(bb_from("4k3/8/8/8/8/8/8/2B1K3 w - - 0 1"), strong, wins)); // KBK not covered
+    assert(!bitbase::probe(bb_from("4k3/8/8/8/8/8/4P3/R3K3 w - - 0 1"), strong, wins));
+
+    assert(eval_bb(bb_from("k7/8/8/8/8/8/P7/K7 w - - 0 1")) == 0);
+    assert(eval_bb(bb_from("7k/8/8/8/8/8/P7/K7 w - - 0 1")) > 5000);
+    assert(eval_bb(bb_from("8/8/8/4p3/4k3/8/8/4K3 b - - 0 1")) < -5000);
+}
+
+void test_repetition_and_fifty_moves() {
+    BoardBB p;
+    p.set_startpos();
+    const uint64_t start = p.key;
+    auto play = [&](std::initializer_list<const char*> sans) {
+        for (const char* san : sans) {
+            Move m = parse_san(p, san);
+            assert(m.v);
+            p.do_move(m);
+            assert(p.key == p.compute_key());
+        }
+    };
+    play({"Nf3", "Nf6", "Ng1"});
+    assert(p.has_upcoming_repetition(4) && !p.has_upcoming_repetition(3)); // ...Ng8 returns to a searched node
+    play({"Ng8"});
+    assert(p.key == start && p.halfmove == 4);
+    assert(p.is_repetition(4) && !p.is_repetition(0));  // inside the search / only twofold before the root
+    play({"Nf3", "Nf6", "Ng1", "Ng8"});
+    assert(p.is_repetition(0));                         // threefold
+    play({"e4"});
+    assert(p.halfmove == 0 && !p.is_repetition(9));     // pawn moves close the window
+    for (int i = 0; i < 9; ++i) p.undo_move();
+    assert(p.key == start && p.halfmove == 0);
+
+    // a double push nobody can take en passant leaves no ep square, so the knight dance repeats it
+    play({"e4"});
+    const uint64_t after_e4 = p.key;
+    assert(p.ep_sq < 0);
+    play({"Nf6", "Nf3", "Ng8", "Ng1"});
+    assert(p.key == after_e4 && p.is_repetition(4));
+    for (int i = 0; i < 5; ++i) p.undo_move();
+    assert(p.key == start);
+    BoardBB d5 = bb_from("rnbqkbnr/ppp1pppp/8/8/3p4/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    d5.do_move(parse_san(d5, "e4"));
+    assert(d5.ep_sq == E3 && d5.key == d5.compute_key());
+    assert(bb_from("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1").key == after_e4);
+
+    // castling counts one ply; clocks above 255 survive undo
+    BoardBB c = bb_from("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 300 200");
+    c.do_move(parse_san(c, "O-O"));
+    assert(c.halfmove == 301 && c.key == c.compute_key());
+    c.undo_move();
+    assert(c.halfmove == 300);
+
+    // every quiet move hits the 50-move rule, so the material edge is worth nothing
+    BoardBB f = bb_from("k7/8/8/8/8/8/8/K5QR w - - 99 80");
+    assert(search_position(f, 3).score == 0);
+    f.halfmove = 0;
+    assert(search_position(f, 3).score > 1000);
+}
+
+void test_compact_move_and_state_stack() {
+    static_assert(sizeof(Move) == 2 && sizeof(State) == 16);
+    Move m(E7, E8, MF_PROMO_Q);
+    assert(m.from() == E7 && m.to() == E8 && m.is_promo() && !m.is_capture());
+
+    // a long knight shuffle wraps the ring; the newest CAPACITY records stay usable
+    BoardBB p;
+    p.set_startpos();
+    const char* shuffle[] = {"Nf3", "Nf6", "Ng1", "Ng8"};
+    const int plies = StateStack::CAPACITY + 60;
+    for (int i = 0; i < plies; ++i) p.do_move(parse_san(p, shuffle[i % 4]));
+    assert(p.stack.size() == size_t(StateStack::CAPACITY));
+    BoardBB copy = p;
+    assert(copy.stack.size() == p.stack.size() && copy.is_repetition(0));
+    for (int i = 0; i < StateStack::CAPACITY; ++i) {
+        p.undo_move();
+        assert(p.key == p.compute_key());
+    }
+    assert(p.stack.empty());
+
+    // promotion with capture, en passant and castling come back from the flag alone
+    BoardBB q = bb_from("r3k2r/1P6/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1");
+    const uint64_t key = q.key;
+    for (const char* san : {"exd6", "O-O", "bxa8=N", "Rf7", "O-O-O"}) {
+        Move mv = parse_san(q, san);
+        assert(mv.v);
+        q.do_move(mv);
+    }
+    for (int i = 0; i < 5; ++i) q.undo_move();
+    assert(q.key == key && q.key == q.compute_key() && q.ep_sq == D6);
+    assert(q.pieces(WHITE, PAWN) == ((1ULL << B7) | (1ULL << E5)));
+    assert(q.pieces(BLACK, ROOK) == ((1ULL << A8) | (1ULL << H8)) && q.pieces(BLACK, PAWN) == (1ULL << D5));
+}
+
+void test_copy_make_matches_do_move() {
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+    };
+    for (const char* fen : fens) {
+        BoardBB pos = bb_from(fen), child;
+        std::vector<Move> ml;
+        pos.generate_legal_moves(ml);
+        for (Move m : ml) {
+            child.copy_make(pos, m);
+            pos.do_move(m);
+            assert(child.to_fen() == pos.to_fen() && child.key == pos.key);
+            pos.undo_move();
+        }
+    }
+
+    // the child keeps the history a repetition check can reach
+    BoardBB p;
+    p.set_startpos();
+    for (const char* san : {"e4", "e5", "Nf3", "Nf6", "Ng1", "Ng8", "Nf3"}) p.do_move(parse_san(p, san));
+    BoardBB c;
+    c.copy_make(p, parse_san(p, "Nf6"));
+    assert(c.stack.size() == 6 && c.is_repetition(4) && !c.is_repetition(3));
+}
+
+// GenType splits: Captures + Quiets == All, and the legal evasions match All filtered
+void test_gen_types() {
+    MappedFile f(CHESS_TEST_DATA "/perftsuite.epd");
+    assert(f.is_open());
+    LineCursor cur(f.view());
+    std::string_view line;
+    auto sorted = [](std::vector<Move> v) {
+        std::sort(v.begin(), v.end(), [](Move a, Move b) { return a.v < b.v; });
+        return v;
+    };
+    auto check = [&](BoardBB& pos) {
+        std::vector<Move> all, caps, quiets, evasions, legal;
+        pos.generate_moves(all);
+        pos.generate_moves(caps, GenType::Captures);
+        pos.generate_moves(quiets, GenType::Quiets);
+        for (Move m : caps)   assert(m.is_capture() || m.is_promo());
+        for (Move m : quiets) assert(!m.is_capture() && !m.is_promo());
+        caps.insert(caps.end(), quiets.begin(), quiets.end());
+        assert(sorted(caps) == sorted(all));
+        pos.generate_legal_moves(legal);
+        pos.generate_moves(evasions, GenType::Evasions);
+        std::vector<Move> filtered;
+        for (Move m : all) {
+            pos.do_move(m);
+            if (!pos.square_attacked(pos.king_square(other(pos.side)), pos.side)) filtered.push_back(m);
+            pos.undo_move();
+        }
+        assert(legal == filtered && evasions.size() <= all.size());
+        assert(pos.count_legal_moves() == int(legal.size()));
+        for (Move m : all) assert(pos.is_legal(m) == (std::find(legal.begin(), legal.end(), m) != legal.end()));
+    };
+    int positions = 0, in_check = 0;
+    while (cur.next(line)) {
+        BoardBB pos;
+        if (pos.parse_fen(line.substr(0, line.find(';'))) != FenError::Ok) continue;
+        std::vector<Move> ml, replies;
+        pos.generate_legal_moves(ml);
+        for (Move m : ml) {
+            pos.do_move(m);
+            pos.generate_legal_moves(replies);
+            for (Move r : replies) {
+                pos.do_move(r);
+                check(pos);
+                ++positions;
+                in_check += pos.square_attacked(pos.king_square(pos.side), other(pos.side));
+                pos.undo_move();
+            }
+            pos.undo_move();
+        }
+    }
+    assert(positions > 20000 && in_check > 1000);
+}
+
+// batch_attacks (AVX2 lanes and scalar tail) against per-piece lookups
+void test_batch_attacks() {
+    MappedFile f(CHESS_TEST_DATA "/perftsuite.epd");
+    assert(f.is_open());
+    LineCursor cur(f.view());
+    std::string_view line;
+    std::vector<BoardBB> boards;
+    while (cur.next(line)) {
+        BoardBB pos;
+        if (pos.parse_fen(line.substr(0, line.find(';'))) != FenError::Ok) continue;
+        std::vector<Move> ml;
+        pos.generate_legal_moves(ml);
+        for (Move m : ml) { pos.do_move(m); boards.push_back(pos); pos.undo_move(); }
+    }
+    boards.resize(boards.size() / 4 * 4 + 3); // leave a scalar tail
+    std::vector<Bitboards> in;
+    for (const BoardBB& b : boards) in.push_back(b.bb);
+    std::vector<AttackInfo> fast(in.size()), slow(in.size());
+    batch_attacks(in.data(), fast.data(), in.size());
+    batch_attacks_scalar(in.data(), slow.data(), in.size());
+
+    int checks = 0;
+    for (size_t i = 0; i < boards.size(); ++i) {
+        const BoardBB& b = boards[i];
+        for (Color c : {WHITE, BLACK}) {
+            const int k = ci(c);
+            const Bitboard own = b.occ_side(c), occ = b.occ_all();
+            Bitboard att = 0;
+            int mob = 0;
+            for (int s = 0; s < 64; ++s) {
+                const Square sq = Square(s);
+                const Bitboard bit = ONE << s;
+                Bitboard a = 0;
+                if (b.pieces(c, KNIGHT) & bit) a = attacks_knight(sq);
+                if (b.pieces(c, BISHOP) & bit) a = attacks_bishop(sq, occ);
+                if (b.pieces(c, ROOK) & bit)   a = attacks_rook(sq, occ);
+                if (b.pieces(c, QUEEN) & bit)  a = attacks_queen(sq, occ);
+                mob += popcount(a & ~own);
+                if (b.pieces(c, PAWN) & bit) a |= attacks_pawn(c, sq);
+                if (b.pieces(c, KING) & bit) a |= attacks_king(sq);
+                att |= a;
+            }
+            const Bitboard chk = b.attackers_to(b.king_square(c), other(c));
+            checks += chk != 0;
+            for (const AttackInfo* r : {&fast[i], &slow[i]})
+                assert(r->attacks[k] == att && r->mobility[k] == mob && r->checkers[k] == chk);
+        }
+    }
+    assert(checks > 50);
+}
+
+void test_match_stats_and_selfplay() {
+    MatchScore m{60, 20, 20};
+    assert(std::abs(m.score() - 0.7) < 1e-12 && std::abs(m.elo() - 147.19) < 0.01);
+    assert(m.elo_error95() > 0 && m.elo_error95() < 100);
+    // pentanomial LLR; reference values from N (s1-s0)(2m-s0-s1) / (2 var) in double precision
+    MatchScore better{}, worse{}, none{}, even{}, same{};
+    const uint64_t up[5] = {5, 20, 50, 30, 10}, flat[5] = {0, 10, 80, 10, 0};
+    for (int i = 0; i < 5; ++i) { better.pairs[i] = up[i]; worse.pairs[i] = up[4 - i]; even.pairs[i] = flat[i]; }
+    assert(std::abs(better.llr(0, 5) - 0.570002) < 1e-6 && std::abs(better.llr(-5, 0) - 0.672839) < 1e-6);
+    assert(std::abs(worse.llr(0, 5) + 0.672839) < 1e-6 && std::abs(worse.llr(-5, 0) + 0.570002) < 1e-6);
+    assert(std::abs(even.llr(0, 5) + 0.207077) < 1e-6 && std::abs(even.llr(-5, 0) - 0.207077) < 1e-6);
+    same.pairs[4] = 3;    // no spread yet: no evidence either way
+    assert(none.llr(0, 5) == 0 && same.llr(0, 5) == 0 && m.llr(0, 5) == 0);
+    SprtBounds b = sprt_bounds(0.05, 0.05);
+    assert(std::abs(b.lower + 2.944) < 1e-3 && std::abs(b.upper - 2.944) < 1e-3);
+
+    SearchLimits lim[2];
+    lim[0].depth = lim[1].depth = 2;
+    Adjudication adj;
+    BoardBB mate = bb_from("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    int hooked = 0;
+    PlayedGame g = play_game(mate, lim, adj, [&](const BoardBB&, const SearchResult&) { ++hooked; });
+    assert(g.result == GameResult::WhiteWin && g.end == GameEnd::Mate && g.plies == 1 && hooked == 1);
+    BoardBB bare = bb_from("8/8/4k3/8/8/3NK3/8/8 w - - 0 1");
+    assert(play_game(bare, lim, adj).end == GameEnd::Material);
+    BoardBB kqk = bb_from("8/8/4k3/8/8/4K3/8/7Q b - - 0 1");
+    g = play_game(kqk, lim, adj);
+    assert(g.result == GameResult::WhiteWin && g.end == GameEnd::Bitbase && g.plies == 0);
+
+    // finished positions are no openings; random lines always leave a move to play
+    auto openings = load_openings("# mated, stalemated, bad, then two usable\n"
+                                  "R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1\n"
+                                  "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1; stalemate\n"
+                                  "not a fen\n"
+                                  "  rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ; id \"start\"\r\n"
+                                  "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1\n");
+    assert(openings.size() == 2 && openings[0] == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    std::mt19937_64 rng(7);
+    BoardBB pos;
+    std::vector<Move> moves;
+    assert(!random_opening(pos, "R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1", 0, rng));
+    for (int i = 0; i < 20; ++i) {
+        assert(random_opening(pos, openings[1], 1, rng)); // Ra8 mates, so some lines are redrawn
+        pos.generate_legal_moves(moves);
+        assert(!moves.empty() && pos.side == BLACK);
+    }
+}
+
+void test_training_records() {
+    assert(result_code(GameResult::WhiteWin) == 2 && result_code(GameResult::BlackWin) == 0
+           && result_code(GameResult::Draw) == 1);
+    SearchResult r;
+    r.best = Move(12, 28, MF_QUIET); // e2e4
+    r.score = 30;
+    BoardBB start = bb_from("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    assert(trainable(start, r, 2000) && !trainable(start, r, 20));
+    BoardBB check = bb_from("4k3/8/8/8/8/8/8/R3K2r w - - 0 1");
+    r.best = Move(4, 12, MF_QUIET);
+    assert(!trainable(check, r, 2000));
+    r.best = Move(0, 7, MF_CAPTURE);
+    assert(!trainable(check, r, 2000));
+
+    // records of a short game survive the byte-level round trip
+    SearchLimits lim[2];
+    lim[0].depth = lim[1].depth = 1;
+    Adjudication adj;
+    adj.max_plies = 12;
+    std::vector<TrainingRecord> recs;
+    std::vector<std::string> fens;
+    play_game(start, lim, adj, [&](const BoardBB& p, const SearchResult& sr) {
+        TrainingRecord rec;
+        assert(p.encode(rec.pos));
+        rec.score = int16_t(p.side == WHITE ? sr.score : -sr.score);
+        recs.push_back(rec);
+        fens.push_back(p.to_fen());
+    });
+    assert(recs.size() == 12);
+    std::string bytes(reinterpret_cast<const char*>(recs.data()), recs.size() * sizeof(TrainingRecord));
+    bytes += "xyz"; // partial trailing record
+    auto view = training_records(bytes);
+    assert(view.size() == recs.size());
+    BoardBB back;
+    for (size_t i = 0; i < view.size(); ++i) {
+        assert(back.decode(view[i].pos) && back.to_fen() == fens[i]);
+        assert(view[i].score == recs[i].score && view[i].result == 1);
+    }
+}
+
+void test_eval_terms() {
+    // arbitrary weights, so that every term shows up in eval_bb
+    const EvalWeights saved = eval_weights();
+    EvalWeights w;
+    for (int i = 0; i < EVAL_TERM_COUNT; ++i) w.w[i] = int16_t((i * 37) % 61 - 30);
+    set_eval_weights(w);
+    MappedFile f(CHESS_TEST_DATA "/perftsuite.epd");
+    assert(f.is_open());
+    LineCursor cur(f.view());
+    std::string_view line;
+    std::vector<EvalFeature> feats;
+    int positions = 0;
+    while (cur.next(line)) {
+        BoardBB pos;
+        if (pos.parse_fen(line.substr(0, line.find(';'))) != FenError::Ok) continue;
+        if (!eval_features(pos, feats)) continue; // bitbase ending
+        int sum = 0;
+        for (size_t i = 0; i < feats.size(); ++i) {
+            assert(feats[i].count != 0 && (i == 0 || feats[i - 1].term < feats[i].term));
+            sum += w.w[feats[i].term] * feats[i].count;
+        }
+        assert(sum == eval_bb(pos));
+        ++positions;
+    }
+    assert(positions > 100);
+    set_eval_weights(saved);
+
+    // the shipped weights keep the material + mobility evaluation
+    BoardBB start = bb_from("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    assert(eval_features(start, feats) && feats.size() == 1 && feats[0].term == TERM_MOBILITY && feats[0].count == 20);
+    assert(eval_bb(start) == 20);
+    assert(!eval_features(bb_from("7k/8/8/8/8/8/P7/K7 w - - 0 1"), feats) && feats.empty());
+
+    // chess_tune output parses back; anything but EVAL_TERM_COUNT int16 values is refused
+    auto weights_text = [&](int n) {
+        std::string t = "inline constexpr EvalWeights DEFAULT_EVAL_WEIGHTS = {{\n    // material\n    ";
+        for (int i = 0; i < n; ++i) t += std::to_string(w.w[i]) + (i % 8 == 7 ? ",\n    " : ", ");
+        return t + "\n}};\n";
+    };
+    const std::string text = weights_text(EVAL_TERM_COUNT);
+    EvalWeights parsed = saved;
+    assert(parse_eval_weights(text, parsed) && std::equal(parsed.w, parsed.w + EVAL_TERM_COUNT, w.w));
+    EvalWeights untouched = saved;
+    assert(!parse_eval_weights(weights_text(EVAL_TERM_COUNT - 1), untouched));
+    std::string big = text;
+    big.replace(big.find("-30,"), 3, "40000"); // w[0]
+    assert(!parse_eval_weights(big, untouched));
+    assert(std::equal(untouched.w, untouched.w + EVAL_TERM_COUNT, saved.w));
+
+    // SearchLimits::weights apply to that search only, and only on its thread
+    EvalWeights zero{};
+    SearchLimits lim;
+    lim.depth = 2;
+    const int base = search_position(start, lim).score;
+    lim.weights = &zero;
+    int zero_score = 1;
+    std::thread([&] { zero_score = search_position(start, lim).score; }).join();
+    assert(zero_score == 0 && eval_bb(start) == 20);
+    lim.weights = nullptr;
+    assert(search_position(start, lim).score == base && base != 0);
+}
+
+// King and piece against king: strong is the side with the piece; false if illegal
+static bool three_men(BoardBB& pos, Color strong, PieceType pt, int sk, int wk, int p, Color stm) {
+    if (sk == wk || sk == p || wk == p || (pt == PAWN && (p < 8 || p >= 56))) return false;
+    const int flip = strong == WHITE ? 0 : 56;
+    char board[64];
+    std::fill(board, board + 64, '1');
+    board[sk ^ flip] = strong == WHITE ? 'K' : 'k';
+    board[wk ^ flip] = strong == WHITE ? 'k' : 'K';
+    board[p ^ flip] = char((strong == WHITE ? "PNBRQ" : "pnbrq")[pt]);
+    std::string fen;
+    for (int r = 7; r >= 0; --r) {
+        fen.append(board + 8*r, 8);
+        if (r) fen += '/';
+    }
+    fen += stm == WHITE ? " w - - 0 1" : " b - - 0 1";
+    return pos.parse_fen(fen) == FenError::Ok && !pos.square_attacked(pos.king_square(other(stm)), stm);
+}
+
+void test_syzygy_tables() {
+    init_attacks();
+    bitbase::init();
+    assert(tb::init(std::string(CHESS_TEST_DATA) + "/syzygy") == 10 && tb::max_pieces() == 3);
+    assert(tb::mapped_tables() == 0); // mapped on first use
+
+    // WDL against the bitbases, either colour strong and to move
+    const PieceType types[3] = {QUEEN, ROOK, PAWN};
+    BoardBB pos;
+    for (PieceType pt : types)
+        for (Color strong : {WHITE, BLACK})
+            for (Color stm : {WHITE, BLACK})
+                for (int i = 0; i < 64*64*64; i += 7) {
+                    if (!three_men(pos, strong, pt, i >> 12, i >> 6 & 63, i & 63, stm)) continue;
+                    Color s; bool wins;
+                    Wdl w;
+                    assert(bitbase::probe(pos, s, wins) && tb::probe_wdl(pos, w));
+                    assert(w == (!wins ? Wdl::Draw : stm == strong ? Wdl::Win : Wdl::Loss));
+                }
+    assert(tb::mapped_tables() == 3);
+
+    // longest DTZ: mate in 10 with the queen, 16 with the rook, with the winner to move
+    int longest[2] = {0, 0};
+    BoardBB far[2];
+    for (int t = 0; t < 2; ++t)
+        for (int i = 0; i < 64*64*64; ++i) {
+            int d;
+            if (!three_men(pos, WHITE, types[t], i >> 12, i >> 6 & 63, i & 63, BLACK) || !tb::probe_dtz(pos, d)) continue;
+            if (-d > longest[t]) { longest[t] = -d; far[t] = pos; }
+        }
+    assert(longest[0] == 20 && longest[1] == 32);
+
+    // best play from there: DTZ drops by one a ply down to mate (-1)
+    for (BoardBB& p : far) {
+        int d;
+        assert(tb::probe_dtz(p, d));
+        for (;;) {
+            std::vector<Move> moves;
+            p.generate_legal_moves(moves);
+            if (moves.empty()) break;
+            assert(tb::filter_root_moves(p, moves));
+            p.do_move(moves.front());
+            int next;
+            assert(tb::probe_dtz(p, next));
+            assert(d == 1 ? next == -1 : std::abs(next) == std::abs(d) - 1 && (next > 0) != (d > 0));
+            d = next;
+        }
+        assert(d == -1 && p.square_attacked(p.king_square(p.side), other(p.side)));
+    }
+
+    // pawn endings: a won one keeps only the quickest zeroing moves (pawn pushes here)
+    Wdl w;
+    pos = bb_from("7k/8/8/8/8/8/P7/K7 w - - 0 1");
+    assert(tb::probe_wdl(pos, w) && w == Wdl::Win);
+    pos = bb_from("k7/8/8/8/8/8/P7/K7 w - - 0 1");
+    assert(tb::probe_wdl(pos, w) && w == Wdl::Draw);
+    pos = bb_from("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1");
+    assert(tb::probe_wdl(pos, w) && w == Wdl::Loss);
+    pos = bb_from("8/8/8/8/8/4k3/4P3/4K3 b - - 0 1"); // the pawn falls
+    assert(tb::probe_wdl(pos, w) && w == Wdl::Draw);
+    pos = bb_from("8/8/8/8/8/8/2k1P3/4K3 w - - 0 1");
+    std::vector<Move> moves;
+    pos.generate_legal_moves(moves);
+    assert(tb::filter_root_moves(pos, moves) && !moves.empty());
+    for (Move m : moves) assert(m.from() == E2);
+
+    // not covered: castling rights, four pieces
+    pos = bb_from("4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+    assert(!tb::probe_wdl(pos, w));
+    pos = bb_from("4k3/8/8/8/8/8/4P3/R3K3 w - - 0 1");
+    assert(!tb::probe_wdl(pos, w));
+
+    // the search takes the table result after a capture, and at the root
+    pos = bb_from("8/8/8/3k4/8/n7/8/R3K3 w - - 0 1");
+    SearchResult r = search_position(pos, 3);
+    assert(to_uci(r.best) == "a1a3" && r.tbhits > 0 && r.score > 40000);
+    pos = bb_from("8/8/8/8/8/8/1k6/R6K b - - 0 1");
+    r = search_position(pos, 3);
+    assert(to_uci(r.best) == "b2a1" && r.score == 0);
+
+    assert(tb::init("") == 0 && tb::max_pieces() == 0);
+    pos = bb_from("8/8/8/3k4/8/8/8/R3K3 w - - 0 1");
+    assert(!tb::probe_wdl(pos, w) && search_position(pos, 3).tbhits == 0);
+}
+
 void test_legal_moves_nonempty_start() {
     Game g;
     auto lm = g.legal_moves();
     assert(!lm.empty());
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc == 3 && std::string(argv[1]) == "--book") {
+        test_generated_book(argv[2]);
+        std::cout << "Book tests passed!\n";
+        return 0;
+    }
     std::cout << "Running tests...\n";
     test_initial_setup();
     test_simple_move_and_turn();
@@ -110,6 +1008,27 @@ int main() {
     test_en_passant();
     test_kingside_castling_white();
     test_deep_copy_independence();
+    test_board_is_value_type();
+    test_make_unmake_roundtrip();
+    test_move_list_promotions();
+    test_king_square_cache();
+    test_packed_position_roundtrip();
+    test_fen_parse_errors();
+    test_search_pv_and_node_limit();
+    test_line_cursor();
+    test_pgn_reader();
+    test_san_roundtrip();
+    test_polyglot_book();
+    test_bitbases();
+    test_repetition_and_fifty_moves();
+    test_compact_move_and_state_stack();
+    test_copy_make_matches_do_move();
+    test_gen_types();
+    test_batch_attacks();
+    test_match_stats_and_selfplay();
+    test_training_records();
+    test_eval_terms();
+    test_syzygy_tables();
     test_legal_moves_nonempty_start();
     std::cout << "All tests passed!\n";
     return 0;
@@ -0,0 +1,196 @@
+// Batch analysis of EPD/FEN files: one search per line, results in input order.
+//   chess_analyze <file|-> [--depth N] [--nodes N] [--threads N] [--out <file|->] [--window N]
+// Output lines are EPD: "<fen>; bm <san>; ce <cp>; acd <depth>; acn <nodes>; pv <san ...>;"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "chess/attacks.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/board_bb.hpp"
+#include "chess/mapped_file.hpp"
+#include "chess/san.hpp"
+#include "chess/search_bb.hpp"
+
+using namespace chess;
+
+struct Job {
+    uint64_t seq;          // output order
+    std::string_view line; // points into the mapped input
+};
+
+// Hands out batches of non-empty, non-comment lines in file order
+class JobSource {
+public:
+    explicit JobSource(std::string_view text) : cur_(text) {}
+
+    bool take(std::vector<Job>& batch, size_t max) {
+        batch.clear();
+        std::lock_guard<std::mutex> lk(mu_);
+        std::string_view line;
+        while (batch.size() < max && cur_.next(line)) {
+            size_t b = line.find_first_not_of(" \t");
+            if (b == std::string_view::npos || line[b] == '#') continue;
+            batch.push_back({seq_++, line.substr(b)});
+        }
+        return !batch.empty();
+    }
+
+private:
+    std::mutex mu_;
+    LineCursor cur_;
+    uint64_t seq_ = 0;
+};
+
+// Bounded reorder buffer: results may arrive out of order, leave in order.
+// A producer more than `window` records ahead of the writer blocks.
+class ReorderBuffer {
+public:
+    ReorderBuffer(std::ostream& os, size_t window) : os_(os), slots_(window) {}
+
+    void put(uint64_t seq, std::string rec) {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&]{ return seq < next_ + slots_.size(); });
+        slots_[seq % slots_.size()] = std::move(rec);
+        bool advanced = false;
+        for (auto* s = &slots_[next_ % slots_.size()]; *s; s = &slots_[next_ % slots_.size()]) {
+            os_ << **s;
+            s->reset();
+            ++next_;
+            advanced = true;
+        }
+        if (advanced) cv_.notify_all();
+    }
+
+private:
+    std::ostream& os_;
+    std::vector<std::optional<std::string>> slots_;
+    uint64_t next_ = 0;
+    std::mutex mu_;
+    std::condition_variable cv_;
+};
+
+// FEN/EPD prefix of a line: 4 fields, plus the clocks if the next two are numbers
+static std::string_view fen_part(std::string_view line) {
+    std::string_view rest = line.substr(0, line.find(';'));
+    size_t end = 0, pos = 0;
+    for (int field = 0; field < 6; ++field) {
+        size_t b = rest.find_first_not_of(" \t", pos);
+        if (b == std::string_view::npos) break;
+        size_t e = std::min(rest.find_first_of(" \t", b), rest.size());
+        if (field >= 4 && rest.substr(b, e - b).find_first_not_of("0123456789") != std::string_view::npos) break;
+        end = e; pos = e;
+    }
+    return line.substr(0, end);
+}
+
+struct Totals {
+    uint64_t positions = 0, errors = 0, nodes = 0;
+    void add(const Totals& o) { positions += o.positions; errors += o.errors; nodes += o.nodes; }
+};
+
+static std::string analyze_line(BoardBB& pos, std::string_view line, const SearchLimits& lim, Totals& t) {
+    std::string_view fen = fen_part(line);
+    std::string out(fen);
+    if (FenError e = pos.parse_fen(fen); e != FenError::Ok) {
+        ++t.errors;
+        out = std::string(line);
+        out += "; error \"";
+        out += to_cstr(e);
+        out += "\";\n";
+        return out;
+    }
+    SearchResult r = search_position(pos, lim);
+    ++t.positions;
+    t.nodes += r.nodes;
+    if (r.best.v == 0) out += "; bm 0000";
+    else               out += "; bm " + to_san(pos, r.best);
+    out += "; ce " + std::to_string(r.score) + "; acd " + std::to_string(r.depth)
+         + "; acn " + std::to_string(r.nodes) + ";";
+    if (!r.pv.empty()) {
+        out += " pv";
+        for (Move m : r.pv) { out += ' ' + to_san(pos, m); pos.do_move(m); }
+        for (size_t i = 0; i < r.pv.size(); ++i) pos.undo_move();
+        out += ';';
+    }
+    out += '\n';
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::string in_path, out_path = "-";
+    SearchLimits lim;
+    lim.depth = -1;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t window = 1024;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if      (a == "--depth")   lim.depth = std::atoi(val().c_str());
+        else if (a == "--nodes")   lim.nodes = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--threads") threads = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--out")     out_path = val();
+        else if (a == "--window")  window = std::max(1, std::atoi(val().c_str()));
+        else if (in_path.empty() && (a == "-" || a[0] != '-')) in_path = a;
+        else { in_path.clear(); break; }
+    }
+    if (in_path.empty()) {
+        std::cerr << "usage: chess_analyze <file|-> [--depth N] [--nodes N] [--threads N]"
+                     " [--out <file|->] [--window N]\n";
+        return 1;
+    }
+    // depth alone: fixed depth; nodes alone: deepen until the budget runs out
+    if (lim.depth < 0) lim.depth = lim.nodes ? MAX_PLY - 1 : 5;
+    lim.depth = std::max(1, lim.depth);
+
+    MappedFile in;
+    if (!in.open(in_path)) { std::cerr << "Cannot open " << in_path << "\n"; return 1; }
+    std::ofstream fout;
+    if (out_path != "-") {
+        fout.open(out_path);
+        if (!fout) { std::cerr << "Cannot write " << out_path << "\n"; return 1; }
+    }
+    std::ostream& os = (out_path == "-") ? std::cout : fout;
+    std::ios::sync_with_stdio(false);
+
+    init_attacks();
+    bitbase::init();
+    JobSource jobs(in.view());
+    ReorderBuffer rb(os, window);
+    std::vector<Totals> totals(threads);
+
+    // each worker owns its board; search state lives in search_position
+    auto worker = [&](int id) {
+        BoardBB pos;
+        std::vector<Job> batch;
+        while (jobs.take(batch, 16))
+            for (const Job& j : batch)
+                rb.put(j.seq, analyze_line(pos, j.line, lim, totals[id]));
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+    os.flush();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    Totals all;
+    for (const auto& t : totals) all.add(t);
+    std::cerr << "analyzed " << all.positions << " positions (" << all.errors << " bad) with "
+              << threads << " threads in " << secs << " s: "
+              << uint64_t(secs > 0 ? all.positions / secs : 0) << " pos/s, "
+              << uint64_t(secs > 0 ? all.nodes / secs : 0) << " nps\n";
+    return all.errors ? 2 : 0;
+}
@@ -0,0 +1,376 @@
+// Builds a Polyglot opening book from PGN games.
+//   chess_bookgen <pgn|-> -o <book.bin> [--keys <Random64 table>] [--max-ply N] [--min-games N]
+//                 [--mem SIZE] [--tmp DIR] [--threads N]
+// Keys come from the library's table (the reference one if the build compiled it in);
+// --keys overrides it with a copy of the Polyglot Random64 table (see load_polyglot_random64).
+// Without the reference keys the book is still written, with a warning: it only matches
+// builds using the same fallback keys.
+// Every ply up to --max-ply becomes a (key, move, score) record, with score 2/1/0 for a
+// win/draw/loss of the side that moved; games without a result are skipped. Records are
+// aggregated in memory-bounded runs (--mem, e.g. 512M; K/M/G suffixes), spilled to
+// unlinked temp files and merged, so memory use does not grow with the number of games.
+// Weights are the summed scores, scaled per position to fit 16 bits.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#define CHESS_POSIX 1
+#else
+#define CHESS_POSIX 0
+#endif
+
+#include "chess/attacks.hpp"
+#include "chess/mapped_file.hpp"
+#include "chess/pgn.hpp"
+#include "chess/polyglot.hpp"
+
+using namespace chess;
+
+constexpr size_t MAX_OPEN_RUNS = 256; // merge fan-in
+
+struct Record {
+    uint64_t key;
+    uint32_t score; // 2 per win, 1 per draw of the side to move
+    uint32_t games;
+    uint16_t move;  // Polyglot encoding
+    bool operator<(const Record& o) const { return key != o.key ? key < o.key : move < o.move; }
+    bool same(const Record& o) const { return key == o.key && move == o.move; }
+};
+
+// Runs hold records field by field (native byte order), without the struct's padding
+constexpr size_t RECORD_SIZE = 18;
+
+static void put_record(unsigned char* p, const Record& r) {
+    std::memcpy(p, &r.key, 8);
+    std::memcpy(p + 8, &r.score, 4);
+    std::memcpy(p + 12, &r.games, 4);
+    std::memcpy(p + 16, &r.move, 2);
+}
+
+static Record get_record(const unsigned char* p) {
+    Record r;
+    std::memcpy(&r.key, p, 8);
+    std::memcpy(&r.score, p + 8, 4);
+    std::memcpy(&r.games, p + 12, 4);
+    std::memcpy(&r.move, p + 16, 2);
+    return r;
+}
+
+// false on a short write
+static bool write_records(std::FILE* f, const Record* recs, size_t n) {
+    constexpr size_t CHUNK = 1024;
+    unsigned char buf[CHUNK * RECORD_SIZE];
+    for (size_t i = 0; i < n; i += CHUNK) {
+        const size_t k = std::min(CHUNK, n - i);
+        for (size_t j = 0; j < k; ++j) put_record(buf + j * RECORD_SIZE, recs[i + j]);
+        if (std::fwrite(buf, RECORD_SIZE, k, f) != k) return false;
+    }
+    return true;
+}
+
+// Anonymous scratch file in dir (removed by the OS when closed)
+static std::FILE* scratch_file(const std::string& dir) {
+#if CHESS_POSIX
+    std::string path = dir + "/chess_bookgen.XXXXXX";
+    int fd = ::mkstemp(path.data());
+    if (fd < 0) return nullptr;
+    ::unlink(path.c_str());
+    return ::fdopen(fd, "w+b");
+#else
+    (void)dir;
+    return std::tmpfile();
+#endif
+}
+
+// Sequential reader over one run
+class RunReader {
+public:
+    RunReader(std::FILE* f, size_t buf_records) : f_(f), buf_(buf_records * RECORD_SIZE) {}
+    bool next(Record& r) {
+        if (pos_ == len_) {
+            len_ = std::fread(buf_.data(), RECORD_SIZE, buf_.size() / RECORD_SIZE, f_);
+            pos_ = 0;
+            if (!len_) return false;
+        }
+        r = get_record(buf_.data() + RECORD_SIZE * pos_++);
+        return true;
+    }
+private:
+    std::FILE* f_;
+    std::vector<unsigned char> buf_;
+    size_t pos_ = 0, len_ = 0;
+};
+
+// k-way merge of sorted runs; emit() sees each (key, move) once, summed across runs
+template <class Emit>
+static void merge_runs(const std::vector<std::FILE*>& runs, size_t mem, Emit emit) {
+    const size_t buf = std::max<size_t>(256, mem / std::max<size_t>(1, runs.size()) / RECORD_SIZE);
+    std::vector<RunReader> readers;
+    for (auto* f : runs) readers.emplace_back(f, buf);
+    using Head = std::pair<Record, size_t>;
+    auto later = [](const Head& a, const Head& b) { return b.first < a.first; };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heap(later);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        Record r;
+        if (readers[i].next(r)) heap.push({r, i});
+    }
+    bool have = false;
+    Record cur{};
+    while (!heap.empty()) {
+        auto [r, i] = heap.top();
+        heap.pop();
+        Record nx;
+        if (readers[i].next(nx)) heap.push({nx, i});
+        if (have && cur.same(r)) { cur.score += r.score; cur.games += r.games; continue; }
+        if (have) emit(cur);
+        cur = r;
+        have = true;
+    }
+    if (have) emit(cur);
+}
+
+// Sorted, aggregated runs on disk; shared by all reader threads
+class RunStore {
+public:
+    explicit RunStore(std::string dir) : dir_(std::move(dir)) {}
+    ~RunStore() { for (auto* f : runs_) std::fclose(f); }
+
+    bool spill(std::vector<Record>& recs) {
+        if (recs.empty()) return true;
+        compact(recs);
+        std::FILE* f = scratch_file(dir_);
+        if (!f) return false;
+        bool ok = write_records(f, recs.data(), recs.size()) && std::fflush(f) == 0;
+        std::rewind(f);
+        std::lock_guard<std::mutex> lk(mu_);
+        runs_.push_back(f);
+        spilled_ += recs.size();
+        recs.clear();
+        return ok;
+    }
+
+    // sort by (key, move) and sum duplicates in place
+    static void compact(std::vector<Record>& recs) {
+        std::sort(recs.begin(), recs.end());
+        size_t w = 0;
+        for (size_t r = 0; r < recs.size(); ++r) {
+            if (w && recs[w-1].same(recs[r])) { recs[w-1].score += recs[r].score; recs[w-1].games += recs[r].games; }
+            else recs[w++] = recs[r];
+        }
+        recs.resize(w);
+    }
+
+    // Merge groups of runs into new runs until at most max_open remain (file handles)
+    bool reduce(size_t max_open, size_t mem) {
+        while (runs_.size() > max_open) {
+            std::vector<std::FILE*> group(runs_.begin(), runs_.begin() + max_open);
+            std::FILE* f = scratch_file(dir_);
+            if (!f) return false;
+            bool ok = true;
+            merge_runs(group, mem, [&](const Record& r) { ok = write_records(f, &r, 1) && ok; });
+            ok = std::fflush(f) == 0 && ok;
+            std::rewind(f);
+            for (auto* g : group) std::fclose(g);
+            runs_.erase(runs_.begin(), runs_.begin() + max_open);
+            runs_.push_back(f);
+            ++passes_;
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    const std::vector<std::FILE*>& runs() const { return runs_; }
+    uint64_t spilled() const { return spilled_; }
+    int passes() const { return passes_; }
+
+private:
+    std::string dir_;
+    std::mutex mu_;
+    std::vector<std::FILE*> runs_;
+    uint64_t spilled_ = 0;
+    int passes_ = 0; // intermediate merges
+};
+
+struct RecordCollector : PgnVisitor {
+    RunStore& store;
+    size_t cap;
+    int max_ply;
+    std::vector<Record> buf;
+    int ply_no = 0;
+    uint64_t skipped = 0;
+    bool failed = false;
+
+    RecordCollector(RunStore& s, size_t cap_records, int max_ply_)
+        : store(s), cap(cap_records), max_ply(max_ply_) { buf.reserve(cap); }
+
+    void begin_game() override { ply_no = 0; }
+    void ply(const BoardBB& pos, Move m, GameResult r) override {
+        if (r == GameResult::Unknown || ply_no++ >= max_ply) return;
+        uint32_t score = r == GameResult::Draw ? 1 : (r == GameResult::WhiteWin) == (pos.side == WHITE) ? 2 : 0;
+        buf.push_back({polyglot_key(pos), score, 1, to_polyglot_move(m)});
+        if (buf.size() == cap && !store.spill(buf)) failed = true;
+    }
+    void end_game(GameResult r, bool) override { if (r == GameResult::Unknown) ++skipped; }
+};
+
+// Writes one position's moves: heaviest first, weights scaled into 16 bits
+class BookWriter {
+public:
+    BookWriter(std::FILE* out, uint32_t min_games) : out_(out), min_games_(min_games) {}
+
+    void add(const Record& r) {
+        if (!group_.empty() && group_.back().key != r.key) flush();
+        if (r.games >= min_games_ && r.score) group_.push_back(r);
+    }
+    void flush() {
+        if (group_.empty()) return;
+        std::stable_sort(group_.begin(), group_.end(), [](const Record& a, const Record& b) { return a.score > b.score; });
+        const uint64_t top = group_.front().score;
+        for (const Record& r : group_) {
+            BookEntry e;
+            e.key = r.key;
+            e.move = r.move;
+            e.weight = uint16_t(top > 0xFFFF ? std::max<uint64_t>(1, r.score * 0xFFFF / top) : r.score);
+            unsigned char b[BOOK_ENTRY_SIZE];
+            write_entry(b, e);
+            if (std::fwrite(b, 1, sizeof b, out_) != sizeof b) failed_ = true;
+            ++entries;
+        }
+        ++positions;
+        group_.clear();
+    }
+    bool failed() const { return failed_; }
+    uint64_t entries = 0, positions = 0;
+
+private:
+    std::FILE* out_;
+    bool failed_ = false;
+    uint32_t min_games_;
+    std::vector<Record> group_;
+};
+
+// "512M", "64K", "2G" or plain bytes
+static size_t parse_size(const std::string& s) {
+    char* end = nullptr;
+    double v = std::strtod(s.c_str(), &end);
+    switch (end && *end ? *end : ' ') {
+        case 'K': case 'k': v *= 1024.0; break;
+        case 'M': case 'm': v *= 1024.0 * 1024; break;
+        case 'G': case 'g': v *= 1024.0 * 1024 * 1024; break;
+        default: break;
+    }
+    return v > 0 ? size_t(v) : 0;
+}
+
+static long peak_rss_kb() {
+#if CHESS_POSIX
+    struct rusage ru{};
+    ::getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+int main(int argc, char** argv) {
+    std::string in_path, out_path, keys_path;
+    const char* tmp_env = std::getenv("TMPDIR");
+    std::string tmp_dir = tmp_env && *tmp_env ? tmp_env : "/tmp";
+    int max_ply = 30, threads = 1;
+    uint32_t min_games = 1;
+    size_t mem = size_t(256) << 20;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if      (a == "-o")          out_path = val();
+        else if (a == "--keys")      keys_path = val();
+        else if (a == "--max-ply")   max_ply = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--min-games") min_games = uint32_t(std::max(1, std::atoi(val().c_str())));
+        else if (a == "--mem")       mem = parse_size(val());
+        else if (a == "--tmp")       tmp_dir = val();
+        else if (a == "--threads")   threads = std::max(1, std::atoi(val().c_str()));
+        else if (in_path.empty() && (a == "-" || a[0] != '-')) in_path = a;
+        else { in_path.clear(); break; }
+    }
+    if (in_path.empty() || out_path.empty() || !mem) {
+        std::cerr << "usage: chess_bookgen <pgn|-> -o <book.bin> [--keys <Random64 table>] [--max-ply N]"
+                     " [--min-games N] [--mem SIZE] [--tmp DIR] [--threads N]\n";
+        return 1;
+    }
+
+    MappedFile in;
+    if (!in.open(in_path)) { std::cerr << "Cannot open " << in_path << "\n"; return 1; }
+    init_attacks();
+    MappedFile keys;
+    if (!keys_path.empty() && (!keys.open(keys_path) || !load_polyglot_random64(keys.view()))) {
+        std::cerr << "No reference Random64 table in " << keys_path << "\n";
+        return 1;
+    }
+    if (!polyglot_keys_standard())
+        std::cerr << "warning: not the reference Random64 table (--keys <file>); the book only matches this build's keys\n";
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    // phase 1: replay games into sorted runs; the budget is split between the readers
+    RunStore store(tmp_dir);
+    const size_t cap = std::max<size_t>(1, mem / threads / sizeof(Record));
+    std::vector<std::unique_ptr<RecordCollector>> cols;
+    std::vector<PgnVisitor*> visitors;
+    for (int t = 0; t < threads; ++t) {
+        cols.push_back(std::make_unique<RecordCollector>(store, cap, max_ply));
+        visitors.push_back(cols.back().get());
+    }
+    PgnStats st;
+    if (threads == 1) {
+        PgnReader reader(in.view());
+        while (reader.next_game(*visitors[0])) {}
+        st = reader.stats();
+    } else {
+        st = read_pgn_parallel(in.view(), visitors);
+    }
+    uint64_t skipped = 0;
+    bool ok = true;
+    for (auto& c : cols) {
+        ok = store.spill(c->buf) && ok && !c->failed;
+        skipped += c->skipped;
+        std::vector<Record>().swap(c->buf);
+    }
+    if (!ok) { std::cerr << "Cannot write temporary runs in " << tmp_dir << "\n"; return 1; }
+    auto t1 = std::chrono::steady_clock::now();
+
+    // phase 2: k-way merge of the runs, summing equal (key, move) across runs
+    const size_t runs_spilled = store.runs().size();
+    if (!store.reduce(MAX_OPEN_RUNS, mem)) { std::cerr << "Cannot write temporary runs in " << tmp_dir << "\n"; return 1; }
+    std::FILE* out = std::fopen(out_path.c_str(), "wb");
+    if (!out) { std::cerr << "Cannot write " << out_path << "\n"; return 1; }
+    BookWriter writer(out, min_games);
+    merge_runs(store.runs(), mem, [&](const Record& r) { writer.add(r); });
+    writer.flush();
+    const bool write_ok = !writer.failed() && std::fclose(out) == 0;
+    if (!write_ok) { std::cerr << "Cannot write " << out_path << "\n"; return 1; }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double read_secs = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "games " << st.games << " (" << skipped << " without result, " << st.errors << " bad) plies "
+              << st.plies << "  runs " << runs_spilled << " (" << store.passes() << " extra merges) records " << store.spilled()
+              << "  positions " << writer.positions << " entries " << writer.entries << "\n";
+    std::cerr << "time " << secs << " s (replay+sort " << read_secs << " s, merge " << secs - read_secs
+              << " s), peak memory " << peak_rss_kb() / 1024 << " MB\n";
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Training data from self-play: labelled positions in the TrainingRecord format.
+//   chess_datagen --out <file> [--games N] [--threads N] [--nodes N] [--random-plies N]
+//                 [--openings <epd>] [--seed N] [--max-score CP] [--max-plies N] [--flush N]
+// Each game starts from an opening (the start position by default) followed by
+// --random-plies uniformly random legal moves (chess::random_opening; finished openings
+// are dropped), then both sides search --nodes nodes per move. Quiet positions (see chess::trainable) are kept with the search score and, once
+// the game is over, its result. Threads buffer whole games and append --flush records
+// at a time to the output file.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess/attacks.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/mapped_file.hpp"
+#include "chess/selfplay.hpp"
+#include "chess/training.hpp"
+
+using namespace chess;
+
+// The output file, shared by all threads; each write is one flushed chunk
+class RecordSink {
+public:
+    explicit RecordSink(std::FILE* f) : f_(f) {}
+
+    void write(const std::vector<TrainingRecord>& recs) {
+        if (recs.empty()) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (std::fwrite(recs.data(), sizeof(TrainingRecord), recs.size(), f_) != recs.size() || std::fflush(f_))
+            failed_ = true;
+        written_ += recs.size();
+    }
+    uint64_t written() const { return written_; }
+    bool failed() const { return failed_; }
+
+private:
+    std::FILE* f_;
+    std::mutex mu_;
+    uint64_t written_ = 0;
+    bool failed_ = false;
+};
+
+// Per-thread buffer in front of the sink
+class RecordWriter {
+public:
+    RecordWriter(RecordSink& sink, size_t flush_every) : sink_(sink), flush_every_(flush_every) {
+        buf_.reserve(flush_every + 512);
+    }
+    ~RecordWriter() { flush(); }
+
+    void add(const std::vector<TrainingRecord>& game) {
+        buf_.insert(buf_.end(), game.begin(), game.end());
+        if (buf_.size() >= flush_every_) flush();
+    }
+    void flush() { sink_.write(buf_); buf_.clear(); }
+
+private:
+    RecordSink& sink_;
+    size_t flush_every_;
+    std::vector<TrainingRecord> buf_;
+};
+
+int main(int argc, char** argv) {
+    std::string out_path, openings_path;
+    uint64_t games = 1000, seed = 1;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int random_moves = 8, max_score = 2000;
+    size_t flush_every = 1 << 14;
+    SearchLimits lim;
+    lim.depth = MAX_PLY - 1;
+    lim.nodes = 2000;
+    Adjudication adj;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if      (a == "--out")          out_path = val();
+        else if (a == "--games")        games = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--threads")      threads = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--nodes")        lim.nodes = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--random-plies") random_moves = std::max(0, std::atoi(val().c_str()));
+        else if (a == "--openings")     openings_path = val();
+        else if (a == "--seed")         seed = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--max-score")    max_score = std::atoi(val().c_str());
+        else if (a == "--max-plies")    adj.max_plies = std::atoi(val().c_str());
+        else if (a == "--flush")        flush_every = std::max(1, std::atoi(val().c_str()));
+        else ok = false;
+    }
+    if (!ok || out_path.empty() || !games || !lim.nodes) {
+        std::cerr << "usage: chess_datagen --out <file> [--games N] [--threads N] [--nodes N] [--random-plies N]\n"
+                     "                     [--openings <epd>] [--seed N] [--max-score CP] [--max-plies N] [--flush N]\n";
+        return 1;
+    }
+
+    init_attacks();
+    bitbase::init();
+    std::vector<std::string> openings;
+    if (!openings_path.empty()) {
+        MappedFile in;
+        if (!in.open(openings_path)) { std::cerr << "Cannot open " << openings_path << "\n"; return 1; }
+        openings = load_openings(in.view());
+        if (openings.empty()) { std::cerr << "No usable positions in " << openings_path << "\n"; return 1; }
+    } else {
+        openings.push_back("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    }
+    std::FILE* f = std::fopen(out_path.c_str(), "wb");
+    if (!f) { std::cerr << "Cannot write " << out_path << "\n"; return 1; }
+
+    RecordSink sink(f);
+    std::atomic<uint64_t> next{0}, plies{0}, no_start{0};
+    const SearchLimits limits[2] = { lim, lim };
+
+    auto worker = [&](int id) {
+        std::mt19937_64 rng(seed * 0x9E3779B97F4A7C15ull + uint64_t(id));
+        RecordWriter writer(sink, flush_every);
+        BoardBB pos;
+        std::vector<TrainingRecord> game;
+        while (next++ < games) {
+            if (!random_opening(pos, openings[rng() % openings.size()], random_moves, rng)) { ++no_start; continue; }
+            game.clear();
+            PlayedGame res = play_game(pos, limits, adj, [&](const BoardBB& p, const SearchResult& r) {
+                TrainingRecord rec;
+                if (!trainable(p, r, max_score) || !p.encode(rec.pos)) return;
+                rec.score = int16_t(p.side == WHITE ? r.score : -r.score);
+                game.push_back(rec);
+            });
+            for (TrainingRecord& rec : game) rec.result = result_code(res.result);
+            writer.add(game);
+            plies += uint64_t(res.plies);
+        }
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const bool failed = sink.failed() || std::fclose(f) != 0;
+
+    if (no_start) std::cerr << no_start << " games skipped: every random line from their opening ended the game\n";
+    std::cout << "games " << games - no_start << " plies " << plies << " positions " << sink.written()
+              << " (" << sizeof(TrainingRecord) << " bytes each) -> " << out_path << "\n";
+    std::cerr << "time " << secs << " s, " << uint64_t(secs > 0 ? sink.written() / secs * 3600 : 0)
+              << " positions/hour (" << threads << " threads, " << lim.nodes << " nodes/move)\n";
+    if (failed) { std::cerr << "Write error on " << out_path << "\n"; return 1; }
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Engine-vs-engine match between two search configurations of the bitboard engine.
+//   chess_match [--openings <epd>] [--random-plies N] [--seed N] [--games N] [--threads N]
+//               [--engine1 SPEC] [--engine2 SPEC] [--sprt ELO0,ELO1] [--alpha A] [--beta B]
+//               [--max-plies N] [--draw FROMPLY,PLIES,CP] [--resign PLIES,CP] [--report N]
+// SPEC is "nodes=N,depth=N,movetime=MS,weights=FILE" (any subset; default depth=4).
+// weights= gives that engine its own eval_bb weights, in the chess_tune output format.
+// Game pair p starts from opening p (cycling through the file, the start position by
+// default) plus --random-plies random moves drawn from --seed and p (default 0 with
+// --openings, 8 without), and is played twice with colours swapped. Games run in
+// parallel, one per thread. Results are from engine1's view. With --sprt the match
+// stops once the LLR over completed pairs leaves its bounds.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "chess/attacks.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/eval_terms.hpp"
+#include "chess/mapped_file.hpp"
+#include "chess/selfplay.hpp"
+#include "chess/sprt.hpp"
+
+using namespace chess;
+
+// "nodes=20000,depth=8,weights=tuned.hpp" -> limits (weights loaded into ew); false on
+// an unknown key or unusable weights file
+static bool parse_engine(const std::string& spec, SearchLimits& lim, EvalWeights& ew) {
+    lim = SearchLimits{};
+    lim.depth = -1;
+    std::istringstream ss(spec);
+    std::string kv;
+    while (std::getline(ss, kv, ',')) {
+        if (kv.empty()) continue;
+        size_t eq = kv.find('=');
+        if (eq == std::string::npos) return false;
+        std::string k = kv.substr(0, eq);
+        uint64_t v = std::strtoull(kv.c_str() + eq + 1, nullptr, 10);
+        if      (k == "nodes")    lim.nodes = v;
+        else if (k == "depth")    lim.depth = int(v);
+        else if (k == "movetime") lim.movetime_ms = v;
+        else if (k == "weights") {
+            MappedFile f;
+            if (!f.open(kv.substr(eq + 1)) || !parse_eval_weights(f.view(), ew)) {
+                std::cerr << "No evaluation weights in " << kv.substr(eq + 1) << "\n";
+                return false;
+            }
+            lim.weights = &ew;
+        }
+        else return false;
+    }
+    if (lim.depth < 0) lim.depth = (lim.nodes || lim.movetime_ms) ? MAX_PLY - 1 : 4;
+    lim.depth = std::clamp(lim.depth, 1, MAX_PLY - 1);
+    return true;
+}
+
+// n comma-separated numbers; false if the count differs
+static bool parse_list(const std::string& s, std::vector<double>& out, size_t n) {
+    out.clear();
+    std::istringstream ss(s);
+    std::string tok;
+    while (std::getline(ss, tok, ',')) out.push_back(std::atof(tok.c_str()));
+    return out.size() == n;
+}
+
+struct Tally {
+    std::mutex mu;
+    MatchScore score;
+    std::unordered_map<uint64_t, int> first_half; // pair -> engine1's half-points in its first finished game
+    uint64_t ends[GAME_END_COUNT]{};
+    uint64_t plies = 0;
+};
+
+static void print_status(std::ostream& os, const MatchScore& s, bool sprt, double elo0, double elo1, SprtBounds bounds) {
+    char buf[160];
+    std::snprintf(buf, sizeof buf, "games %llu: +%llu =%llu -%llu  score %.3f  elo %.1f +/- %.1f",
+                  (unsigned long long)s.games(), (unsigned long long)s.wins, (unsigned long long)s.draws,
+                  (unsigned long long)s.losses, s.score(), s.elo(), s.elo_error95());
+    os << buf;
+    if (sprt) {
+        std::snprintf(buf, sizeof buf, "  pairs %llu/%llu/%llu/%llu/%llu  llr %.2f [%.2f, %.2f]",
+                      (unsigned long long)s.pairs[0], (unsigned long long)s.pairs[1], (unsigned long long)s.pairs[2],
+                      (unsigned long long)s.pairs[3], (unsigned long long)s.pairs[4], s.llr(elo0, elo1), bounds.lower, bounds.upper);
+        os << buf;
+    }
+    os << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::string openings_path, spec1 = "depth=4", spec2 = "depth=4";
+    uint64_t games = 100, report = 0, seed = 1;
+    int random_moves = -1; // default: 0 with --openings, 8 without
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+    Adjudication adj;
+    bool ok = true;
+    std::vector<double> v;
+    for (int i = 1; i < argc && ok; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if      (a == "--openings")  openings_path = val();
+        else if (a == "--random-plies") random_moves = std::max(0, std::atoi(val().c_str()));
+        else if (a == "--seed")      seed = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--games")     games = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--threads")   threads = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--engine1")   spec1 = val();
+        else if (a == "--engine2")   spec2 = val();
+        else if (a == "--sprt")      { sprt = ok = parse_list(val(), v, 2); if (ok) { elo0 = v[0]; elo1 = v[1]; } }
+        else if (a == "--alpha")     alpha = std::atof(val().c_str());
+        else if (a == "--beta")      beta = std::atof(val().c_str());
+        else if (a == "--max-plies") adj.max_plies = std::atoi(val().c_str());
+        else if (a == "--draw")      { ok = parse_list(val(), v, 3); if (ok) { adj.draw_from_ply = int(v[0]); adj.draw_plies = int(v[1]); adj.draw_cp = int(v[2]); } }
+        else if (a == "--resign")    { ok = parse_list(val(), v, 2); if (ok) { adj.resign_plies = int(v[0]); adj.resign_cp = int(v[1]); } }
+        else if (a == "--report")    report = std::strtoull(val().c_str(), nullptr, 10);
+        else ok = false;
+    }
+    SearchLimits lim1, lim2;
+    EvalWeights ew1, ew2;
+    if (!ok || !games || !parse_engine(spec1, lim1, ew1) || !parse_engine(spec2, lim2, ew2) || alpha <= 0 || beta <= 0) {
+        std::cerr << "usage: chess_match [--openings <epd>] [--random-plies N] [--seed N] [--games N] [--threads N]\n"
+                     "                   [--engine1 SPEC] [--engine2 SPEC] [--sprt ELO0,ELO1] [--alpha A] [--beta B]\n"
+                     "                   [--max-plies N] [--draw FROMPLY,PLIES,CP] [--resign PLIES,CP] [--report N]\n"
+                     "  SPEC: nodes=N,depth=N,movetime=MS,weights=FILE\n";
+        return 1;
+    }
+
+    init_attacks();
+    bitbase::init();
+    std::vector<std::string> openings;
+    if (!openings_path.empty()) {
+        MappedFile in;
+        if (!in.open(openings_path)) { std::cerr << "Cannot open " << openings_path << "\n"; return 1; }
+        openings = load_openings(in.view());
+        if (openings.empty()) { std::cerr << "No usable positions in " << openings_path << "\n"; return 1; }
+    } else {
+        openings.push_back("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    }
+    if (random_moves < 0) random_moves = openings_path.empty() ? 8 : 0;
+    // without random plies a replayed opening repeats its games move for move
+    if (!random_moves && games > 2 * openings.size())
+        std::cerr << "warning: " << games << " games over " << openings.size() << " openings without --random-plies;"
+                     " replayed openings are not independent games\n";
+    if (!report) report = std::max<uint64_t>(1, games / 10);
+
+    const SprtBounds bounds = sprt_bounds(alpha, beta);
+    Tally tally;
+    std::atomic<uint64_t> next{0}, no_start{0};
+    std::atomic<bool> stop{false};
+
+    // game g: pair g/2 (same start for both games), engine1 White on even g
+    auto worker = [&] {
+        BoardBB pos;
+        for (uint64_t g; !stop && (g = next++) < games; ) {
+            const uint64_t pair = g / 2;
+            std::mt19937_64 rng(seed * 0x9E3779B97F4A7C15ull + pair);
+            if (!random_opening(pos, openings[pair % openings.size()], random_moves, rng)) { ++no_start; continue; }
+            const bool e1_white = g % 2 == 0;
+            const SearchLimits limits[2] = { e1_white ? lim1 : lim2, e1_white ? lim2 : lim1 };
+            PlayedGame res = play_game(pos, limits, adj);
+
+            std::lock_guard<std::mutex> lk(tally.mu);
+            if (stop) return; // past an SPRT decision: do not count
+            const bool e1_won = (res.result == GameResult::WhiteWin) == e1_white;
+            const int half = res.result == GameResult::Draw ? 1 : e1_won ? 2 : 0;
+            if (half == 1)      ++tally.score.draws;
+            else if (half == 2) ++tally.score.wins;
+            else                ++tally.score.losses;
+            ++tally.ends[int(res.end)];
+            tally.plies += res.plies;
+            bool pair_done = false;
+            if (auto it = tally.first_half.find(pair); it == tally.first_half.end()) tally.first_half.emplace(pair, half);
+            else { ++tally.score.pairs[it->second + half]; tally.first_half.erase(it); pair_done = true; }
+            if (tally.score.games() % report == 0) print_status(std::cerr, tally.score, sprt, elo0, elo1, bounds);
+            if (sprt && pair_done) {
+                double llr = tally.score.llr(elo0, elo1);
+                if (llr <= bounds.lower || llr >= bounds.upper) stop = true;
+            }
+        }
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const MatchScore& s = tally.score;
+    std::cout << "engine1 " << spec1 << " vs engine2 " << spec2 << ", " << openings.size() << " openings, "
+              << random_moves << " random plies\n";
+    if (no_start) std::cerr << no_start << " games skipped: every random line from their opening ended the game\n";
+    print_status(std::cout, s, sprt, elo0, elo1, bounds);
+    std::cout << "ends:";
+    for (int e = 0; e < GAME_END_COUNT; ++e)
+        if (tally.ends[e]) std::cout << ' ' << to_cstr(GameEnd(e)) << ' ' << tally.ends[e] << ';';
+    std::cout << "\n";
+    if (sprt) {
+        double llr = s.llr(elo0, elo1);
+        std::cout << "sprt elo0 " << elo0 << " elo1 " << elo1 << ": "
+                  << (llr >= bounds.upper ? "H1 accepted" : llr <= bounds.lower ? "H0 accepted" : "inconclusive") << "\n";
+    }
+    std::cerr << "time " << secs << " s, " << uint64_t(secs > 0 ? s.games() / secs * 3600 : 0) << " games/hour, "
+              << uint64_t(secs > 0 ? tally.plies / secs : 0) << " plies/s (" << threads << " threads)\n";
+    return 0;
+}
@@ -0,0 +1,380 @@
+// Micro-benchmarks for the core primitives (Google Benchmark).
+// JSON export: chess_bench --benchmark_format=json --benchmark_out=bench.json
+#include <benchmark/benchmark.h>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "chess/attacks.hpp"
+#include "chess/board_bb.hpp"
+#include "chess/san.hpp"
+#include "chess/search_bb.hpp"
+#include "chess/game.hpp"
+
+using namespace chess;
+
+static const char* STARTPOS = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static const char* KIWIPETE = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+static const char* FENS[] = { STARTPOS, KIWIPETE };
+
+static BoardBB load(int i) {
+    BoardBB p; p.set_fen(FENS[i]); return p;
+}
+
+// ---- attack lookups (all 64 squares per iteration) ----
+static void BM_AttacksKnight(benchmark::State& st) {
+    for (auto _ : st) {
+        Bitboard acc = 0;
+        for (int s = 0; s < 64; ++s) acc ^= attacks_knight(Square(s));
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * 64);
+}
+BENCHMARK(BM_AttacksKnight);
+
+static void BM_AttacksKing(benchmark::State& st) {
+    for (auto _ : st) {
+        Bitboard acc = 0;
+        for (int s = 0; s < 64; ++s) acc ^= attacks_king(Square(s));
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * 64);
+}
+BENCHMARK(BM_AttacksKing);
+
+static void BM_AttacksPawn(benchmark::State& st) {
+    for (auto _ : st) {
+        Bitboard acc = 0;
+        for (int s = 0; s < 64; ++s) acc ^= attacks_pawn(WHITE, Square(s)) ^ attacks_pawn(BLACK, Square(s));
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * 128);
+}
+BENCHMARK(BM_AttacksPawn);
+
+static void BM_AttacksBishop(benchmark::State& st) {
+    Bitboard occ = load(1).occ_all();
+    for (auto _ : st) {
+        Bitboard acc = 0;
+        for (int s = 0; s < 64; ++s) acc ^= attacks_bishop(Square(s), occ);
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * 64);
+}
+BENCHMARK(BM_AttacksBishop);
+
+static void BM_AttacksRook(benchmark::State& st) {
+    Bitboard occ = load(1).occ_all();
+    for (auto _ : st) {
+        Bitboard acc = 0;
+        for (int s = 0; s < 64; ++s) acc ^= attacks_rook(Square(s), occ);
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * 64);
+}
+BENCHMARK(BM_AttacksRook);
+
+static void BM_AttacksQueen(benchmark::State& st) {
+    Bitboard occ = load(1).occ_all();
+    for (auto _ : st) {
+        Bitboard acc = 0;
+        for (int s = 0; s < 64; ++s) acc ^= attacks_queen(Square(s), occ);
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * 64);
+}
+BENCHMARK(BM_AttacksQueen);
+
+// ---- move generation (arg: 0 = startpos, 1 = kiwipete) ----
+static void BM_GenerateMoves(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    std::vector<Move> ml;
+    for (auto _ : st) {
+        p.generate_moves(ml);
+        benchmark::DoNotOptimize(ml.data());
+    }
+    st.SetItemsProcessed(st.iterations() * ml.size());
+}
+BENCHMARK(BM_GenerateMoves)->Arg(0)->Arg(1);
+
+static void BM_GenerateLegalMoves(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    std::vector<Move> ml;
+    for (auto _ : st) {
+        p.generate_legal_moves(ml);
+        benchmark::DoNotOptimize(ml.data());
+    }
+    st.SetItemsProcessed(st.iterations() * ml.size());
+}
+BENCHMARK(BM_GenerateLegalMoves)->Arg(0)->Arg(1);
+
+// ---- make/unmake: every legal move of the position once per iteration ----
+static void BM_DoUndoMove(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    std::vector<Move> ml;
+    p.generate_legal_moves(ml);
+    for (auto _ : st) {
+        for (auto m : ml) { p.do_move(m); p.undo_move(); }
+        benchmark::DoNotOptimize(p.bb.occ_all);
+    }
+    st.SetItemsProcessed(st.iterations() * ml.size());
+}
+BENCHMARK(BM_DoUndoMove)->Arg(0)->Arg(1);
+
+static void BM_SquareAttacked(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    for (auto _ : st) {
+        int n = 0;
+        for (int s = 0; s < 64; ++s) n += p.square_attacked(Square(s), BLACK);
+        benchmark::DoNotOptimize(n);
+    }
+    st.SetItemsProcessed(st.iterations() * 64);
+}
+BENCHMARK(BM_SquareAttacked)->Arg(0)->Arg(1);
+
+static void BM_EvalBB(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    for (auto _ : st) benchmark::DoNotOptimize(eval_bb(p));
+    st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_EvalBB)->Arg(0)->Arg(1);
+
+// ---- whole-position attack summaries, 256 positions per iteration ----
+static std::vector<Bitboards> batch_input() {
+    std::vector<Bitboards> in;
+    for (int i = 0; i < 256; ++i) in.push_back(load(i % 2).bb);
+    return in;
+}
+
+// per-piece table/ray lookups: what batch_attacks replaces
+static void BM_AttacksPerPosition(benchmark::State& st) {
+    auto in = batch_input();
+    std::vector<AttackInfo> out(in.size());
+    for (auto _ : st) {
+        for (size_t i = 0; i < in.size(); ++i) {
+            const Bitboards& b = in[i];
+            for (int c = 0; c < 2; ++c) {
+                Bitboard att = 0; int mob = 0;
+                auto add = [&](Bitboard a) { att |= a; mob += popcount(a & ~b.occ[c]); };
+                for (Bitboard p = b.pcs[c][KNIGHT]; p; pop_lsb(p)) add(attacks_knight(Square(lsb(p))));
+                for (Bitboard p = b.pcs[c][BISHOP]; p; pop_lsb(p)) add(attacks_bishop(Square(lsb(p)), b.occ_all));
+                for (Bitboard p = b.pcs[c][ROOK]; p; pop_lsb(p))   add(attacks_rook(Square(lsb(p)), b.occ_all));
+                for (Bitboard p = b.pcs[c][QUEEN]; p; pop_lsb(p))  add(attacks_queen(Square(lsb(p)), b.occ_all));
+                for (Bitboard p = b.pcs[c][PAWN]; p; pop_lsb(p))   att |= attacks_pawn(c ? BLACK : WHITE, Square(lsb(p)));
+                att |= attacks_king(Square(lsb(b.pcs[c][KING])));
+                out[i].attacks[c] = att; out[i].mobility[c] = uint16_t(mob);
+            }
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    st.SetItemsProcessed(st.iterations() * in.size());
+}
+BENCHMARK(BM_AttacksPerPosition);
+
+static void BM_BatchAttacks(benchmark::State& st) {
+    auto in = batch_input();
+    std::vector<AttackInfo> out(in.size());
+    for (auto _ : st) {
+        if (st.range(0)) batch_attacks(in.data(), out.data(), in.size());
+        else             batch_attacks_scalar(in.data(), out.data(), in.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    st.SetItemsProcessed(st.iterations() * in.size());
+    st.SetLabel(st.range(0) && batch_attacks_simd() ? "avx2" : "scalar");
+}
+BENCHMARK(BM_BatchAttacks)->Arg(0)->Arg(1);
+
+// ---- FEN IO ----
+// Pre-string_view FEN IO, kept verbatim (minus private helpers) as the baseline for BM_*Fen
+static bool legacy_set_fen(BoardBB& b, const std::string& fen) {
+    b.clear();
+    std::string p, stm, cr, ep, h, f;
+    std::istringstream ss(fen);
+    if(!(ss>>p>>stm>>cr>>ep>>h>>f)) return false;
+    int r=7, c=0;
+    for(char ch: p){
+        if (ch=='/'){ --r; c=0; continue; }
+        if (std::isdigit(static_cast<unsigned char>(ch))){ c += ch-'0'; continue; }
+        int col = std::isupper(static_cast<unsigned char>(ch)) ? 0 : 1;
+        char pc = std::tolower(static_cast<unsigned char>(ch));
+        PieceType pt=NO_PIECE;
+        switch (pc){
+            case 'p': pt=PAWN; break; case 'n': pt=KNIGHT; break;
+            case 'b': pt=BISHOP; break; case 'r': pt=ROOK; break;
+            case 'q': pt=QUEEN; break; case 'k': pt=KING; break;
+            default: return false;
+        }
+        Bitboard m = bb(Square(r*8 + c));
+        b.bb.pcs[col][pt] |= m; b.bb.occ[col] |= m; b.bb.occ_all |= m;
+        ++c;
+    }
+    b.side = (stm=="w")?WHITE:BLACK;
+    b.castling = 0;
+    for(char ch: cr){
+        if (ch=='K') b.castling |= CR_WK;
+        else if (ch=='Q') b.castling |= CR_WQ;
+        else if (ch=='k') b.castling |= CR_BK;
+        else if (ch=='q') b.castling |= CR_BQ;
+    }
+    b.ep_sq = -1;
+    if (ep!="-"){
+        int file = ep[0]-'a', rank = ep[1]-'1';
+        if (file>=0 && file<8 && rank>=0 && rank<8) b.ep_sq = rank*8 + file;
+    }
+    b.halfmove = h.empty()?0:std::stoi(h);
+    b.fullmove = f.empty()?1:std::stoi(f);
+    return true;
+}
+
+static std::string legacy_to_fen(const BoardBB& b) {
+    auto piece_at = [&](int r, int c)->char{
+        for(int col=0; col<2; ++col)
+            for(int pt=0; pt<6; ++pt)
+                if (b.bb.pcs[col][pt] & bb(Square(r*8+c))){
+                    const char map[6] = {'p','n','b','r','q','k'};
+                    return (col==0) ? char(std::toupper(map[pt])) : map[pt];
+                }
+        return '1';
+    };
+    std::string out;
+    for(int r=7;r>=0;--r){
+        int empties=0;
+        for(int c=0;c<8;++c){
+            char ch = piece_at(r,c);
+            if (ch=='1'){ ++empties; }
+            else{
+                if (empties){ out.push_back(char('0'+empties)); empties=0; }
+                out.push_back(ch);
+            }
+        }
+        if (empties) out.push_back(char('0'+empties));
+        if (r) out.push_back('/');
+    }
+    out += b.side==WHITE ? " w " : " b ";
+    if (!b.castling) out += "-";
+    else{
+        if (b.castling & CR_WK) out+='K';
+        if (b.castling & CR_WQ) out+='Q';
+        if (b.castling & CR_BK) out+='k';
+        if (b.castling & CR_BQ) out+='q';
+    }
+    out += ' ';
+    if (b.ep_sq<0) out += "-";
+    else{ out.push_back(char('a'+b.ep_sq%8)); out.push_back(char('1'+b.ep_sq/8)); }
+    out += ' ' + std::to_string(b.halfmove) + ' ' + std::to_string(b.fullmove);
+    return out;
+}
+
+static void BM_LegacySetFen(benchmark::State& st) {
+    BoardBB p;
+    const std::string fen = FENS[st.range(0)];
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(legacy_set_fen(p, fen));
+        benchmark::ClobberMemory();
+    }
+    st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_LegacySetFen)->Arg(0)->Arg(1);
+
+static void BM_ParseFen(benchmark::State& st) {
+    BoardBB p;
+    const std::string_view fen = FENS[st.range(0)];
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(p.parse_fen(fen));
+        benchmark::ClobberMemory();
+    }
+    st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_ParseFen)->Arg(0)->Arg(1);
+
+static void BM_LegacyToFen(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    for (auto _ : st) benchmark::DoNotOptimize(legacy_to_fen(p));
+    st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_LegacyToFen)->Arg(0)->Arg(1);
+
+static void BM_WriteFen(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    char buf[FEN_BUF_SIZE];
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(p.write_fen(buf, sizeof buf));
+        benchmark::ClobberMemory();
+    }
+    st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_WriteFen)->Arg(0)->Arg(1);
+
+// ---- SAN: every legal move of the position per iteration ----
+static void BM_ToSan(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    std::vector<Move> ml;
+    p.generate_legal_moves(ml);
+    for (auto _ : st)
+        for (Move m : ml) benchmark::DoNotOptimize(to_san(p, m));
+    st.SetItemsProcessed(st.iterations() * ml.size());
+}
+BENCHMARK(BM_ToSan)->Arg(0)->Arg(1);
+
+static void BM_ParseSan(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    std::vector<Move> ml;
+    p.generate_legal_moves(ml);
+    std::vector<std::string> sans;
+    for (Move m : ml) sans.push_back(to_san(p, m));
+    for (auto _ : st)
+        for (const auto& s : sans) benchmark::DoNotOptimize(parse_san(p, s));
+    st.SetItemsProcessed(st.iterations() * sans.size());
+}
+BENCHMARK(BM_ParseSan)->Arg(0)->Arg(1);
+
+// ---- 32-byte packed positions, the bulk alternative to FEN IO ----
+static void BM_PackedEncode(benchmark::State& st) {
+    BoardBB p = load(st.range(0));
+    PackedPos pp;
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(p.encode(pp));
+        benchmark::ClobberMemory();
+    }
+    st.SetItemsProcessed(st.iterations());
+    st.SetBytesProcessed(st.iterations() * sizeof(PackedPos));
+}
+BENCHMARK(BM_PackedEncode)->Arg(0)->Arg(1);
+
+static void BM_PackedDecode(benchmark::State& st) {
+    PackedPos pp;
+    load(st.range(0)).encode(pp);
+    BoardBB p;
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(p.decode(pp));
+        benchmark::ClobberMemory();
+    }
+    st.SetItemsProcessed(st.iterations());
+    st.SetBytesProcessed(st.iterations() * sizeof(PackedPos));
+}
+BENCHMARK(BM_PackedDecode)->Arg(0)->Arg(1);
+
+// ---- OOP engine, for comparison with BM_GenerateLegalMoves ----
+static void BM_GameLegalMoves(benchmark::State& st) {
+    Game g; std::string err;
+    g.load_fen(FENS[st.range(0)], err);
+    size_t n = 0;
+    for (auto _ : st) {
+        MoveList ml;
+        g.legal_moves(ml);
+        n = ml.size();
+        benchmark::DoNotOptimize(ml.moves);
+    }
+    st.SetItemsProcessed(st.iterations() * n);
+}
+BENCHMARK(BM_GameLegalMoves)->Arg(0)->Arg(1);
+
+int main(int argc, char** argv) {
+    init_attacks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
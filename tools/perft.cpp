@@ -1,48 +1,36 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "chess/game.hpp"
 #include "chess/board.hpp"
-#include "chess/piece.hpp"  // for Pawn dynamic_cast
+#include "chess/piece.hpp"
+#include "chess/board_bb.hpp"
+#include "chess/attacks.hpp"
 
 using namespace chess; // optional
 
-// Parse "rc rc" (e.g., "61 71") into coordinates
-static inline bool parse_rc_move(const std::string& m, int& r0,int& c0,int& r1,int& c1){
-    if (m.size() < 5) return false;
-    r0 = m[0]-'0'; c0 = m[1]-'0';
-    r1 = m[3]-'0'; c1 = m[4]-'0';
-    return (r0>=0 && r0<8 && c0>=0 && c0<8 && r1>=0 && r1<8 && c1>=0 && c1<8);
-}
-
-// Perft that expands promotions into 4 branches (Q,R,B,N)
+// Promotions come out of legal_moves() as four separate moves (Q,R,B,N)
 static uint64_t perft(Game& g, int depth) {
     if (depth == 0) return 1ULL;
 
     uint64_t nodes = 0;
-    auto moves = g.legal_moves();
-
-    for (const auto& m : moves) {
-        int r0,c0,r1,c1;
-        bool promo4 = false;
-        if (parse_rc_move(m, r0,c0,r1,c1)) {
-            const Piece* p0 = g.get_board().board[r0][c0].get();
-            if (p0 && dynamic_cast<const Pawn*>(p0) != nullptr && (r1 == 0 || r1 == 7)) {
-                promo4 = true;
-            }
-        }
-
-        Game child = g;
-        std::string err;
-        if (!child.move(m, err)) continue;
+    MoveList moves;
+    g.legal_moves(moves);
 
-        uint64_t sub = perft(child, depth - 1);
-        nodes += promo4 ? (sub * 4ULL) : sub;
+    for (Move m : moves) {
+        Game::Undo u;
+        g.make_move(m, u);
+        nodes += perft(g, depth - 1);
+        g.unmake_move(u);
     }
     return nodes;
 }
@@ -62,7 +50,191 @@ static void run(const std::string& name, Game& g, int d, uint64_t expected) {
     }
 }
 
-int main() {
+// ---- EPD suite mode (bitboard engine) ----
+// Usage: chess_perft --epd <file> [--depth N] [--threads N] [--json <out>] [--csv <out>] [--min-nps N]
+// Each line: "<fen> ;D1 20 ;D2 400 ..." (4-field FEN, clocks optional).
+
+struct EpdEntry {
+    int line = 0;
+    std::string fen;
+    std::vector<uint64_t> expected; // index = depth-1
+};
+
+struct EpdResult {
+    std::vector<uint64_t> nodes;    // per depth searched
+    uint64_t total = 0;
+    double ms = 0.0;
+    int fail_depth = 0;             // 0 = pass
+    bool bad_fen = false;
+};
+
+static std::string trim(const std::string& s) {
+    auto b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return "";
+    auto e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+static bool parse_epd_line(const std::string& raw, EpdEntry& out) {
+    std::string line = trim(raw);
+    if (line.empty() || line[0] == '#') return false;
+
+    std::stringstream ss(line);
+    std::string part;
+    std::getline(ss, part, ';');
+    out.fen = trim(part);
+    // EPD carries only 4 FEN fields; pad the clocks so BoardBB::set_fen accepts it
+    int fields = 0;
+    { std::istringstream fs(out.fen); std::string t; while (fs >> t) ++fields; }
+    if (fields == 4) out.fen += " 0 1";
+
+    out.expected.clear();
+    while (std::getline(ss, part, ';')) {
+        std::istringstream ps(part);
+        std::string tag; uint64_t n = 0;
+        if (!(ps >> tag >> n) || tag.size() < 2 || tag[0] != 'D') continue;
+        int d = std::atoi(tag.c_str() + 1);
+        if (d < 1) continue;
+        if ((int)out.expected.size() < d) out.expected.resize(d, 0);
+        out.expected[d - 1] = n;
+    }
+    return true;
+}
+
+static uint64_t perft_bb(BoardBB& pos, int depth) {
+    std::vector<Move> moves;
+    pos.generate_legal_moves(moves);
+    if (depth == 1) return moves.size();
+    uint64_t nodes = 0;
+    for (auto m : moves) {
+        pos.do_move(m);
+        nodes += perft_bb(pos, depth - 1);
+        pos.undo_move();
+    }
+    return nodes;
+}
+
+static void run_entry(const EpdEntry& e, int max_depth, EpdResult& r) {
+    BoardBB pos;
+    if (!pos.set_fen(e.fen)) { r.bad_fen = true; r.fail_depth = -1; return; }
+    int depth = std::min<int>(max_depth, (int)e.expected.size());
+    auto t0 = std::chrono::steady_clock::now();
+    for (int d = 1; d <= depth; ++d) {
+        uint64_t n = perft_bb(pos, d);
+        r.nodes.push_back(n);
+        r.total += n;
+        if (e.expected[d - 1] && n != e.expected[d - 1]) { r.fail_depth = d; break; }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    r.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static std::string json_escape(const std::string& s) {
+    std::string o;
+    for (char ch : s) { if (ch == '"' || ch == '\\') o += '\\'; o += ch; }
+    return o;
+}
+
+static double nps_of(uint64_t n, double ms) { return ms > 0 ? n / (ms / 1000.0) : 0.0; }
+
+static void write_json(std::ostream& os, const std::vector<EpdEntry>& es, const std::vector<EpdResult>& rs,
+                       uint64_t total, double wall_ms, int threads) {
+    os << "{\n  \"threads\": " << threads << ",\n  \"nodes\": " << total
+       << ",\n  \"wall_ms\": " << wall_ms << ",\n  \"nps\": " << (uint64_t)nps_of(total, wall_ms)
+       << ",\n  \"positions\": [\n";
+    for (size_t i = 0; i < es.size(); ++i) {
+        const auto& e = es[i]; const auto& r = rs[i];
+        os << "    {\"line\": " << e.line << ", \"fen\": \"" << json_escape(e.fen) << "\", \"depths\": [";
+        for (size_t d = 0; d < r.nodes.size(); ++d) {
+            os << (d ? ", " : "") << "{\"depth\": " << d + 1 << ", \"expected\": " << e.expected[d]
+               << ", \"nodes\": " << r.nodes[d] << "}";
+        }
+        os << "], \"nodes\": " << r.total << ", \"ms\": " << r.ms
+           << ", \"nps\": " << (uint64_t)nps_of(r.total, r.ms)
+           << ", \"pass\": " << (r.fail_depth == 0 ? "true" : "false")
+           << ", \"fail_depth\": " << r.fail_depth << "}" << (i + 1 < es.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+static void write_csv(std::ostream& os, const std::vector<EpdEntry>& es, const std::vector<EpdResult>& rs) {
+    os << "line,fen,depth,nodes,ms,nps,pass,fail_depth\n";
+    for (size_t i = 0; i < es.size(); ++i) {
+        const auto& e = es[i]; const auto& r = rs[i];
+        os << e.line << ",\"" << e.fen << "\"," << r.nodes.size() << "," << r.total << "," << r.ms << ","
+           << (uint64_t)nps_of(r.total, r.ms) << "," << (r.fail_depth == 0 ? 1 : 0) << "," << r.fail_depth << "\n";
+    }
+}
+
+template <class Fn>
+static bool emit_report(const std::string& path, Fn&& fn) {
+    if (path == "-") { fn(std::cout); return true; }
+    std::ofstream f(path);
+    if (!f) { std::cerr << "Cannot write " << path << "\n"; return false; }
+    fn(f);
+    return true;
+}
+
+static int run_suite(const std::string& epd, int max_depth, int threads,
+                     const std::string& json_out, const std::string& csv_out, double min_nps) {
+    init_attacks();
+
+    std::ifstream in(epd);
+    if (!in) { std::cerr << "Cannot open " << epd << "\n"; return 1; }
+    std::vector<EpdEntry> entries;
+    std::string line;
+    for (int ln = 1; std::getline(in, line); ++ln) {
+        EpdEntry e; e.line = ln;
+        if (parse_epd_line(line, e)) entries.push_back(std::move(e));
+    }
+
+    std::vector<EpdResult> results(entries.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]{
+        for (size_t i; (i = next.fetch_add(1)) < entries.size(); )
+            run_entry(entries[i], max_depth, results[i]);
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    auto t1 = std::chrono::steady_clock::now();
+    double wall_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    uint64_t total = 0; int failed = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& r = results[i];
+        total += r.total;
+        if (r.fail_depth != 0) {
+            ++failed;
+            if (r.bad_fen) std::cerr << "line " << entries[i].line << ": bad FEN\n";
+            else std::cerr << "line " << entries[i].line << ": MISMATCH at d=" << r.fail_depth
+                           << " expected " << entries[i].expected[r.fail_depth - 1]
+                           << " got " << r.nodes.back() << "  (" << entries[i].fen << ")\n";
+        }
+    }
+    double nps = nps_of(total, wall_ms);
+    std::cout << "suite " << epd << ": " << entries.size() << " positions, " << failed << " failed"
+              << "  nodes=" << total << "  time=" << wall_ms << " ms  (" << (uint64_t)nps << " nps, "
+              << threads << " threads)\n";
+
+    if (!json_out.empty() && !emit_report(json_out, [&](std::ostream& os){ write_json(os, entries, results, total, wall_ms, threads); }))
+        return 1;
+    if (!csv_out.empty() && !emit_report(csv_out, [&](std::ostream& os){ write_csv(os, entries, results); }))
+        return 1;
+
+    if (failed) return 2;
+    if (min_nps > 0 && nps < min_nps) {
+        std::cerr << "THROUGHPUT: " << (uint64_t)nps << " nps below --min-nps " << (uint64_t)min_nps << "\n";
+        return 3;
+    }
+    return 0;
+}
+
+static int run_classic() {
+
     {
         Game g; g.load_startpos();
         run("startpos", g, 1, 20);
@@ -85,3 +257,27 @@ int main() {
     }
     return 0;
 }
+
+int main(int argc, char** argv) {
+    std::string epd, json_out, csv_out;
+    int depth = 6;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    double min_nps = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if      (a == "--epd")     epd = val();
+        else if (a == "--depth")   depth = std::atoi(val().c_str());
+        else if (a == "--threads") threads = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--json")    json_out = val();
+        else if (a == "--csv")     csv_out = val();
+        else if (a == "--min-nps") min_nps = std::atof(val().c_str());
+        else {
+            std::cerr << "usage: chess_perft [--epd <file> [--depth N] [--threads N]"
+                         " [--json <out|->] [--csv <out|->] [--min-nps N]]\n";
+            return 1;
+        }
+    }
+    if (epd.empty()) return run_classic();
+    return run_suite(epd, depth, threads, json_out, csv_out, min_nps);
+}
@@ -25,8 +25,8 @@ int main(int argc, char** argv) {
     BoardBB p;
     // default: startpos, or pass a FEN as argv[1]
     if (argc > 1) {
-        if (!p.set_fen(argv[1])) {
-            std::cerr << "Bad FEN\n";
+        if (FenError e = p.parse_fen(argv[1]); e != FenError::Ok) {
+            std::cerr << "Bad FEN: " << to_cstr(e) << "\n";
             return 1;
         }
     } else {
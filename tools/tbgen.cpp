@@ -0,0 +1,526 @@
+// Solves the three-piece endings by retrograde analysis and writes them as Syzygy tables.
+//   chess_tbgen <dir>            write KQvK, KRvK, KPvK, KNvK, KBvK .rtbw/.rtbz into dir
+//   chess_tbgen --check <dir>    regenerate in memory and compare with the files in dir
+// The files are the small fixtures tests/data/syzygy is made of; larger tables come
+// from the usual Syzygy generators. Values are exact (the DTZ plies flags are set where
+// full moves would round); illegal positions get their neighbour's value to compress.
+// KQvK and KPvK keep DTZ for the strong side to move, KRvK for the lone king, so
+// probing exercises both the direct and the one-ply DTZ paths.
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "chess/attacks.hpp"
+
+using namespace chess;
+
+// ---- solving ----
+// index = stm<<18 | wk<<12 | bk<<6 | piece, White is the side with the piece (stm 0)
+constexpr uint32_t SIZE = 2u << 18;
+constexpr int8_t ILLEGAL = -128;
+
+struct Solution {
+    std::vector<int8_t> wdl;   // -2/0/2 for the side to move, ILLEGAL
+    std::vector<uint8_t> dtz;  // plies to a capture, pawn move or mate; 0 for draws
+};
+
+static inline uint32_t index(int stm, int wk, int bk, int p){ return uint32_t(stm << 18 | wk << 12 | bk << 6 | p); }
+
+static Bitboard piece_attacks(PieceType pt, int p, Bitboard occ){
+    switch (pt){
+        case PAWN:   return attacks_pawn(WHITE, Square(p));
+        case KNIGHT: return attacks_knight(Square(p));
+        case BISHOP: return attacks_bishop(Square(p), occ);
+        case ROOK:   return attacks_rook(Square(p), occ);
+        default:     return attacks_queen(Square(p), occ);
+    }
+}
+
+static bool illegal(PieceType pt, int stm, int wk, int bk, int p){
+    if (wk == bk || wk == p || bk == p) return true;
+    if (attacks_king(Square(wk)) & bb(Square(bk))) return true;
+    if (pt == PAWN && (p < 8 || p >= 56)) return true;
+    return stm == 0 && (piece_attacks(pt, p, bb(Square(wk)) | bb(Square(bk))) & bb(Square(bk)));
+}
+
+// A move from a position: a capture or pawn move resolved from elsewhere (result for
+// the mover), or a move inside the table
+struct Child { bool zeroing; int wdl; uint32_t i; };
+
+struct Solver {
+    PieceType pt;
+    const Solution* queen = nullptr; // KQvK and KRvK for promotions
+    const Solution* rook = nullptr;
+    Solution s;
+
+    template<class F> void moves(uint32_t i, F&& f) const {
+        const int stm = int(i >> 18), wk = int(i >> 12) & 63, bk = int(i >> 6) & 63, p = int(i) & 63;
+        const Bitboard wkb = bb(Square(wk)), bkb = bb(Square(bk)), pb = bb(Square(p));
+        if (stm == 0){
+            for (Bitboard to = attacks_king(Square(wk)) & ~attacks_king(Square(bk)) & ~pb; to; to &= to-1)
+                f(Child{false, 0, index(1, lsb(to), bk, p)});
+            if (pt != PAWN){
+                for (Bitboard to = piece_attacks(pt, p, wkb | bkb) & ~wkb & ~bkb; to; to &= to-1)
+                    f(Child{false, 0, index(1, wk, bk, lsb(to))});
+                return;
+            }
+            const int up = p + 8;
+            if ((wkb | bkb) & bb(Square(up))) return;
+            if (up >= 56){
+                f(Child{true, -queen->wdl[index(1, wk, bk, up)], 0});
+                f(Child{true, -rook->wdl[index(1, wk, bk, up)], 0});
+                f(Child{true, 0, 0}); // bishop
+                f(Child{true, 0, 0}); // knight
+                return;
+            }
+            f(Child{true, -s.wdl[index(1, wk, bk, up)], 0});
+            if (p < 16 && !((wkb | bkb) & bb(Square(up + 8))))
+                f(Child{true, -s.wdl[index(1, wk, bk, up + 8)], 0});
+        } else {
+            for (Bitboard to = attacks_king(Square(bk)) & ~attacks_king(Square(wk)); to; to &= to-1){
+                const int t = lsb(to);
+                if (t == p) f(Child{true, 0, 0}); // bare kings
+                else if (!(piece_attacks(pt, p, wkb) & bb(Square(t)))) f(Child{false, 0, index(0, wk, t, p)});
+            }
+        }
+    }
+
+    bool in_check(uint32_t i) const {
+        const int wk = int(i >> 12) & 63, bk = int(i >> 6) & 63, p = int(i) & 63;
+        return (i >> 18) && (piece_attacks(pt, p, bb(Square(wk)) | bb(Square(bk))) & bb(Square(bk)));
+    }
+
+    // Positions with this piece square (pawns), or all of them; results of positions
+    // reached by pawn moves must be known. In round k the positions at distance k are
+    // found: a win by a capture, pawn move or mate, or by moving to a loss in k-1; a
+    // loss when every move reaches a known win, the longest in k-1.
+    void solve(const std::vector<uint32_t>& part){
+        std::vector<uint32_t> open;
+        for (uint32_t i : part){
+            if (illegal(pt, int(i >> 18), int(i >> 12) & 63, int(i >> 6) & 63, int(i) & 63)) { s.wdl[i] = ILLEGAL; continue; }
+            int count = 0;
+            moves(i, [&](const Child&){ ++count; });
+            if (count) open.push_back(i);
+            else if (in_check(i)) { s.wdl[i] = -2; s.dtz[i] = 1; } // mated
+            else s.wdl[i] = 0;
+        }
+        for (int k = 1; !open.empty(); ++k){
+            size_t kept = 0;
+            for (uint32_t i : open){
+                bool win = false, all_won = true;
+                int longest = 0;
+                moves(i, [&](const Child& c){
+                    if (c.zeroing){
+                        win |= k == 1 && c.wdl == 2;
+                        all_won &= c.wdl == -2;
+                        return;
+                    }
+                    // a mate counts 1 like a winning capture
+                    win |= s.wdl[c.i] == -2 && s.dtz[c.i] == std::max(k - 1, 1);
+                    all_won &= s.wdl[c.i] == 2 && s.dtz[c.i] < k;
+                    longest = std::max<int>(longest, s.wdl[c.i] == 2 ? s.dtz[c.i] : 0);
+                });
+                if (win) { s.wdl[i] = 2; s.dtz[i] = uint8_t(k); }
+                else if (all_won) { s.wdl[i] = -2; s.dtz[i] = uint8_t(longest + 1); }
+                else open[kept++] = i;
+            }
+            if (kept == open.size()) break;
+            open.resize(kept);
+        }
+        for (uint32_t i : open) s.wdl[i] = 0;
+    }
+
+    Solution run(){
+        s.wdl.assign(SIZE, 0);
+        s.dtz.assign(SIZE, 0);
+        std::vector<uint32_t> part;
+        if (pt != PAWN){
+            for (uint32_t i = 0; i < SIZE; ++i) part.push_back(i);
+            solve(part);
+            return s;
+        }
+        // pawn moves lead to higher ranks: solve those first
+        for (uint32_t i = 0; i < SIZE; ++i)
+            if ((i & 63) < 8 || (i & 63) >= 56) s.wdl[i] = ILLEGAL;
+        for (int p = 55; p >= 8; --p){
+            part.clear();
+            for (int stm = 0; stm < 2; ++stm)
+                for (int wk = 0; wk < 64; ++wk)
+                    for (int bk = 0; bk < 64; ++bk) part.push_back(index(stm, wk, bk, p));
+            solve(part);
+        }
+        return s;
+    }
+};
+
+// ---- position index (the Syzygy encoding, for three pieces) ----
+static int map_a1d1d4[64], map_b1h1h7[64];
+
+static void init_maps(){
+    int code = 0;
+    for (int s = 0; s < 64; ++s)
+        if ((s >> 3) < (s & 7)) map_b1h1h7[s] = code++;
+    code = 0;
+    for (int s = 0; s < 64; ++s)
+        if ((s & 7) <= 3 && (s >> 3) < (s & 7)) map_a1d1d4[s] = code++;
+    for (int s = 0; s <= 27; s += 9) map_a1d1d4[s] = code++;
+}
+
+static inline int off_diagonal(int s){ return (s >> 3) - (s & 7); }
+
+// sq in table order; a pawn (first) picks the file, returned in file
+static uint64_t encode(int sq[3], bool pawns, int& file){
+    if ((sq[0] & 7) > 3)
+        for (int i = 0; i < 3; ++i) sq[i] ^= 7;
+    if (pawns){
+        file = sq[0] & 7;
+        // lead pawn by rank, then the two kings on the 63 and 62 squares left
+        const uint64_t n1 = uint64_t(sq[1] - (sq[1] > sq[0]));
+        const uint64_t n2 = uint64_t(sq[2] - (sq[2] > sq[0]) - (sq[2] > sq[1]));
+        return uint64_t((sq[0] >> 3) - 1) + 6 * n1 + 6 * 63 * n2;
+    }
+    file = 0;
+    if ((sq[0] >> 3) > 3)
+        for (int i = 0; i < 3; ++i) sq[i] ^= 56;
+    for (int i = 0; i < 3; ++i){
+        if (!off_diagonal(sq[i])) continue;
+        if (off_diagonal(sq[i]) > 0)
+            for (int j = i; j < 3; ++j) sq[j] = ((sq[j] >> 3) | (sq[j] << 3)) & 63;
+        break;
+    }
+    const int a1 = sq[1] > sq[0], a2 = (sq[2] > sq[0]) + (sq[2] > sq[1]);
+    const int r0 = sq[0] >> 3, r1 = sq[1] >> 3, r2 = sq[2] >> 3;
+    if (off_diagonal(sq[0])) return uint64_t((map_a1d1d4[sq[0]] * 63 + sq[1] - a1) * 62 + sq[2] - a2);
+    if (off_diagonal(sq[1])) return uint64_t((6*63 + r0*28 + map_b1h1h7[sq[1]]) * 62 + sq[2] - a2);
+    if (off_diagonal(sq[2])) return uint64_t(6*63*62 + 4*28*62 + r0*7*28 + (r1 - a1)*28 + map_b1h1h7[sq[2]]);
+    return uint64_t(6*63*62 + 4*28*62 + 4*7*28 + r0*7*6 + (r1 - a1)*6 + (r2 - a2));
+}
+
+// ---- compression ----
+// The value stream of one table is recursively paired (the most frequent adjacent
+// pair of symbols becomes a new symbol), Huffman-coded with a canonical code whose
+// longer codes have the lower symbol numbers, and cut into fixed-size blocks.
+struct Packed {
+    uint8_t flags = 0;
+    int block_log = 0, span_log = 0;
+    int min_len = 0, max_len = 0;
+    std::vector<uint16_t> lowest_sym;
+    std::vector<std::pair<int, int>> tree; // left, right (0xFFF: left is a value)
+    std::vector<uint16_t> block_len;
+    std::string sparse, data;
+};
+
+static void put16(std::string& o, uint32_t v){ o += char(v & 255); o += char(v >> 8 & 255); }
+static void put32(std::string& o, uint32_t v){ put16(o, v & 0xFFFF); put16(o, v >> 16); }
+
+// values: -1 = any
+static Packed compress(std::vector<int> values, int block_log, int span_log){
+    Packed pk;
+    pk.block_log = block_log;
+    pk.span_log = span_log;
+    int last = -1;
+    for (int v : values) if (v >= 0) { last = v; break; }
+    for (int& v : values) v = v < 0 ? std::max(last, 0) : (last = v);
+    if (std::all_of(values.begin(), values.end(), [&](int v){ return v == values[0]; })){
+        pk.flags = 128; // single value
+        pk.min_len = values.empty() ? 0 : values[0];
+        return pk;
+    }
+
+    const int values_n = *std::max_element(values.begin(), values.end()) + 1;
+    std::vector<int> len; // values per symbol
+    for (int v = 0; v < values_n; ++v) { pk.tree.push_back({v, 0xFFF}); len.push_back(1); }
+    std::vector<int> seq = values;
+    while (pk.tree.size() < 4095){
+        std::map<std::pair<int, int>, int> freq;
+        for (size_t i = 0; i + 1 < seq.size(); ++i)
+            if (len[size_t(seq[i])] + len[size_t(seq[i+1])] <= 256) ++freq[{seq[i], seq[i+1]}];
+        auto best = std::max_element(freq.begin(), freq.end(), [](auto& a, auto& b){ return a.second < b.second; });
+        if (best == freq.end() || best->second < 4) break;
+        const int sym = int(pk.tree.size());
+        pk.tree.push_back(best->first);
+        len.push_back(len[size_t(best->first.first)] + len[size_t(best->first.second)]);
+        size_t n = 0;
+        for (size_t i = 0; i < seq.size(); ++i)
+            if (i + 1 < seq.size() && seq[i] == best->first.first && seq[i+1] == best->first.second) { seq[n++] = sym; ++i; }
+            else seq[n++] = seq[i];
+        seq.resize(n);
+    }
+
+    // Huffman code lengths of the symbols left in the stream
+    const size_t syms = pk.tree.size();
+    std::vector<uint64_t> count(syms);
+    for (int s : seq) ++count[size_t(s)];
+    std::vector<int> bits(syms, 0), parent;
+    using Node = std::pair<uint64_t, int>;
+    std::vector<int> leaf(syms, -1);
+    {
+        std::priority_queue<Node, std::vector<Node>, std::greater<>> h;
+        for (size_t s = 0; s < syms; ++s)
+            if (count[s]){
+                leaf[s] = int(parent.size());
+                h.push({count[s], leaf[s]});
+                parent.push_back(-1);
+            }
+        while (h.size() > 1){
+            auto a = h.top(); h.pop();
+            auto b = h.top(); h.pop();
+            parent.push_back(-1);
+            parent[size_t(a.second)] = parent[size_t(b.second)] = int(parent.size()) - 1;
+            h.push({a.first + b.first, int(parent.size()) - 1});
+        }
+    }
+    for (size_t s = 0; s < syms; ++s){
+        if (leaf[s] < 0) continue;
+        int d = 0;
+        for (int x = leaf[s]; parent[size_t(x)] >= 0; x = parent[size_t(x)]) ++d;
+        bits[s] = std::max(d, 1);
+    }
+
+    // renumber: coded symbols first, longest codes lowest
+    std::vector<int> order(syms);
+    for (size_t s = 0; s < syms; ++s) order[s] = int(s);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){
+        return (bits[size_t(a)] > 0) != (bits[size_t(b)] > 0) ? bits[size_t(a)] > 0 : bits[size_t(a)] > bits[size_t(b)];
+    });
+    std::vector<int> id(syms);
+    for (size_t n = 0; n < syms; ++n) id[size_t(order[n])] = int(n);
+    std::vector<std::pair<int, int>> tree(syms);
+    std::vector<int> sym_len(syms), sym_bits(syms);
+    for (size_t s = 0; s < syms; ++s){
+        auto [l, r] = pk.tree[s];
+        tree[size_t(id[s])] = r == 0xFFF ? std::pair{l, r} : std::pair{id[size_t(l)], id[size_t(r)]};
+        sym_len[size_t(id[s])] = len[s];
+        sym_bits[size_t(id[s])] = bits[s];
+    }
+    pk.tree = tree;
+    for (int& s : seq) s = id[size_t(s)];
+
+    pk.max_len = 0;
+    pk.min_len = 64;
+    for (int b : sym_bits) if (b) { pk.max_len = std::max(pk.max_len, b); pk.min_len = std::min(pk.min_len, b); }
+    const int lengths = pk.max_len - pk.min_len + 1;
+    std::vector<int> n_of(size_t(lengths), 0);
+    for (int b : sym_bits) if (b) ++n_of[size_t(b - pk.min_len)];
+    pk.lowest_sym.assign(size_t(lengths), 0);
+    std::vector<uint64_t> base(size_t(lengths), 0);
+    for (int i = lengths - 2; i >= 0; --i){
+        pk.lowest_sym[size_t(i)] = uint16_t(pk.lowest_sym[size_t(i)+1] + n_of[size_t(i)+1]);
+        base[size_t(i)] = (base[size_t(i)+1] + uint64_t(n_of[size_t(i)+1])) / 2;
+    }
+    auto code_of = [&](int s){
+        const size_t i = size_t(sym_bits[size_t(s)] - pk.min_len);
+        return base[i] + uint64_t(s - pk.lowest_sym[i]);
+    };
+
+    // blocks of whole symbols
+    const size_t block_bits = size_t(8) << block_log;
+    std::vector<uint64_t> block_start;
+    std::string block;
+    size_t used = 0;
+    int in_block = 0;
+    uint64_t value_at = 0;
+    auto flush = [&]{
+        block.resize(block_bits / 8, '\0');
+        pk.data += block;
+        pk.block_len.push_back(uint16_t(in_block - 1));
+        block.clear();
+        used = 0;
+        in_block = 0;
+    };
+    for (int s : seq){
+        const int b = sym_bits[size_t(s)];
+        if (used + size_t(b) > block_bits || in_block + sym_len[size_t(s)] > 32768) flush();
+        if (!in_block) block_start.push_back(value_at);
+        const uint64_t c = code_of(s);
+        for (int k = b - 1; k >= 0; --k, ++used){
+            if (used % 8 == 0) block += '\0';
+            if (c >> k & 1) block.back() = char(block.back() | (0x80 >> (used % 8)));
+        }
+        in_block += sym_len[size_t(s)];
+        value_at += uint64_t(sym_len[size_t(s)]);
+    }
+    flush();
+
+    // sparse index: block and offset of value k * span + span / 2
+    const uint64_t span = uint64_t(1) << span_log;
+    for (uint64_t k = 0; k * span < values.size(); ++k){
+        const uint64_t v = k * span + span / 2;
+        const size_t b = size_t(std::upper_bound(block_start.begin(), block_start.end(), v) - block_start.begin() - 1);
+        put32(pk.sparse, uint32_t(b));
+        put16(pk.sparse, uint32_t(v - block_start[b]));
+    }
+    return pk;
+}
+
+static void put_sizes(std::string& o, const Packed& pk){
+    o += char(pk.flags);
+    if (pk.flags & 128) { o += char(pk.min_len); return; }
+    o += char(pk.block_log);
+    o += char(pk.span_log);
+    o += char(0); // block length padding
+    put32(o, uint32_t(pk.block_len.size()));
+    o += char(pk.max_len);
+    o += char(pk.min_len);
+    for (uint16_t s : pk.lowest_sym) put16(o, s);
+    put16(o, uint32_t(pk.tree.size()));
+    for (auto [l, r] : pk.tree){
+        o += char(l & 255);
+        o += char((l >> 8) | (r & 15) << 4);
+        o += char(r >> 4);
+    }
+    if (pk.tree.size() & 1) o += char(0);
+}
+
+// ---- table files ----
+struct Material {
+    const char* name;
+    PieceType pt;
+    int dtz_stm; // side kept in the .rtbz
+};
+
+constexpr int UNSET = -1000; // no legal position has this index
+
+// Piece codes: 1..6 white pawn..king, +8 black. Order: the piece, the kings.
+static std::string table_file(const Material& m, const Solution& sol, bool dtz){
+    const bool pawns = m.pt == PAWN;
+    const int files = pawns ? 4 : 1, sides = dtz ? 1 : 2;
+    const uint8_t pieces[3] = { uint8_t(m.pt + 1), uint8_t(KING + 1), uint8_t(8 + KING + 1) };
+
+    // values by side and file, in index order
+    std::vector<int> values[2][4];
+    const uint64_t size = pawns ? 6*63*62 : 31332;
+    for (int sd = 0; sd < sides; ++sd)
+        for (int f = 0; f < files; ++f) values[sd][f].assign(size, UNSET);
+    // DTZ values become positions in per-result lists, the most frequent first
+    std::map<int, uint64_t> freq[4][2]; // [file][win, loss]
+    for (uint32_t i = 0; i < SIZE; ++i){
+        const int stm = int(i >> 18);
+        if (sol.wdl[i] == ILLEGAL || (dtz && (stm != m.dtz_stm || !sol.wdl[i]))) continue;
+        int sq[3] = { int(i) & 63, int(i >> 12) & 63, int(i >> 6) & 63 }, f;
+        const uint64_t idx = encode(sq, pawns, f);
+        if (dtz) ++freq[f][sol.wdl[i] < 0][sol.dtz[i]];
+        int& v = values[dtz ? 0 : stm][f][idx];
+        const int want = dtz ? (sol.wdl[i] < 0 ? -sol.dtz[i] : sol.dtz[i]) : sol.wdl[i] + 2;
+        if (v != UNSET && v != want) { std::cerr << m.name << ": index collision\n"; std::exit(1); }
+        v = want;
+    }
+
+    std::string o;
+    o += char(dtz ? 0xD7 : 0x71); o += char(dtz ? 0x66 : 0xE8); o += char(dtz ? 0x0C : 0x23); o += char(dtz ? 0xA5 : 0x5D);
+    o += char(1 | (pawns ? 2 : 0)); // split (colours not symmetric), has pawns
+    for (int f = 0; f < files; ++f){
+        o += char(0); // the leading group comes first in the index
+        for (uint8_t p : pieces) o += char(dtz ? p : p | p << 4);
+    }
+    if (o.size() & 1) o += char(0);
+
+    Packed pk[2][4];
+    std::string maps;
+    for (int f = 0; f < files; ++f)
+        for (int sd = 0; sd < sides; ++sd){
+            std::vector<int>& v = values[sd][f];
+            uint8_t flags = 0;
+            if (dtz){
+                // store the rank in the win or loss list; plies when moves would round
+                std::vector<std::pair<uint64_t, int>> lists[2];
+                bool plies[2] = { false, false };
+                for (int l = 0; l < 2; ++l){
+                    for (auto [d, n] : freq[f][l]){ lists[l].push_back({n, d}); plies[l] |= d % 2 == 0; }
+                    std::stable_sort(lists[l].begin(), lists[l].end(), [](auto& a, auto& b){ return a.first > b.first; });
+                }
+                for (int& x : v){
+                    if (x == UNSET) continue;
+                    const int l = x < 0, d = std::abs(x);
+                    x = int(std::find_if(lists[l].begin(), lists[l].end(), [&](auto& e){ return e.second == d; }) - lists[l].begin());
+                }
+                flags = uint8_t(m.dtz_stm | 2 | (plies[0] ? 4 : 0) | (plies[1] ? 8 : 0));
+                for (int l : { 0, 1, 2, 3 }){
+                    maps += char(l < 2 ? lists[l].size() : 0);
+                    for (int k = 0; l < 2 && k < int(lists[l].size()); ++k){
+                        const int d = lists[l][size_t(k)].second;
+                        maps += char(plies[l] ? d - 1 : (d - 1) / 2);
+                    }
+                }
+            }
+            std::replace(v.begin(), v.end(), UNSET, -1);
+            pk[sd][f] = compress(v, dtz ? 7 : 6, 8);
+            pk[sd][f].flags |= flags;
+        }
+    for (int f = 0; f < files; ++f)
+        for (int sd = 0; sd < sides; ++sd) put_sizes(o, pk[sd][f]);
+    if (dtz){
+        o += maps;
+        if (o.size() & 1) o += char(0);
+    }
+    for (int f = 0; f < files; ++f)
+        for (int sd = 0; sd < sides; ++sd) o += pk[sd][f].sparse;
+    for (int f = 0; f < files; ++f)
+        for (int sd = 0; sd < sides; ++sd)
+            for (uint16_t b : pk[sd][f].block_len) put16(o, b);
+    for (int f = 0; f < files; ++f)
+        for (int sd = 0; sd < sides; ++sd){
+            o.resize((o.size() + 63) & ~size_t(63), '\0');
+            o += pk[sd][f].data;
+        }
+    return o;
+}
+
+int main(int argc, char** argv) {
+    bool check = false;
+    std::string dir;
+    for (int i = 1; i < argc; ++i){
+        std::string a = argv[i];
+        if (a == "--check") check = true;
+        else dir = a;
+    }
+    if (dir.empty()) {
+        std::cerr << "usage: chess_tbgen [--check] <dir>\n";
+        return 1;
+    }
+
+    init_attacks();
+    init_maps();
+    // KNvK and KBvK are draws throughout (single-value tables); promotions need them
+    const Material materials[5] = { {"KQvK", QUEEN, 0}, {"KRvK", ROOK, 1}, {"KPvK", PAWN, 0},
+                                    {"KNvK", KNIGHT, 0}, {"KBvK", BISHOP, 0} };
+    Solution sol[5];
+    for (int k = 0; k < 5; ++k){
+        if (k >= 3){
+            sol[k].wdl.assign(SIZE, 0);
+            for (uint32_t i = 0; i < SIZE; ++i)
+                if (illegal(materials[k].pt, int(i >> 18), int(i >> 12) & 63, int(i >> 6) & 63, int(i) & 63)) sol[k].wdl[i] = ILLEGAL;
+            continue;
+        }
+        Solver s{materials[k].pt, &sol[0], &sol[1], {}};
+        sol[k] = s.run();
+    }
+
+    int failed = 0;
+    for (int k = 0; k < 5; ++k){
+        int longest = 0;
+        for (uint32_t i = 0; i < SIZE && k < 3; ++i) if (sol[k].wdl[i] == 2) longest = std::max<int>(longest, sol[k].dtz[i]);
+        if (longest > 100) { std::cerr << materials[k].name << ": cursed wins are not supported\n"; return 1; }
+        for (bool dtz : { false, true }){
+            const std::string path = dir + "/" + materials[k].name + (dtz ? ".rtbz" : ".rtbw");
+            const std::string data = table_file(materials[k], sol[k], dtz);
+            if (check){
+                std::ifstream in(path, std::ios::binary);
+                const std::string have{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+                if (have != data) { std::cerr << path << ": differs\n"; ++failed; }
+                continue;
+            }
+            std::ofstream out(path, std::ios::binary);
+            out.write(data.data(), std::streamsize(data.size()));
+            if (!out) { std::cerr << "Cannot write " << path << "\n"; return 1; }
+        }
+        std::cout << materials[k].name << ": longest win " << longest << " plies\n";
+    }
+    return failed ? 1 : 0;
+}
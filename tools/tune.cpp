@@ -0,0 +1,229 @@
+// Texel tuning of the eval_bb weights on chess_datagen output.
+//   chess_tune <data.bin> [--epochs N] [--threads N] [--lr X] [--k K] [--lambda L]
+//              [--limit N] [--out <file|->]
+// The features of every record (chess/eval_terms.hpp) are extracted once and kept in
+// memory. Each epoch then evaluates all positions with the current weights, sums the
+// gradient of the mean squared error between sigmoid(K * eval) and the target over the
+// threads, and takes an Adam step. target = lambda * result + (1 - lambda) * sigmoid(K * score);
+// K is fitted to the results first unless --k is given. The weights are written in the
+// format of chess/eval_weights.hpp, ready to replace it.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess/attacks.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/eval_terms.hpp"
+#include "chess/mapped_file.hpp"
+#include "chess/training.hpp"
+
+using namespace chess;
+
+// The positions one thread works on: features of position i are feats[end[i-1] .. end[i])
+struct Shard {
+    std::vector<EvalFeature> feats;
+    std::vector<uint32_t> end;
+    std::vector<int16_t> score;  // search score, White's view
+    std::vector<uint8_t> result; // result_code
+    std::vector<float> target;
+    size_t size() const { return end.size(); }
+};
+
+using Weights = std::vector<double>;
+
+// One call of f(shard, index) per shard, each on its own thread
+static void for_each_shard(std::vector<Shard>& shards, const std::function<void(Shard&, size_t)>& f) {
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < shards.size(); ++i) pool.emplace_back(f, std::ref(shards[i]), i);
+    f(shards[0], 0);
+    for (auto& th : pool) th.join();
+}
+
+// 1 / (1 + 10^(-k * e / 400))
+static double sigmoid(double k, double e) { return 1.0 / (1.0 + std::exp(-k * e * (std::log(10.0) / 400.0))); }
+
+static double eval_of(const Shard& s, size_t i, const Weights& w) {
+    double e = 0;
+    for (uint32_t j = i ? s.end[i - 1] : 0; j < s.end[i]; ++j) e += w[s.feats[j].term] * s.feats[j].count;
+    return e;
+}
+
+// Mean squared error; against the game results alone if results_only
+static double mean_loss(std::vector<Shard>& shards, const Weights& w, double k, bool results_only) {
+    std::vector<double> sum(shards.size());
+    size_t n = 0;
+    for (const Shard& s : shards) n += s.size();
+    for_each_shard(shards, [&](Shard& s, size_t id) {
+        double acc = 0;
+        for (size_t i = 0; i < s.size(); ++i) {
+            const double t = results_only ? s.result[i] / 2.0 : s.target[i];
+            const double d = t - sigmoid(k, eval_of(s, i, w));
+            acc += d * d;
+        }
+        sum[id] = acc;
+    });
+    double total = 0;
+    for (double x : sum) total += x;
+    return n ? total / double(n) : 0;
+}
+
+// Golden-section search for the K that best maps evaluations to results
+static double fit_k(std::vector<Shard>& shards, const Weights& w) {
+    const double g = (std::sqrt(5.0) - 1) / 2;
+    double a = 0.05, b = 4.0;
+    double c = b - g * (b - a), d = a + g * (b - a);
+    double fc = mean_loss(shards, w, c, true), fd = mean_loss(shards, w, d, true);
+    for (int it = 0; it < 30; ++it) {
+        if (fc < fd) { b = d; d = c; fd = fc; c = b - g * (b - a); fc = mean_loss(shards, w, c, true); }
+        else         { a = c; c = d; fc = fd; d = a + g * (b - a); fd = mean_loss(shards, w, d, true); }
+    }
+    return (a + b) / 2;
+}
+
+// Same layout as chess/eval_weights.hpp
+static void write_weights(std::ostream& os, const EvalWeights& ew) {
+    static const char* const names[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+    const int16_t* w = ew.w;
+    os << "#pragma once\n"
+          "// Evaluation weights, written by chess_tune. Order and meaning: EvalTerm in\n"
+          "// chess/eval_terms.hpp.\n"
+          "#include \"chess/eval_terms.hpp\"\n\n"
+          "namespace chess {\n\n"
+          "inline constexpr EvalWeights DEFAULT_EVAL_WEIGHTS = {{\n"
+          "    // material: pawn knight bishop rook queen\n    ";
+    for (int pt = 0; pt < 5; ++pt) os << w[TERM_PIECE + pt] << (pt < 4 ? ", " : ",\n");
+    os << "    // mobility, bishop pair\n    " << w[TERM_MOBILITY] << ", " << w[TERM_BISHOP_PAIR] << ",\n"
+       << "    // piece-square tables from White's side, a1..h8 (one rank per line)\n";
+    for (int pt = 0; pt < 6; ++pt) {
+        os << "    // " << names[pt] << "\n";
+        for (int r = 0; r < 8; ++r) {
+            os << "    ";
+            for (int f = 0; f < 8; ++f) os << w[TERM_PST + 64 * pt + 8 * r + f] << (f < 7 ? ", " : ",\n");
+        }
+    }
+    os << "}};\n\n} // namespace chess\n";
+}
+
+int main(int argc, char** argv) {
+    std::string in_path, out_path = "eval_weights.hpp";
+    int epochs = 200, threads = std::max(1u, std::thread::hardware_concurrency());
+    double lr = 1.0, k = 0, lambda = 1.0;
+    uint64_t limit = 0;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if      (a == "--epochs")  epochs = std::max(0, std::atoi(val().c_str()));
+        else if (a == "--threads") threads = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--lr")      lr = std::atof(val().c_str());
+        else if (a == "--k")       k = std::atof(val().c_str());
+        else if (a == "--lambda")  lambda = std::clamp(std::atof(val().c_str()), 0.0, 1.0);
+        else if (a == "--limit")   limit = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--out")     out_path = val();
+        else if (in_path.empty() && (a == "-" || a[0] != '-')) in_path = a;
+        else ok = false;
+    }
+    if (!ok || in_path.empty() || out_path.empty() || lr <= 0) {
+        std::cerr << "usage: chess_tune <data.bin> [--epochs N] [--threads N] [--lr X] [--k K] [--lambda L]\n"
+                     "                  [--limit N] [--out <file|->]\n";
+        return 1;
+    }
+
+    MappedFile in;
+    if (!in.open(in_path)) { std::cerr << "Cannot open " << in_path << "\n"; return 1; }
+    init_attacks();
+    bitbase::init();
+    auto records = training_records(in.view());
+    if (limit && limit < records.size()) records = records.first(limit);
+
+    // features, once; shard t takes an equal slice of the records
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Shard> shards(std::min<size_t>(size_t(threads), std::max<size_t>(1, records.size())));
+    for_each_shard(shards, [&](Shard& s, size_t id) {
+        const size_t b = records.size() * id / shards.size(), e = records.size() * (id + 1) / shards.size();
+        BoardBB pos;
+        std::vector<EvalFeature> f;
+        for (size_t i = b; i < e; ++i) {
+            if (!pos.decode(records[i].pos) || !eval_features(pos, f)) continue;
+            s.feats.insert(s.feats.end(), f.begin(), f.end());
+            s.end.push_back(uint32_t(s.feats.size()));
+            s.score.push_back(records[i].score);
+            s.result.push_back(std::min<uint8_t>(records[i].result, 2));
+        }
+    });
+    size_t n = 0, feats = 0;
+    for (const Shard& s : shards) { n += s.size(); feats += s.feats.size(); }
+    const double load_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cerr << "positions " << n << " of " << records.size() << ", " << (n ? double(feats) / double(n) : 0)
+              << " features each, " << (feats * sizeof(EvalFeature) + n * 11) / (1 << 20) << " MB, loaded in "
+              << load_secs << " s\n";
+    if (!n) { std::cerr << "No usable positions in " << in_path << "\n"; return 1; }
+
+    Weights w(eval_weights().w, eval_weights().w + EVAL_TERM_COUNT);
+    if (k <= 0) k = fit_k(shards, w);
+    for_each_shard(shards, [&](Shard& s, size_t) {
+        s.target.resize(s.size());
+        for (size_t i = 0; i < s.size(); ++i)
+            s.target[i] = float(lambda * s.result[i] / 2.0 + (1 - lambda) * sigmoid(k, s.score[i]));
+    });
+    std::cerr << "K " << k << ", initial loss " << mean_loss(shards, w, k, false) << "\n";
+
+    // Adam on the mean squared error
+    const double b1 = 0.9, b2 = 0.999, eps = 1e-8;
+    const double scale = 2 * k * std::log(10.0) / 400.0 / double(n); // d(loss)/d(eval) factor
+    Weights m(EVAL_TERM_COUNT), v(EVAL_TERM_COUNT);
+    std::vector<Weights> grads(shards.size(), Weights(EVAL_TERM_COUNT));
+    std::vector<double> losses(shards.size());
+    const int report = std::max(1, epochs / 20);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int ep = 1; ep <= epochs; ++ep) {
+        for_each_shard(shards, [&](Shard& s, size_t id) {
+            Weights& g = grads[id];
+            std::fill(g.begin(), g.end(), 0.0);
+            double loss = 0;
+            for (size_t i = 0; i < s.size(); ++i) {
+                const double p = sigmoid(k, eval_of(s, i, w)), d = p - s.target[i];
+                loss += d * d;
+                const double de = d * p * (1 - p);
+                for (uint32_t j = i ? s.end[i - 1] : 0; j < s.end[i]; ++j) g[s.feats[j].term] += de * s.feats[j].count;
+            }
+            losses[id] = loss;
+        });
+        double loss = 0;
+        for (size_t t = 0; t < shards.size(); ++t) loss += losses[t];
+        for (int j = 0; j < EVAL_TERM_COUNT; ++j) {
+            double g = 0;
+            for (const Weights& gt : grads) g += gt[j];
+            g *= scale;
+            m[j] = b1 * m[j] + (1 - b1) * g;
+            v[j] = b2 * v[j] + (1 - b2) * g * g;
+            const double mh = m[j] / (1 - std::pow(b1, ep)), vh = v[j] / (1 - std::pow(b2, ep));
+            w[j] -= lr * mh / (std::sqrt(vh) + eps);
+        }
+        if (ep % report == 0 || ep == epochs) {
+            const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+            std::cerr << "epoch " << ep << " loss " << loss / double(n) << " (" << secs / ep << " s/epoch)\n";
+        }
+    }
+    std::cerr << "final loss " << mean_loss(shards, w, k, false) << "\n";
+
+    EvalWeights out;
+    for (int j = 0; j < EVAL_TERM_COUNT; ++j) out.w[j] = int16_t(std::clamp(std::lround(w[j]), -32000L, 32000L));
+    if (out_path == "-") {
+        write_weights(std::cout, out);
+    } else {
+        std::ofstream f(out_path);
+        write_weights(f, out);
+        if (!f) { std::cerr << "Cannot write " << out_path << "\n"; return 1; }
+        std::cerr << "weights -> " << out_path << "\n";
+    }
+    return 0;
+}
@@ -4,92 +4,180 @@
 #include <vector>
 #include <cctype>
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
 
-#include "chess/game.hpp"
-#include "chess/strategy.hpp"
+#include "chess/attacks.hpp"
+#include "chess/board_bb.hpp"
+#include "chess/search_bb.hpp"
+#include "chess/bench.hpp"
+#include "chess/bitbase.hpp"
+#include "chess/polyglot.hpp"
+#include "chess/tbprobe.hpp"
 
 using namespace chess;
 
-static inline int file_to_col(char f){ return int(f - 'a'); }
-static inline int rank_to_row(char r){ return int(r - '1'); }
-static inline char col_to_file(int c){ return char('a' + c); }
-static inline char row_to_rank(int r){ return char('1' + r); }
-
-static std::string uci_move_to_engine(const std::string& u) {
-    if (u.size() < 4) return "";
-    int c0 = file_to_col(u[0]);
-    int r0 = rank_to_row(u[1]);
-    int c1 = file_to_col(u[2]);
-    int r1 = rank_to_row(u[3]);
-    if (r0<0||r0>7||c0<0||c0>7||r1<0||r1>7||c1<0||c1>7) return "";
-    std::string a, b;
-    a.push_back(char('0'+r0)); a.push_back(char('0'+c0));
-    b.push_back(char('0'+r1)); b.push_back(char('0'+c1));
-    return a + " " + b;
-}
-
-static std::string engine_move_to_uci(const std::string& m) {
-    if (m.size() != 5 || m[2] != ' ') return "";
-    int r0 = m[0]-'0', c0 = m[1]-'0', r1 = m[3]-'0', c1 = m[4]-'0';
-    std::string u;
-    u += col_to_file(c0); u += row_to_rank(r0);
-    u += col_to_file(c1); u += row_to_rank(r1);
-    return u;
+// UCI long algebraic ("e2e4", "e7e8q") -> legal move in pos
+static bool parse_uci_move(BoardBB& pos, const std::string& u, Move& out) {
+    if (u.size() < 4) return false;
+    int c0 = u[0]-'a', r0 = u[1]-'1', c1 = u[2]-'a', r1 = u[3]-'1';
+    if (r0<0||r0>7||c0<0||c0>7||r1<0||r1>7||c1<0||c1>7) return false;
+    int from = r0*8 + c0, to = r1*8 + c1;
+    int promo = -1;
+    if (u.size() > 4) {
+        switch (std::tolower(static_cast<unsigned char>(u[4]))) {
+            case 'n': promo = MF_PROMO_N; break; case 'b': promo = MF_PROMO_B; break;
+            case 'r': promo = MF_PROMO_R; break; case 'q': promo = MF_PROMO_Q; break;
+            default: return false;
+        }
+    }
+    std::vector<Move> moves;
+    pos.generate_legal_moves(moves);
+    for (auto m : moves) {
+        if (m.from()!=from || m.to()!=to) continue;
+        bool isPromo = m.flag()>=MF_PROMO_N;
+        if (promo < 0 ? !isPromo : m.flag()==promo) { out = m; return true; }
+    }
+    return false;
 }
 
 struct UciEngine {
-    Game game;
-    MinimaxStrategy strat;
+    BoardBB pos;
+    int depth = 5;
     bool thinking = false;
+    PolyglotBook book;
+    bool own_book = false, book_best = false;
+    bool book_keys = polyglot_keys_standard(); // probing a book needs the reference keys
+    int tb_probe_depth = 1;
+    std::mt19937_64 rng{std::random_device{}()};
 
-    UciEngine() { strat.max_depth = 3; }
+    UciEngine() { pos.set_startpos(); }
 
-    void new_game() { game = Game{}; }
+    void new_game() { pos.set_startpos(); }
 
     void set_position_from_cmd(const std::string& cmd) {
         std::istringstream ss(cmd);
         std::string tok; ss >> tok;
         ss >> tok;
         if (tok == "startpos") {
-            game = Game{};
-            if (ss >> tok && tok == "moves") {
-                std::string um;
-                while (ss >> um) {
-                    std::string mv = uci_move_to_engine(um);
-                    std::string err;
-                    game.move(mv, err); // ignore failures
-                }
-            }
+            pos.set_startpos();
+            ss >> tok;
         } else if (tok == "fen") {
-            // optional: implement FEN parsing from the rest of the line
-            std::string fen, rest;
-            std::getline(ss, rest);
-            // You can parse and call game.load_fen(fen, err) here if desired.
+            std::string fen, part;
+            while (ss >> part && part != "moves") fen += (fen.empty() ? "" : " ") + part;
+            tok = part;
+            if (FenError e = pos.parse_fen(fen); e != FenError::Ok) {
+                std::cout << "info string bad fen: " << to_cstr(e) << std::endl;
+                pos.set_startpos();
+                return;
+            }
+        } else {
+            return;
+        }
+        if (tok == "moves") {
+            std::string um;
+            while (ss >> um) {
+                Move m;
+                if (!parse_uci_move(pos, um, m)) break; // stop at the first illegal move
+                pos.do_move(m);
+            }
+        }
+    }
+
+    // "setoption name <id> [value <x>]"
+    void set_option(const std::string& cmd) {
+        size_t n = cmd.find(" name "), v = cmd.find(" value ");
+        if (n == std::string::npos) return;
+        std::string name = cmd.substr(n + 6, v == std::string::npos ? std::string::npos : v - n - 6);
+        std::string value = v == std::string::npos ? "" : cmd.substr(v + 7);
+        while (!name.empty() && name.back() == ' ') name.pop_back();
+        if (name == "SyzygyPath") {
+            int n = tb::init(value);
+            std::cout << "info string found " << n << " tablebase files, up to " << tb::max_pieces() << " pieces" << std::endl;
+        }
+        else if (name == "SyzygyProbeDepth") tb_probe_depth = std::max(1, std::atoi(value.c_str()));
+        else if (name == "OwnBook") own_book = (value == "true");
+        else if (name == "BookBestMove") book_best = (value == "true");
+        else if (name == "BookFile") {
+            book.close();
+            if (value.empty() || value == "<empty>") return;
+            if (!book.open(value)) { std::cout << "info string cannot open book " << value << std::endl; return; }
+            std::cout << "info string book " << value << ": " << book.size() << " entries" << std::endl;
+            if (!book_keys)
+                std::cout << "info string set PolyglotKeys to the reference Random64 table to use the book" << std::endl;
+        }
+        else if (name == "PolyglotKeys") {
+            MappedFile f;
+            const bool loaded = f.open(value) && load_polyglot_random64(f.view());
+            book_keys = polyglot_keys_standard();
+            std::cout << "info string " << (loaded ? "reference Polyglot keys loaded from " : "no reference Random64 table in ")
+                      << value << std::endl;
         }
     }
 
     void go(const std::string& cmd) {
+        if (own_book && book_keys && book.is_open()) {
+            Move bm = book.pick(pos, book_best ? BookPick::Best : BookPick::Weighted, rng());
+            if (bm.v) {
+                std::cout << "info string book move\nbestmove " << to_uci(bm) << std::endl;
+                return;
+            }
+        }
         thinking = true;
-        int depth = strat.max_depth;
-        int movetime_ms = -1;
+        SearchLimits lim;
+        lim.depth = -1;
         {
             std::istringstream ss(cmd);
             std::string tok; ss >> tok;
             while (ss >> tok) {
-                if (tok == "depth") { ss >> depth; }
-                else if (tok == "movetime") { ss >> movetime_ms; }
+                if (tok == "depth") { ss >> lim.depth; }
+                else if (tok == "nodes") { ss >> lim.nodes; if (!lim.nodes) lim.nodes = 1; }
+                else if (tok == "movetime") { ss >> lim.movetime_ms; if (!lim.movetime_ms) lim.movetime_ms = 1; }
             }
         }
-        strat.max_depth = std::max(1, depth);
-        std::string best = strat.select_move(game);
-        if (best.empty()) std::cout << "bestmove 0000\n";
-        else              std::cout << "bestmove " << engine_move_to_uci(best) << "\n";
+        // "go nodes N" / "go movetime MS": the budget decides the depth
+        if (lim.depth < 0) lim.depth = (lim.nodes || lim.movetime_ms) ? MAX_PLY - 1 : depth;
+        lim.depth = std::max(1, lim.depth);
+        lim.tb_probe_depth = tb_probe_depth;
+        auto t0 = std::chrono::steady_clock::now();
+        SearchResult r = search_position(pos, lim);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "info depth " << r.depth << " score cp " << r.score << " nodes " << r.nodes
+                  << " time " << ms << " nps " << (ms > 0 ? r.nodes * 1000 / ms : r.nodes) << " tbhits " << r.tbhits;
+        if (!r.pv.empty()) {
+            std::cout << " pv";
+            for (Move m : r.pv) std::cout << ' ' << to_uci(m);
+        }
+        std::cout << "\n";
+        if (SEARCH_STATS_ENABLED) write_stats(std::cout, r.stats, "info string ");
+        if (r.best.v == 0) std::cout << "bestmove 0000\n";
+        else               std::cout << "bestmove " << to_uci(r.best) << "\n";
         std::cout.flush();
         thinking = false;
     }
 };
 
-int main() {
+static void bench(int depth) {
+    BenchResult r = run_bench(depth, &std::cerr);
+    std::cerr << "===========================\n"
+              << "Positions      : " << r.positions << "\n"
+              << "Depth          : " << depth << "\n"
+              << "Total time (ms): " << (uint64_t)r.ms << "\n"
+              << "Nodes searched : " << r.nodes << "\n"
+              << "Nodes/second   : " << r.nps << "\n"
+              << "Move plumbing  : " << (COPY_MAKE_ENABLED ? "copy-make" : "make/unmake") << "\n";
+    if (SEARCH_STATS_ENABLED) write_stats(std::cerr, r.stats);
+    std::cout << "signature " << std::hex << r.signature << std::dec << " nodes " << r.nodes << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        bench(argc > 2 ? std::max(1, std::atoi(argv[2])) : BENCH_DEPTH);
+        return 0;
+    }
+
+    init_attacks();
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
     std::cout.setf(std::ios::unitbuf);
@@ -101,16 +189,29 @@ int main() {
         if (line == "uci") {
             std::cout << "id name MyEngine\n";
             std::cout << "id author You\n";
+            std::cout << "option name OwnBook type check default false\n";
+            std::cout << "option name BookFile type string default <empty>\n";
+            std::cout << "option name BookBestMove type check default false\n";
+            std::cout << "option name PolyglotKeys type string default <empty>\n";
+            std::cout << "option name SyzygyPath type string default <empty>\n";
+            std::cout << "option name SyzygyProbeDepth type spin default 1 min 1 max 100\n";
             std::cout << "uciok\n";
         } else if (line == "isready") {
+            bitbase::init(); // long initialisation belongs before readyok
             std::cout << "readyok\n";
         } else if (line.rfind("setoption", 0) == 0) {
+            E.set_option(line);
         } else if (line == "ucinewgame") {
             E.new_game();
         } else if (line.rfind("position", 0) == 0) {
             E.set_position_from_cmd(line);
         } else if (line.rfind("go", 0) == 0) {
             E.go(line);
+        } else if (line.rfind("bench", 0) == 0) {
+            std::istringstream ss(line);
+            std::string tok; int depth = BENCH_DEPTH;
+            ss >> tok >> depth;
+            bench(std::max(1, depth));
         } else if (line == "stop") {
         } else if (line == "quit") {
             break;